@@ -41,7 +41,7 @@
 
 #include "shared.h"
 
-static struct
+static THREAD_LOCAL struct
 {
   uint8 enabled;
   uint16 regs[0x20];
@@ -339,13 +339,13 @@
 }
 
 
-static ssp1601_t *ssp = NULL;
-static unsigned short *PC;
-static int g_cycles;
+static THREAD_LOCAL ssp1601_t *ssp = NULL;
+static THREAD_LOCAL unsigned short *PC;
+static THREAD_LOCAL int g_cycles;
 
 #ifdef USE_DEBUGGER
 static int running = 0;
-static int last_iram = 0;
+static THREAD_LOCAL int last_iram = 0;
 #endif
 
 /* ----------------------------------------------------- */
@@ -968,6 +968,433 @@ static u32 ptr2_read(int op)
   return ((unsigned short *)svp->iram_rom)[mv];
 }
 
+#ifdef USE_SSP_DECODE_CACHE
+/* ----------------------------------------------------- */
+/* pre-decoded instructions */
+
+/* Decoding only depends on opcode value (immediate operands are still fetched
+   at execution), so instructions are pre-decoded once per opcode value: IRAM
+   code overwritten through PM registers or restored by savestates does not
+   need any invalidation. Register, pointer & condition fields and accumulator
+   operations are resolved when decoded. Most instructions accessing special
+   registers (except PC) through handlers, and a few rarely used ones, are not
+   decoded and are executed by the interpreter. */
+
+#define SSP_ALU_KINDS(k) k##_SUB, k##_CMP, k##_ADD, k##_AND, k##_OR, k##_EOR
+
+/* decoded instruction kinds */
+enum {
+  SSP_OP_UNDECODED = 0,
+  SSP_OP_INTERPRETED,             /* executed by interpreter */
+  SSP_OP_NOP,                     /* nop, ld -, s */
+  SSP_OP_LD_R_R,                  /* ld d, s */
+  SSP_OP_LD_REG,                  /* ld d, s (special registers) */
+  SSP_OP_LD_A_P,                  /* ld A, P */
+  SSP_OP_LD_R_PTR,                /* ld d, (ri) */
+  SSP_OP_LD_PTR_R,                /* ld (ri), s */
+  SSP_OP_LDI_R,                   /* ldi d, imm */
+  SSP_OP_LDI_REG,                 /* ldi d, imm (special registers) */
+  SSP_OP_LDI_PTR,                 /* ldi (ri), imm */
+  SSP_OP_LD_ADR_A,                /* ld adr, a */
+  SSP_OP_LD_R_RI,                 /* ld d, ri */
+  SSP_OP_LD_RI_R,                 /* ld ri, s */
+  SSP_OP_LDI_RI,                  /* ldi ri, simm */
+  SSP_OP_LD_R_IND_A,              /* ld d, (a) */
+  SSP_OP_CALL,                    /* call cond, addr */
+  SSP_OP_BRA,                     /* bra cond, addr */
+  SSP_OP_SKIP,                    /* call/bra cond, addr (condition never true) */
+  SSP_OP_MPYS,                    /* mpys (rj), (ri), b */
+  SSP_OP_MPYA,                    /* mpya (rj), (ri), b */
+  SSP_OP_MLD,                     /* mld (rj), (ri), b */
+  SSP_OP_LD_A_ADR,                /* ld a, adr */
+  SSP_ALU_KINDS(SSP_OP_ALU_R),    /* OP a, s */
+  SSP_ALU_KINDS(SSP_OP_ALU_A),    /* OP a, A (32-bit) */
+  SSP_ALU_KINDS(SSP_OP_ALU_P),    /* OP a, P (32-bit) */
+  SSP_ALU_KINDS(SSP_OP_ALU_PTR),  /* OP a, (ri) */
+  SSP_ALU_KINDS(SSP_OP_ALU_ADR),  /* OP a, adr */
+  SSP_ALU_KINDS(SSP_OP_ALU_IMM),  /* OP a, imm */
+  SSP_ALU_KINDS(SSP_OP_ALU_RI),   /* OP a, ri */
+  SSP_ALU_KINDS(SSP_OP_ALU_SIMM)  /* OP simm */
+};
+
+/* accumulator operation (sub, cmp, add, and, or, eor), indexed by op >> 13 */
+static const unsigned char ssp_alu_index[8] = {0, 0, 0, 1, 2, 3, 4, 5};
+
+typedef struct
+{
+  unsigned short addr;   /* RAM bank offset, or fixed RAM address */
+  unsigned char ri;      /* pointer register index */
+  unsigned char mask;    /* pointer register mask (zero for fixed RAM address) */
+  signed char inc;       /* pointer register post-increment */
+  unsigned char modulo;  /* post-increment is modulo ST loop size */
+} ssp_ptr_t;
+
+typedef struct
+{
+  unsigned char kind;        /* decoded instruction kind */
+  unsigned char d;           /* destination register or pointer register index */
+  unsigned char s;           /* source register or pointer register index */
+  unsigned short cond_mask;  /* ST flags checked by condition */
+  unsigned short cond_val;   /* ST flags value for which condition is true */
+  ssp_ptr_t ptr[2];          /* (ri) and (rj) operands */
+} ssp_decoded_op;
+
+static THREAD_LOCAL ssp_decoded_op ssp_decoded[0x10000];
+static THREAD_LOCAL int ssp_decode_disabled;
+
+void ssp1601_decode_cache_enable(int enable)
+{
+  /* decoded instructions remain valid while disabled */
+  ssp_decode_disabled = !enable;
+}
+
+static void ssp_decode_ptr(ssp_ptr_t *ptr, int ri, int isj2, int modi3, int write)
+{
+  ptr->ri = ri | isj2;
+  ptr->addr = isj2 ? 256 : 0;
+  ptr->mask = 0xff;
+  ptr->inc = 0;
+  ptr->modulo = 0;
+
+  if (ri == 3)
+  {
+    /* fixed RAM address */
+    ptr->addr += modi3 >> 3;
+    ptr->mask = 0;
+    return;
+  }
+
+  switch (modi3)
+  {
+    case 0x00: break;                                    /* (ri) */
+    case 0x08: ptr->inc = 1; break;                      /* (ri+!) */
+    case 0x10: ptr->inc = -1; ptr->modulo = !write; break; /* (ri-) */
+    default:   ptr->inc = 1; ptr->modulo = !write; break;  /* (ri+) */
+  }
+}
+
+static void ssp_decode_cond(ssp_decoded_op *d, int op, int kind)
+{
+  d->kind = kind;
+  switch (op & 0xf0)
+  {
+    case 0x00: d->cond_mask = 0; d->cond_val = 0; break;
+    case 0x50: d->cond_mask = SSP_FLAG_Z; d->cond_val = (op << 5) & SSP_FLAG_Z; break;
+    case 0x70: d->cond_mask = SSP_FLAG_N; d->cond_val = (op << 7) & SSP_FLAG_N; break;
+    default:   d->kind = SSP_OP_SKIP; break;
+  }
+}
+
+static void ssp_decode(ssp_decoded_op *d, int op)
+{
+  int dst = (op & 0xf0) >> 4;
+  int src = op & 0x0f;
+  int alu = ssp_alu_index[op >> 13];
+
+  /* interpreted by default */
+  d->kind = SSP_OP_INTERPRETED;
+  d->d = dst;
+  d->s = src;
+
+  switch (op >> 9)
+  {
+    case 0x00:
+      if (op == ((SSP_A<<4)|SSP_P)) d->kind = SSP_OP_LD_A_P;
+      else if ((src <= 4) && (dst < 4)) d->kind = dst ? SSP_OP_LD_R_R : SSP_OP_NOP;
+      else if ((src != SSP_PC) && (dst != SSP_PC)) d->kind = SSP_OP_LD_REG;
+      break;
+
+    case 0x01:
+      if ((dst > 0) && (dst < 4)) d->kind = SSP_OP_LD_R_PTR;
+      ssp_decode_ptr(&d->ptr[0], op&3, (op>>6)&4, (op<<1)&0x18, 0);
+      break;
+
+    case 0x02:
+      if (dst <= 4) d->kind = SSP_OP_LD_PTR_R;
+      ssp_decode_ptr(&d->ptr[0], op&3, (op>>6)&4, (op<<1)&0x18, 1);
+      break;
+
+    case 0x04:
+      if ((dst > 0) && (dst < 4)) d->kind = SSP_OP_LDI_R;
+      else if (dst != SSP_PC) d->kind = SSP_OP_LDI_REG;
+      break;
+
+    case 0x06:
+      d->kind = SSP_OP_LDI_PTR;
+      ssp_decode_ptr(&d->ptr[0], op&3, (op>>6)&4, (op<<1)&0x18, 1);
+      break;
+
+    case 0x07:
+      d->kind = SSP_OP_LD_ADR_A;
+      break;
+
+    case 0x09:
+      if ((dst > 0) && (dst < 4)) d->kind = SSP_OP_LD_R_RI;
+      d->s = IJind;
+      break;
+
+    case 0x0a:
+      if (dst <= 4) d->kind = SSP_OP_LD_RI_R;
+      d->d = IJind;
+      d->s = dst;
+      break;
+
+    case 0x0c:
+    case 0x0d:
+    case 0x0e:
+    case 0x0f:
+      d->kind = SSP_OP_LDI_RI;
+      d->d = (op>>8)&7;
+      break;
+
+    case 0x24:
+      ssp_decode_cond(d, op, SSP_OP_CALL);
+      break;
+
+    case 0x25:
+      if ((dst > 0) && (dst < 4)) d->kind = SSP_OP_LD_R_IND_A;
+      break;
+
+    case 0x26:
+      ssp_decode_cond(d, op, SSP_OP_BRA);
+      break;
+
+    case 0x1b:
+    case 0x4b:
+    case 0x5b:
+      d->kind = (op >> 9 == 0x1b) ? SSP_OP_MPYS : ((op >> 9 == 0x4b) ? SSP_OP_MPYA : SSP_OP_MLD);
+      ssp_decode_ptr(&d->ptr[0], op&3, 0, (op<<1)&0x18, 0);
+      ssp_decode_ptr(&d->ptr[1], (op>>4)&3, 4, (op>>3)&0x18, 0);
+      break;
+
+    case 0x10: case 0x30: case 0x40: case 0x50: case 0x60: case 0x70:
+      if (src == SSP_P) d->kind = SSP_OP_ALU_P_SUB + alu;
+      else if (src == SSP_A) d->kind = SSP_OP_ALU_A_SUB + alu;
+      else if (src <= 4) d->kind = SSP_OP_ALU_R_SUB + alu;
+      break;
+
+    case 0x11: case 0x31: case 0x41: case 0x51: case 0x61: case 0x71:
+      d->kind = SSP_OP_ALU_PTR_SUB + alu;
+      ssp_decode_ptr(&d->ptr[0], op&3, (op>>6)&4, (op<<1)&0x18, 0);
+      break;
+
+    case 0x03:
+      d->kind = SSP_OP_LD_A_ADR;
+      break;
+
+    case 0x13: case 0x33: case 0x43: case 0x53: case 0x63: case 0x73:
+      d->kind = SSP_OP_ALU_ADR_SUB + alu;
+      break;
+
+    case 0x14: case 0x34: case 0x44: case 0x54: case 0x64: case 0x74:
+      d->kind = SSP_OP_ALU_IMM_SUB + alu;
+      break;
+
+    case 0x19: case 0x39: case 0x49: case 0x59: case 0x69: case 0x79:
+      d->kind = SSP_OP_ALU_RI_SUB + alu;
+      d->s = IJind;
+      break;
+
+    case 0x1c: case 0x3c: case 0x4c: case 0x5c: case 0x6c: case 0x7c:
+      d->kind = SSP_OP_ALU_SIMM_SUB + alu;
+      break;
+  }
+}
+
+INLINE u32 ssp_ptr_read(const ssp_ptr_t *ptr)
+{
+  unsigned char *rp = &rIJ[ptr->ri];
+  u32 r = *rp;
+  u32 d = ssp->mem.RAM[ptr->addr + (r & ptr->mask)];
+
+  if (ptr->modulo && (rST&7))
+  {
+    u32 mask = (1 << (rST&7)) - 1;
+    *rp = (r & ~mask) | ((r + ptr->inc) & mask);
+  }
+  else
+  {
+    *rp = r + ptr->inc;
+  }
+
+  return d;
+}
+
+INLINE void ssp_ptr_write(const ssp_ptr_t *ptr, u32 d)
+{
+  unsigned char *rp = &rIJ[ptr->ri];
+  u32 r = *rp;
+
+  ssp->mem.RAM[ptr->addr + (r & ptr->mask)] = d;
+  *rp = r + ptr->inc;
+}
+
+/* accumulator operations with 32-bit operand */
+#define SSP_ALU_CASES(k, x) \
+      case k##_SUB: OP_SUBA32(x); break; \
+      case k##_CMP: OP_CMPA32(x); break; \
+      case k##_ADD: OP_ADDA32(x); break; \
+      case k##_AND: OP_ANDA32(x); break; \
+      case k##_OR:  OP_ORA32(x);  break; \
+      case k##_EOR: OP_EORA32(x); break;
+
+/* execute pre-decoded instructions until next one to be interpreted, returns
+   zero once all cycles have been executed. PC and remaining cycles are kept
+   locally and updated before returning to the interpreter */
+static int ssp1601_run_decoded(void)
+{
+  unsigned short *base = (unsigned short *)svp->iram_rom;
+  unsigned short *pc = PC;
+  int cycles = g_cycles;
+
+  for (;;)
+  {
+    int op = *pc;
+    ssp_decoded_op *d = &ssp_decoded[op];
+
+    if (d->kind == SSP_OP_UNDECODED)
+    {
+      ssp_decode(d, op);
+    }
+
+    if (d->kind == SSP_OP_INTERPRETED)
+    {
+      PC = pc;
+      g_cycles = cycles;
+      return 1;
+    }
+
+    pc++;
+
+    switch (d->kind)
+    {
+      case SSP_OP_NOP:
+        break;
+
+      case SSP_OP_LD_R_R:
+        ssp->gr[d->d].byte.h = ssp->gr[d->s].byte.h;
+        break;
+
+      case SSP_OP_LD_REG:
+      case SSP_OP_LDI_REG:
+      {
+        /* register handlers may access current PC and set wait status */
+        u32 tmpv;
+        PC = (d->kind == SSP_OP_LDI_REG) ? (pc + 1) : pc;
+        tmpv = (d->kind == SSP_OP_LDI_REG) ? *pc : REG_READ(d->s);
+        REG_WRITE(d->d, tmpv);
+        pc = PC;
+        if (ssp->emu_status & SSP_WAIT_MASK)
+        {
+          g_cycles = cycles - 1;
+          return 0;
+        }
+        break;
+      }
+
+      case SSP_OP_LD_A_P:
+        read_P(); /* update P */
+        rA32 = rP.v;
+        break;
+
+      case SSP_OP_LD_R_PTR:
+        ssp->gr[d->d].byte.h = ssp_ptr_read(&d->ptr[0]);
+        break;
+
+      case SSP_OP_LD_PTR_R:
+        ssp_ptr_write(&d->ptr[0], ssp->gr[d->d].byte.h);
+        break;
+
+      case SSP_OP_LDI_R:
+        ssp->gr[d->d].byte.h = *pc++;
+        break;
+
+      case SSP_OP_LDI_PTR:
+        ssp_ptr_write(&d->ptr[0], *pc++);
+        break;
+
+      case SSP_OP_LD_ADR_A:
+        ssp->mem.RAM[op & 0x1ff] = rA;
+        break;
+
+      case SSP_OP_LD_R_RI:
+        ssp->gr[d->d].byte.h = rIJ[d->s];
+        break;
+
+      case SSP_OP_LD_RI_R:
+        rIJ[d->d] = ssp->gr[d->s].byte.h;
+        break;
+
+      case SSP_OP_LDI_RI:
+        rIJ[d->d] = op;
+        break;
+
+      case SSP_OP_LD_R_IND_A:
+        ssp->gr[d->d].byte.h = base[rA];
+        break;
+
+      case SSP_OP_CALL:
+        if (!((rST ^ d->cond_val) & d->cond_mask)) { int new_PC = *pc++; write_STACK(pc - base); pc = base + new_PC; cycles--; }
+        else pc++;
+        break;
+
+      case SSP_OP_BRA:
+        if (!((rST ^ d->cond_val) & d->cond_mask)) { pc = base + *pc; cycles--; }
+        else pc++;
+        break;
+
+      case SSP_OP_SKIP:
+        pc++;
+        break;
+
+      case SSP_OP_MPYS:
+        read_P(); /* update P */
+        rA32 -= rP.v;
+        UPD_ACC_ZN
+        rX = ssp_ptr_read(&d->ptr[0]);
+        rY = ssp_ptr_read(&d->ptr[1]);
+        break;
+
+      case SSP_OP_MPYA:
+        read_P(); /* update P */
+        rA32 += rP.v;
+        UPD_ACC_ZN
+        rX = ssp_ptr_read(&d->ptr[0]);
+        rY = ssp_ptr_read(&d->ptr[1]);
+        break;
+
+      case SSP_OP_MLD:
+        rA32 = 0;
+        rST &= 0x0fff;
+        rX = ssp_ptr_read(&d->ptr[0]);
+        rY = ssp_ptr_read(&d->ptr[1]);
+        break;
+
+      case SSP_OP_LD_A_ADR:
+        rA = ssp->mem.RAM[op & 0x1ff];
+        break;
+
+      SSP_ALU_CASES(SSP_OP_ALU_R, (u32)ssp->gr[d->s].byte.h << 16)
+      SSP_ALU_CASES(SSP_OP_ALU_A, rA32)
+      SSP_ALU_CASES(SSP_OP_ALU_P, (read_P(), rP.v))
+      SSP_ALU_CASES(SSP_OP_ALU_PTR, ssp_ptr_read(&d->ptr[0]) << 16)
+      SSP_ALU_CASES(SSP_OP_ALU_ADR, (u32)ssp->mem.RAM[op & 0x1ff] << 16)
+      SSP_ALU_CASES(SSP_OP_ALU_IMM, (u32)*pc++ << 16)
+      SSP_ALU_CASES(SSP_OP_ALU_RI, (u32)rIJ[d->s] << 16)
+      SSP_ALU_CASES(SSP_OP_ALU_SIMM, (u32)(op & 0xff) << 16)
+    }
+
+    /* wait status was already checked after register handlers */
+    if (--cycles <= 0)
+    {
+      PC = pc;
+      g_cycles = cycles;
+      return 0;
+    }
+  }
+}
+#endif
+
 
 /* ----------------------------------------------------- */
 
@@ -1085,6 +1512,10 @@ static void debug(unsigned int pc, unsigned int op)
 
 void ssp1601_run(int cycles)
 {
+#ifdef USE_SSP_DECODE_CACHE
+  int decoded = !ssp_decode_disabled;
+#endif
+
   SET_PC(rPC);
   g_cycles = cycles;
 
@@ -1093,6 +1524,9 @@ void ssp1601_run(int cycles)
     int op;
     u32 tmpv;
 
+#ifdef USE_SSP_DECODE_CACHE
+    if (decoded && !ssp1601_run_decoded()) break;
+#endif
     op = *PC++;
 #ifdef USE_DEBUGGER
     debug(GET_PC()-1, op);
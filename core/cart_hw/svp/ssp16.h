@@ -76,4 +76,10 @@ typedef struct
 void ssp1601_reset(ssp1601_t *ssp);
 void ssp1601_run(int cycles);
 
+#ifdef USE_SSP_DECODE_CACHE
+void ssp1601_decode_cache_enable(int enable);
+#else
+#define ssp1601_decode_cache_enable(enable)
+#endif
+
 #endif
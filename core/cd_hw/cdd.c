@@ -35,9 +35,23 @@
  *  POSSIBILITY OF SUCH DAMAGE.
  *
  ****************************************************************************************/
+#if defined(USE_CDD_PREFETCH) || defined(USE_CDD_MMAP)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
 #include "shared.h"
 #include "megasd.h"
 
+#ifdef USE_CDD_PREFETCH
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#ifdef USE_CDD_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #if defined(USE_LIBTREMOR) || defined(USE_LIBVORBIS)
 #define SUPPORTED_EXT 20
 #else
@@ -47,6 +61,10 @@
 /* CD blocks scanning speed */
 #define CD_SCAN_SPEED 30
 
+/* CD image read streams */
+#define STREAM_DATA  0
+#define STREAM_AUDIO 1
+
 /* CD tracks type (CD-DA by default) */
 #define TYPE_AUDIO 0x00
 #define TYPE_MODE1 0x01
@@ -186,6 +204,473 @@ static void ogg_free(int i)
 
 #endif
 
+#ifdef USE_CDD_PREFETCH
+
+/*--------------------------------------------------------------------------*/
+/* CD image read-ahead cache                                                */
+/*--------------------------------------------------------------------------*/
+
+/* CD-ROM data and CD-DA audio are read from a cache of fixed-size blocks   */
+/* (BIN/ISO/WAV file blocks, CHD hunks or decoded VORBIS audio blocks). A   */
+/* worker thread fills the cache with the blocks following last data and    */
+/* audio read positions, so that sequential reads usually do not wait for   */
+/* file access, decompression or decoding. CD image files are only accessed */
+/* by block reads (worker thread or emulation thread cache miss), with      */
+/* cdd_cache_io locked: emulation thread only tracks CD-DA read offset.     */
+
+/* cached block size (16 CHD frames of 2352 bytes sector data + 96 bytes subcode data) */
+#define CDD_CACHE_BLOCK (16 * (2352 + 96))
+
+/* cached blocks */
+#define CDD_CACHE_SLOTS 32
+
+/* blocks read ahead of last data & audio read positions */
+#define CDD_CACHE_AHEAD 8
+
+/* cached block source type */
+#define CACHE_FILE 0
+#define CACHE_CHD  1
+#define CACHE_OGG  2
+
+/* cached block state */
+#define CACHE_EMPTY   0
+#define CACHE_LOADING 1
+#define CACHE_VALID   2
+
+typedef struct
+{
+  int type;           /* source type */
+  void *src;          /* source (cdStream, chd_file or OggVorbis_File) */
+  unsigned int block; /* block index in source */
+  int state;          /* block state */
+  int length;         /* valid bytes (less than block size at end of source) */
+  uint32 used;        /* last access stamp */
+} t_cdd_cache_slot;
+
+static struct
+{
+  int running;        /* worker thread started */
+  int quit;           /* worker thread exit requested */
+  uint32 stamp;       /* block access stamp */
+  uint32 generation;  /* cache flush count */
+  struct
+  {
+    int type;
+    void *src;
+    unsigned int block;
+  } hint[2];          /* last block read by data & audio streams */
+  t_cdd_cache_slot slots[CDD_CACHE_SLOTS];
+} cdd_cache;
+
+static uint8 cdd_cache_data[CDD_CACHE_SLOTS][CDD_CACHE_BLOCK];
+
+t_cdd_cache_stats cdd_cache_stats;
+
+static pthread_t cdd_cache_id;
+static pthread_mutex_t cdd_cache_io = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t cdd_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cdd_cache_wake = PTHREAD_COND_INITIALIZER;
+
+static double cdd_cache_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+static int cdd_cache_block_size(int type, void *src)
+{
+#if defined(USE_LIBCHDR)
+  if (type == CACHE_CHD)
+  {
+    return chd_get_header((chd_file *)src)->hunkbytes;
+  }
+#endif
+  return CDD_CACHE_BLOCK;
+}
+
+/* read block from source (cdd_cache_io locked), returns valid bytes */
+static int cdd_cache_fill(int type, void *src, unsigned int block, uint8 *dst, int size)
+{
+#if defined(USE_LIBCHDR)
+  if (type == CACHE_CHD)
+  {
+    chd_read((chd_file *)src, block, dst);
+    return size;
+  }
+#endif
+#if defined(USE_LIBTREMOR) || defined(USE_LIBVORBIS)
+  if (type == CACHE_OGG)
+  {
+    OggVorbis_File *vf = (OggVorbis_File *)src;
+    ogg_int64_t pos = (ogg_int64_t)block * (size / 4);
+    int len, done = 0;
+
+    /* consecutive blocks are decoded without seeking */
+    if ((ov_pcm_tell(vf) != pos) && ov_pcm_seek(vf, pos))
+    {
+      return 0;
+    }
+
+    while (done < size)
+    {
+#ifdef USE_LIBVORBIS
+      len = ov_read(vf, (char *)(dst + done), size - done, 0, 2, 1, 0);
+#else
+      len = ov_read(vf, (char *)(dst + done), size - done, 0);
+#endif
+      if (len <= 0)
+      {
+        break;
+      }
+      done += len;
+    }
+
+    return done;
+  }
+#endif
+
+  cdStreamSeek((cdStream *)src, (long)block * size, SEEK_SET);
+  return cdStreamRead(dst, 1, size, (cdStream *)src);
+}
+
+/* find cached (or loading) block (cdd_cache_mutex locked) */
+static t_cdd_cache_slot *cdd_cache_find(int type, void *src, unsigned int block)
+{
+  int i;
+
+  for (i=0; i<CDD_CACHE_SLOTS; i++)
+  {
+    t_cdd_cache_slot *slot = &cdd_cache.slots[i];
+    if (slot->state && (slot->block == block) && (slot->src == src) && (slot->type == type))
+    {
+      return slot;
+    }
+  }
+
+  return NULL;
+}
+
+/* read block into least recently used slot (cdd_cache_mutex locked, released during read) */
+static void cdd_cache_load(int type, void *src, unsigned int block)
+{
+  int i, size;
+  uint32 generation = cdd_cache.generation;
+  t_cdd_cache_slot *slot = NULL;
+
+  for (i=0; i<CDD_CACHE_SLOTS; i++)
+  {
+    if (cdd_cache.slots[i].state == CACHE_EMPTY)
+    {
+      slot = &cdd_cache.slots[i];
+      break;
+    }
+
+    if ((cdd_cache.slots[i].state == CACHE_VALID) && (!slot || ((int32)(cdd_cache.slots[i].used - slot->used) < 0)))
+    {
+      slot = &cdd_cache.slots[i];
+    }
+  }
+
+  slot->type = type;
+  slot->src = src;
+  slot->block = block;
+  slot->state = CACHE_LOADING;
+  slot->used = ++cdd_cache.stamp;
+  pthread_mutex_unlock(&cdd_cache_mutex);
+
+  /* CD image files are closed once cache has been flushed */
+  pthread_mutex_lock(&cdd_cache_io);
+  pthread_mutex_lock(&cdd_cache_mutex);
+  if (generation == cdd_cache.generation)
+  {
+    pthread_mutex_unlock(&cdd_cache_mutex);
+    size = cdd_cache_fill(type, src, block, cdd_cache_data[slot - cdd_cache.slots], cdd_cache_block_size(type, src));
+    pthread_mutex_lock(&cdd_cache_mutex);
+    slot->length = size;
+    slot->state = CACHE_VALID;
+  }
+  pthread_mutex_unlock(&cdd_cache_io);
+
+  pthread_cond_broadcast(&cdd_cache_wake);
+}
+
+static void *cdd_cache_main(void *arg)
+{
+  pthread_mutex_lock(&cdd_cache_mutex);
+
+  while (!cdd_cache.quit)
+  {
+    int i, ahead;
+    int loaded = 0;
+
+    /* read nearest missing block following last data & audio read positions */
+    for (ahead=1; (ahead<=CDD_CACHE_AHEAD) && !loaded; ahead++)
+    {
+      for (i=0; (i<2) && !loaded; i++)
+      {
+        int type = cdd_cache.hint[i].type;
+        void *src = cdd_cache.hint[i].src;
+        unsigned int block = cdd_cache.hint[i].block + ahead;
+
+        if (src && !cdd_cache_find(type, src, block))
+        {
+          cdd_cache_load(type, src, block);
+          cdd_cache_stats.prefetched++;
+          loaded = 1;
+        }
+      }
+    }
+
+    /* wait for next read position */
+    if (!loaded)
+    {
+      pthread_cond_wait(&cdd_cache_wake, &cdd_cache_mutex);
+    }
+  }
+
+  pthread_mutex_unlock(&cdd_cache_mutex);
+  return NULL;
+}
+
+/* read bytes from source at specified offset (emulation thread), returns bytes read */
+static int cdd_cache_read(int stream, int type, void *src, unsigned int offset, uint8 *dst, int length)
+{
+  int done = 0;
+  int size = cdd_cache_block_size(type, src);
+  unsigned int block = offset / size;
+
+  /* CHD hunks larger than cached blocks are read directly */
+  if (size > CDD_CACHE_BLOCK)
+  {
+    pthread_mutex_lock(&cdd_cache_io);
+    cdd_cache_fill(type, src, block, dst, size);
+    pthread_mutex_unlock(&cdd_cache_io);
+    return length;
+  }
+
+  if (!cdd_cache.running)
+  {
+    cdd_cache.quit = 0;
+    cdd_cache.running = !pthread_create(&cdd_cache_id, NULL, cdd_cache_main, NULL);
+  }
+
+  pthread_mutex_lock(&cdd_cache_mutex);
+
+  while (done < length)
+  {
+    int pos, count;
+    t_cdd_cache_slot *slot;
+
+    block = (offset + done) / size;
+    pos = (offset + done) % size;
+    slot = cdd_cache_find(type, src, block);
+
+    if (slot && (slot->state == CACHE_VALID))
+    {
+      cdd_cache_stats.hits++;
+    }
+    else
+    {
+      double start = cdd_cache_time();
+
+      /* wait for block read by worker thread or read it now */
+      while (!slot || (slot->state != CACHE_VALID))
+      {
+        if (slot)
+        {
+          pthread_cond_wait(&cdd_cache_wake, &cdd_cache_mutex);
+        }
+        else
+        {
+          cdd_cache_load(type, src, block);
+        }
+
+        slot = cdd_cache_find(type, src, block);
+      }
+
+      cdd_cache_stats.misses++;
+      cdd_cache_stats.stall += cdd_cache_time() - start;
+    }
+
+    slot->used = ++cdd_cache.stamp;
+
+    count = slot->length - pos;
+    if (count > (length - done))
+    {
+      count = length - done;
+    }
+
+    if (count > 0)
+    {
+      memcpy(dst + done, cdd_cache_data[slot - cdd_cache.slots] + pos, count);
+      done += count;
+    }
+
+    /* end of source */
+    if (slot->length < size)
+    {
+      break;
+    }
+  }
+
+  /* update read-ahead position */
+  if ((cdd_cache.hint[stream].block != block) || (cdd_cache.hint[stream].src != src) || (cdd_cache.hint[stream].type != type))
+  {
+    cdd_cache.hint[stream].type = type;
+    cdd_cache.hint[stream].src = src;
+    cdd_cache.hint[stream].block = block;
+    pthread_cond_broadcast(&cdd_cache_wake);
+  }
+
+  pthread_mutex_unlock(&cdd_cache_mutex);
+
+  return done;
+}
+
+/* invalidate cached blocks before CD image files are closed */
+static void cdd_cache_flush(void)
+{
+  pthread_mutex_lock(&cdd_cache_io);
+  pthread_mutex_lock(&cdd_cache_mutex);
+  memset(cdd_cache.slots, 0, sizeof(cdd_cache.slots));
+  memset(cdd_cache.hint, 0, sizeof(cdd_cache.hint));
+  cdd_cache.generation++;
+  pthread_mutex_unlock(&cdd_cache_mutex);
+  pthread_mutex_unlock(&cdd_cache_io);
+}
+
+void cdd_cache_shutdown(void)
+{
+  if (cdd_cache.running)
+  {
+    pthread_mutex_lock(&cdd_cache_mutex);
+    cdd_cache.quit = 1;
+    pthread_cond_broadcast(&cdd_cache_wake);
+    pthread_mutex_unlock(&cdd_cache_mutex);
+    pthread_join(cdd_cache_id, NULL);
+    cdd_cache.running = 0;
+  }
+}
+
+#define cdd_chd_read(stream, hunknum) cdd_cache_read(stream, CACHE_CHD, cdd.chd.file, (hunknum) * cdd.chd.hunkbytes, cdd.chd.hunk, cdd.chd.hunkbytes)
+
+#else
+
+#define cdd_cache_flush()
+#define cdd_chd_read(stream, hunknum) chd_read(cdd.chd.file, hunknum, cdd.chd.hunk)
+
+#endif /* USE_CDD_PREFETCH */
+
+#ifdef USE_CDD_MMAP
+
+/*--------------------------------------------------------------------------*/
+/* Memory-mapped CD image files                                             */
+/*--------------------------------------------------------------------------*/
+
+/* Uncompressed track files (BIN/ISO/WAV) are mapped in memory once loaded, */
+/* so that sectors are read from the (shared) page cache without any file   */
+/* access, and CD-DA samples are processed directly from mapped memory.     */
+
+static void cdd_map_tracks(void)
+{
+  int i;
+  struct stat st;
+
+  for (i=0; i<cdd.toc.last; i++)
+  {
+    track_t *track = &cdd.toc.tracks[i];
+
+#if defined(USE_LIBTREMOR) || defined(USE_LIBVORBIS)
+    /* VORBIS files are decoded */
+    if (track->vf.datasource)
+    {
+      continue;
+    }
+#endif
+
+    if (track->fd)
+    {
+      /* check if single file is used for consecutive tracks */
+      if ((i > 0) && (track->fd == cdd.toc.tracks[i-1].fd))
+      {
+        track->map = cdd.toc.tracks[i-1].map;
+        track->mapSize = cdd.toc.tracks[i-1].mapSize;
+      }
+      else if (!fstat(fileno(track->fd), &st) && (st.st_size > 0) && (st.st_size <= 0xffffffff))
+      {
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fileno(track->fd), 0);
+        if (map != MAP_FAILED)
+        {
+          track->map = map;
+          track->mapSize = st.st_size;
+        }
+      }
+    }
+  }
+}
+
+static void cdd_unmap_tracks(void)
+{
+  int i;
+
+  for (i=0; i<cdd.toc.last; i++)
+  {
+    /* single file used for consecutive tracks is only unmapped once */
+    if (cdd.toc.tracks[i].map && ((i == 0) || (cdd.toc.tracks[i].map != cdd.toc.tracks[i-1].map)))
+    {
+      munmap(cdd.toc.tracks[i].map, cdd.toc.tracks[i].mapSize);
+    }
+  }
+}
+
+/* return mapped file data at specified offset if available (and 16-bit aligned) */
+static uint8 *cdd_map_data(track_t *track, unsigned int offset, int length)
+{
+  if (track->map && !(offset & 1) && (offset <= track->mapSize) && (length <= (track->mapSize - offset)))
+  {
+    return track->map + offset;
+  }
+
+  return NULL;
+}
+
+#else
+
+#define cdd_map_tracks()
+#define cdd_unmap_tracks()
+
+#endif /* USE_CDD_MMAP */
+
+/* read bytes from track file at specified offset, returns bytes read */
+static int cdd_file_read(int stream, track_t *track, unsigned int offset, uint8 *dst, int length)
+{
+#ifdef USE_CDD_MMAP
+  if (track->map)
+  {
+    /* stop at end of file */
+    if (offset >= track->mapSize)
+    {
+      return 0;
+    }
+    if (length > (track->mapSize - offset))
+    {
+      length = track->mapSize - offset;
+    }
+
+    memcpy(dst, track->map + offset, length);
+    return length;
+  }
+#endif
+
+#ifdef USE_CDD_PREFETCH
+  return cdd_cache_read(stream, CACHE_FILE, track->fd, offset, dst, length);
+#else
+  cdStreamSeek(track->fd, offset, SEEK_SET);
+  return cdStreamRead(dst, 1, length, track->fd);
+#endif
+}
+
 void cdd_init(int samplerate)
 {
   /* CD-DA is running by default at 44100 Hz */
@@ -243,14 +728,22 @@ int cdd_context_save(uint8 *state)
     if (cdd.toc.tracks[cdd.index].vf.seekable)
     {
       /* VORBIS file sample offset */
+#ifdef USE_CDD_PREFETCH
+      offset = cdd.audioOffset / 4;
+#else
       offset = ov_pcm_tell(&cdd.toc.tracks[cdd.index].vf);
+#endif
     }
     else
 #endif 
     if (cdd.toc.tracks[cdd.index].fd)
     {
       /* PCM file offset */
+#ifdef CDD_AUDIO_OFFSET
+      offset = cdd.audioOffset;
+#else
       offset = cdStreamTell(cdd.toc.tracks[cdd.index].fd);
+#endif
     }
   }
 
@@ -332,14 +825,22 @@ int cdd_context_load(uint8 *state, char *version)
       if (cdd.toc.tracks[index].vf.seekable)
       {
         /* VORBIS file sample offset */
+#ifdef USE_CDD_PREFETCH
+        cdd.audioOffset = offset * 4;
+#else
         ov_pcm_seek(&cdd.toc.tracks[index].vf, offset);
+#endif
       }
       else
 #endif 
       if (cdd.toc.tracks[index].fd)
       {
         /* PCM file offset */
+#ifdef CDD_AUDIO_OFFSET
+        cdd.audioOffset = offset;
+#else
         cdStreamSeek(cdd.toc.tracks[index].fd, offset, SEEK_SET);
+#endif
       }
     }
   }
@@ -1242,6 +1743,9 @@ int cdd_load(char *filename, char *header)
     /* CD mounted */
     cdd.loaded = isMSDfile ? HW_ADDON_MEGASD : HW_ADDON_MEGACD;
 
+    /* map uncompressed track files in memory */
+    cdd_map_tracks();
+
     /* Automatically try to open associated subcode data file */
     memcpy(&fname[strlen(fname) - 4], ".sub", 4);
     cdd.toc.sub = cdStreamOpen(fname);
@@ -1260,6 +1764,12 @@ void cdd_unload(void)
   {
     int i;
 
+    /* invalidate read-ahead cache */
+    cdd_cache_flush();
+
+    /* unmap memory-mapped files */
+    cdd_unmap_tracks();
+
 #if defined(USE_LIBCHDR)
     chd_close(cdd.chd.file);
     if (cdd.chd.hunk)
@@ -1330,7 +1840,7 @@ void cdd_read_data(uint8 *dst, uint8 *subheader)
       /* update CHD hunk cache if necessary */
       if (hunknum != cdd.chd.hunknum)
       {
-        chd_read(cdd.chd.file, hunknum, cdd.chd.hunk);
+        cdd_chd_read(STREAM_DATA, hunknum);
         cdd.chd.hunknum = hunknum;
       }
 
@@ -1366,8 +1876,7 @@ void cdd_read_data(uint8 *dst, uint8 *subheader)
     if (cdd.sectorSize == 2048)
     {
       /* read Mode 1 user data (2048 bytes) */
-      cdStreamSeek(cdd.toc.tracks[0].fd, cdd.lba * 2048, SEEK_SET);
-      cdStreamRead(dst, 2048, 1, cdd.toc.tracks[0].fd);
+      cdd_file_read(STREAM_DATA, &cdd.toc.tracks[0], cdd.lba * 2048, dst, 2048);
     }
     else
     {
@@ -1375,17 +1884,15 @@ void cdd_read_data(uint8 *dst, uint8 *subheader)
       if (!subheader)
       {
         /* skip block sync pattern (12 bytes) + block header (4 bytes) then read Mode 1 user data (2048 bytes) */
-        cdStreamSeek(cdd.toc.tracks[0].fd, (cdd.lba * 2352) + 12 + 4, SEEK_SET);
-        cdStreamRead(dst, 2048, 1, cdd.toc.tracks[0].fd);
+        cdd_file_read(STREAM_DATA, &cdd.toc.tracks[0], (cdd.lba * 2352) + 12 + 4, dst, 2048);
       }
       else
       {
         /* skip block sync pattern (12 bytes) + block header (4 bytes) + Mode 2 sub-header (first 4 bytes) then read Mode 2 sub-header (last 4 bytes) */
-        cdStreamSeek(cdd.toc.tracks[0].fd, (cdd.lba * 2352) + 12 + 4 + 4, SEEK_SET);
-        cdStreamRead(subheader, 4, 1, cdd.toc.tracks[0].fd);
+        cdd_file_read(STREAM_DATA, &cdd.toc.tracks[0], (cdd.lba * 2352) + 12 + 4 + 4, subheader, 4);
 
         /* read Mode 2 user data (max 2328 bytes) */
-        cdStreamRead(dst, 2328, 1, cdd.toc.tracks[0].fd);
+        cdd_file_read(STREAM_DATA, &cdd.toc.tracks[0], (cdd.lba * 2352) + 12 + 4 + 8, dst, 2328);
       }
     }
   }
@@ -1426,14 +1933,22 @@ void cdd_seek_audio(int index, int lba)
   if (cdd.toc.tracks[index].vf.seekable)
   {
     /* VORBIS AUDIO track */
+#ifdef USE_CDD_PREFETCH
+    cdd.audioOffset = ((lba * 588) - cdd.toc.tracks[index].offset) * 4;
+#else
     ov_pcm_seek(&cdd.toc.tracks[index].vf, (lba * 588) - cdd.toc.tracks[index].offset);
+#endif
   }
   else
 #endif 
   if (cdd.toc.tracks[index].fd)
   {
     /* PCM AUDIO track */
+#ifdef CDD_AUDIO_OFFSET
+    cdd.audioOffset = (lba * 2352) - cdd.toc.tracks[index].offset;
+#else
     cdStreamSeek(cdd.toc.tracks[index].fd, (lba * 2352) - cdd.toc.tracks[index].offset, SEEK_SET);
+#endif
   }
 }
 
@@ -1473,7 +1988,7 @@ void cdd_read_audio(unsigned int samples)
         /* update CHD hunk cache if necessary */
         if (hunknum != cdd.chd.hunknum)
         {
-          chd_read(cdd.chd.file, hunknum, cdd.chd.hunk);
+          cdd_chd_read(STREAM_AUDIO, hunknum);
           cdd.chd.hunknum = hunknum;
         }
 
@@ -1541,6 +2056,10 @@ void cdd_read_audio(unsigned int samples)
 #if defined(USE_LIBTREMOR) || defined(USE_LIBVORBIS)
     if (cdd.toc.tracks[cdd.index].vf.datasource)
     {
+#ifdef USE_CDD_PREFETCH
+      int16 *ptr = (int16 *) (cdc.ram);
+      cdd.audioOffset += cdd_cache_read(STREAM_AUDIO, CACHE_OGG, &cdd.toc.tracks[cdd.index].vf, cdd.audioOffset, cdc.ram, samples * 4);
+#else
       int len, done = 0;
       int16 *ptr = (int16 *) (cdc.ram);
       samples = samples * 4;
@@ -1559,6 +2078,7 @@ void cdd_read_audio(unsigned int samples)
         done += len;
       }
       samples = done / 4;
+#endif
 
       /* process 16-bit (host-endian) stereo samples */
       for (i=0; i<samples; i++)
@@ -1607,7 +2127,21 @@ void cdd_read_audio(unsigned int samples)
 #else
       uint8 *ptr = cdc.ram;
 #endif
+#ifdef USE_CDD_MMAP
+      /* process samples directly from mapped file when possible */
+      uint8 *data = cdd_map_data(&cdd.toc.tracks[cdd.index], cdd.audioOffset, samples * 4);
+      if (data)
+      {
+        ptr = (void *)data;
+        cdd.audioOffset += samples * 4;
+      }
+      else
+#endif
+#ifdef CDD_AUDIO_OFFSET
+      cdd.audioOffset += cdd_file_read(STREAM_AUDIO, &cdd.toc.tracks[cdd.index], cdd.audioOffset, cdc.ram, samples * 4);
+#else
       cdStreamRead(cdc.ram, 1, samples * 4, cdd.toc.tracks[cdd.index].fd);
+#endif
 
       /* process 16-bit (little-endian) stereo samples */
       for (i=0; i<samples; i++)
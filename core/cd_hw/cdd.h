@@ -83,6 +83,10 @@ typedef struct
   int type;
   int loopEnabled;
   int loopOffset;
+#ifdef USE_CDD_MMAP
+  uint8 *map;
+  unsigned int mapSize;
+#endif
 } track_t; 
 
 /* CD TOC */
@@ -106,6 +110,11 @@ typedef struct
 } chd_t;
 #endif
 
+/* CD-DA file read offset tracked by CD drive emulation (instead of file position) */
+#if defined(USE_CDD_PREFETCH) || defined(USE_CDD_MMAP)
+#define CDD_AUDIO_OFFSET
+#endif
+
 /* CDD hardware */
 typedef struct
 {
@@ -123,6 +132,9 @@ typedef struct
   chd_t chd;
 #endif
   int16 audio[2];
+#ifdef CDD_AUDIO_OFFSET
+  unsigned int audioOffset;
+#endif
 } cdd_t; 
 
 /* Function prototypes */
@@ -139,4 +151,28 @@ extern void cdd_update_audio(unsigned int samples);
 extern void cdd_update(void);
 extern void cdd_process(void);
 
+/* CD image blocks read ahead on a separate thread and served from memory (requires pthreads) */
+#ifdef USE_CDD_PREFETCH
+#ifdef USE_THREAD_LOCAL_CONTEXT
+#error "USE_CDD_PREFETCH cannot be combined with USE_THREAD_LOCAL_CONTEXT"
+#endif
+#ifdef DISABLE_MANY_OGG_OPEN_FILES
+#error "USE_CDD_PREFETCH cannot be combined with DISABLE_MANY_OGG_OPEN_FILES"
+#endif
+
+/* Read-ahead cache statistics (CD image blocks accessed by CD drive emulation) */
+typedef struct
+{
+  uint32 hits;
+  uint32 misses;
+  uint32 prefetched;
+  double stall;
+} t_cdd_cache_stats;
+
+extern t_cdd_cache_stats cdd_cache_stats;
+extern void cdd_cache_shutdown(void);
+#else
+#define cdd_cache_shutdown()
+#endif
+
 #endif
@@ -37,6 +37,15 @@
  ****************************************************************************************/
 #include "shared.h"
 
+/* Rotation / Scaling line renderer is inlined in each stamp map & stamp size configuration */
+#if defined(__GNUC__)
+#define GFX_INLINE static __inline__ __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define GFX_INLINE static __forceinline
+#else
+#define GFX_INLINE static
+#endif
+
 /***************************************************************/
 /*          WORD-RAM DMA interfaces (1M & 2M modes)            */
 /***************************************************************/
@@ -463,14 +472,59 @@ int gfx_context_load(uint8 *state)
   return bufferptr;
 }
 
-INLINE void gfx_render(uint32 bufferIndex, uint32 width)
+/* 4 pixels priority mode write (one Word-RAM access = 4 pixels of 4 bits) */
+/* mask = rendered pixels, other pixels of image buffer data are preserved */
+GFX_INLINE uint16 gfx_write(uint16 data_in, uint16 data_out, uint16 mask, int mode)
 {
-  uint8 pixel_in, pixel_out;
-  uint16 stamp_data;
-  uint32 stamp_index;
+  uint16 nz;
+
+  switch (mode)
+  {
+    case 0:
+      /* normal: rendered pixels are written */
+      return (data_in & ~mask) | data_out;
+
+    case 1:
+      /* underwrite: rendered pixels are only written over null pixels */
+      nz = data_in | (data_in >> 1) | (data_in >> 2) | (data_in >> 3);
+      nz = (nz & 0x1111) * 0x0f;
+      return data_in | (data_out & ~nz);
+
+    case 2:
+      /* overwrite: only non-null rendered pixels are written */
+      nz = data_out | (data_out >> 1) | (data_out >> 2) | (data_out >> 3);
+      nz = (nz & 0x1111) * 0x0f;
+      return (data_in & ~nz) | data_out;
+
+    default:
+      /* invalid: image buffer is not modified */
+      return data_in;
+  }
+}
+
+/* Render one image buffer line, with stamp map & stamp sizes as constant parameters  */
+/* so that a specialized renderer is compiled for each of the four configurations.     */
+/* Dots are rendered by groups of 4 (one Word-RAM access) then written to image buffer */
+/* at once. Image buffer data is written earlier if read back by the current group     */
+/* (stamp map or stamp pixel data), so output is identical to dot-by-dot processing.   */
+GFX_INLINE void gfx_render_line(uint32 bufferIndex, uint32 width, const uint32 dotMask, const int stampShift, const int mapShift)
+{
+  uint16 *image = (uint16 *)scd.word_ram_2M;
+  uint16 *dst, *map;
+  uint16 data, mask, stamp_data;
+  uint32 stamp_index, pixel, count, shift;
+
+  /* stamp size (0=16x16, 2=32x32) */
+  uint32 size = scd.regs[0x58>>1].byte.l & 0x02;
 
   /* bits [1:0] of 32x32 pixels stamp index are masked (see Chuck Rock II - Son of Chuck) */
-  uint32 stamp_mask = (scd.regs[0x58>>1].byte.l & 0x02) ? 0x7fc : 0x7ff;
+  uint32 stamp_mask = size ? 0x7fc : 0x7ff;
+
+  /* stamp map range if stamp map is repeated, 24-bit range otherwise */
+  uint32 pos_mask = (scd.regs[0x58>>1].byte.l & 0x01) ? dotMask : 0xffffff;
+
+  /* priority mode */
+  int mode = (scd.regs[0x02>>1].w >> 3) & 0x03;
 
   /* pixel map start position for current line (13.3 format converted to 13.11) */
   uint32 xpos = *gfx.tracePtr++ << 8;
@@ -481,101 +535,85 @@ INLINE void gfx_render(uint32 bufferIndex, uint32 width)
   uint32 yoffset = (int16) *gfx.tracePtr++;
 
   /* process all dots */
-  while (width--)
+  while (width)
   {
-    /* check if stamp map is repeated */
-    if (scd.regs[0x58>>1].byte.l & 0x01)
+    /* image buffer data (4 pixels) */
+    dst = &image[bufferIndex >> 2];
+    data = 0;
+    mask = 0;
+
+    /* first pixel position & number of dots within image buffer data */
+    shift = 12 - ((bufferIndex & 3) << 2);
+    count = 4 - (bufferIndex & 3);
+    if (count > width)
     {
-      /* stamp map range */
-      xpos &= gfx.dotMask;
-      ypos &= gfx.dotMask;
-    }
-    else
-    {
-      /* 24-bit range */
-      xpos &= 0xffffff;
-      ypos &= 0xffffff;
+      count = width;
     }
+    width -= count;
 
-    /* check if pixel is outside stamp map */
-    if ((xpos | ypos) & ~gfx.dotMask)
-    {
-      /* force pixel output to 0 */
-      pixel_out = 0x00;
-    }
-    else
+    /* last dot image buffer index */
+    bufferIndex += count - 1;
+
+    do
     {
-      /* read stamp map table data */
-      stamp_data = gfx.mapPtr[(xpos >> gfx.stampShift) | ((ypos >> gfx.stampShift) << gfx.mapShift)];
-
-      /* stamp generator base index                                     */
-      /* sss ssssssss ccyyyxxx (16x16) or sss sssssscc ccyyyxxx (32x32) */
-      /* with:  s = stamp number (1 stamp = 16x16 or 32x32 pixels)      */
-      /*        c = cell offset  (0-3 for 16x16, 0-15 for 32x32)        */
-      /*      yyy = line offset  (0-7)                                  */
-      /*      xxx = pixel offset (0-7)                                  */
-      stamp_index = (stamp_data & stamp_mask) << 8;
-
-      if (stamp_index)
+      pixel = 0;
+
+      xpos &= pos_mask;
+      ypos &= pos_mask;
+
+      /* check if pixel is inside stamp map */
+      if (!((xpos | ypos) & ~dotMask))
       {
-        /* extract HFLIP & ROTATION bits */
-        stamp_data = (stamp_data >> 13) & 7;
-
-        /* cell offset (0-3 or 0-15)                             */
-        /* table entry = yyxxshrr (8 bits)                       */
-        /* with: yy = cell row  (0-3) = (ypos >> (11 + 3)) & 3   */
-        /*       xx = cell column (0-3) = (xpos >> (11 + 3)) & 3 */
-        /*        s = stamp size (0=16x16, 1=32x32)              */
-        /*      hrr = HFLIP & ROTATION bits                      */
-        stamp_index |= gfx.lut_cell[stamp_data | ((scd.regs[0x58>>1].byte.l & 0x02) << 2 ) | ((ypos >> 8) & 0xc0) | ((xpos >> 10) & 0x30)] << 6;
-            
-        /* pixel  offset (0-63)                              */
-        /* table entry = yyyxxxhrr (9 bits)                  */
-        /* with: yyy = pixel row  (0-7) = (ypos >> 11) & 7   */
-        /*       xxx = pixel column (0-7) = (xpos >> 11) & 7 */
-        /*       hrr = HFLIP & ROTATION bits                 */
-        stamp_index |= gfx.lut_pixel[stamp_data | ((xpos >> 8) & 0x38) | ((ypos >> 5) & 0x1c0)];
-
-        /* read pixel pair (2 pixels/byte) */
-        pixel_out = READ_BYTE(scd.word_ram_2M, stamp_index >> 1);
-
-        /* extract left or rigth pixel */
-        if (stamp_index & 1)
+        /* stamp map table data */
+        map = &gfx.mapPtr[(xpos >> stampShift) | ((ypos >> stampShift) << mapShift)];
+        if (map == dst)
         {
-           pixel_out &= 0x0f;
+          *dst = gfx_write(*dst, data, mask, mode);
+          data = mask = 0;
         }
-        else
+        stamp_data = *map;
+
+        /* stamp generator base index (stamp 0 is not used) */
+        stamp_index = (stamp_data & stamp_mask) << 8;
+
+        if (stamp_index)
         {
-           pixel_out >>= 4;
+          /* extract HFLIP & ROTATION bits */
+          stamp_data = (stamp_data >> 13) & 7;
+
+          /* cell offset (0-3 or 0-15) */
+          stamp_index |= gfx.lut_cell[stamp_data | (size << 2) | ((ypos >> 8) & 0xc0) | ((xpos >> 10) & 0x30)] << 6;
+
+          /* pixel offset (0-63) */
+          stamp_index |= gfx.lut_pixel[stamp_data | ((xpos >> 8) & 0x38) | ((ypos >> 5) & 0x1c0)];
+
+          /* stamp pixel data */
+          if (&image[stamp_index >> 2] == dst)
+          {
+            *dst = gfx_write(*dst, data, mask, mode);
+            data = mask = 0;
+          }
+          pixel = READ_BYTE(scd.word_ram_2M, stamp_index >> 1);
+
+          /* extract left or rigth pixel (without branch, pixel order is random with rotation) */
+          pixel = (pixel >> ((~stamp_index & 1) << 2)) & 0x0f;
         }
       }
-      else
-      {
-        /* stamp 0 is not used: force pixel output to 0 */
-        pixel_out = 0x00;
-      }
-    }
 
-    /* read out paired pixel data */
-    pixel_in = READ_BYTE(scd.word_ram_2M, bufferIndex >> 1);
+      data |= pixel << shift;
+      mask |= 0x0f << shift;
+      shift -= 4;
 
-    /* update left or rigth pixel */
-    if (bufferIndex & 1)
-    {
-      pixel_out |= (pixel_in & 0xf0);
+      /* increment pixel position */
+      xpos += xoffset;
+      ypos += yoffset;
     }
-    else
-    {
-      pixel_out = (pixel_out << 4) | (pixel_in & 0x0f);
-    }
-
-    /* priority mode write */
-    pixel_out = gfx.lut_prio[(scd.regs[0x02>>1].w >> 3) & 0x03][pixel_in][pixel_out];
+    while (--count);
 
     /* write data to image buffer */
-    WRITE_BYTE(scd.word_ram_2M, bufferIndex >> 1, pixel_out);
+    *dst = gfx_write(*dst, data, mask, mode);
 
-    /* check current pixel position  */
+    /* check last pixel position */
     if ((bufferIndex & 7) != 7)
     {
       /* next pixel */
@@ -586,10 +624,33 @@ INLINE void gfx_render(uint32 bufferIndex, uint32 width)
       /* next cell: increment image buffer offset by one column (minus 7 pixels) */
       bufferIndex += gfx.bufferOffset;
     }
+  }
+}
+
+INLINE void gfx_render(uint32 bufferIndex, uint32 width)
+{
+  /* stamp map & stamp sizes (see gfx_start) */
+  switch (gfx.mapShift)
+  {
+    case 4:
+      gfx_render_line(bufferIndex, width, 0x07ffff, 11 + 4, 4);
+      break;
+
+    case 3:
+      gfx_render_line(bufferIndex, width, 0x07ffff, 11 + 5, 3);
+      break;
+
+    case 8:
+      gfx_render_line(bufferIndex, width, 0x7fffff, 11 + 4, 8);
+      break;
 
-    /* increment pixel position */
-    xpos += xoffset;
-    ypos += yoffset;
+    case 7:
+      gfx_render_line(bufferIndex, width, 0x7fffff, 11 + 5, 7);
+      break;
+
+    default:
+      gfx_render_line(bufferIndex, width, gfx.dotMask, gfx.stampShift, gfx.mapShift);
+      break;
   }
 }
 
@@ -36,11 +36,18 @@
  *
  ****************************************************************************************/
 #include "shared.h"
+#include "simd.h"
 
 #define PCM_SCYCLES_RATIO (384 * 4)
 
+/* samples rendered per channel at once */
+#define PCM_BLOCK_SIZE 128
+
 #define pcm scd.pcm_hw
 
+/* external RAM savestate pages modified since last delta (see state.c) */
+static uint8 pcm_dirty[STATE_PAGES(0x10000)];
+
 void pcm_init(double clock, int samplerate)
 {
   /* PCM chip is running at original rate and is synchronized with SUB-CPU  */
@@ -52,6 +59,7 @@ void pcm_reset(void)
 {
   /* reset chip & clear external RAM */
   memset(&pcm, 0, sizeof(pcm_t));
+  memset(pcm_dirty, 1, sizeof(pcm_dirty));
 
   /* reset default bank */
   pcm.bank = pcm.ram;
@@ -86,7 +94,7 @@ int pcm_context_save(uint8 *state)
   save_param(&pcm.enabled, sizeof(pcm.enabled));
   save_param(&pcm.status, sizeof(pcm.status));
   save_param(&pcm.index, sizeof(pcm.index));
-  save_param(pcm.ram, sizeof(pcm.ram));
+  save_tracked(pcm.ram, sizeof(pcm.ram), pcm_dirty);
 
   return bufferptr;
 }
@@ -106,10 +114,89 @@ int pcm_context_load(uint8 *state)
   load_param(&pcm.status, sizeof(pcm.status));
   load_param(&pcm.index, sizeof(pcm.index));
   load_param(pcm.ram, sizeof(pcm.ram));
+  memset(pcm_dirty, 1, sizeof(pcm_dirty));
 
   return bufferptr;
 }
 
+/* Channels are rendered separately by blocks of samples: WAVE RAM data of each
+   enabled channel is first read into a block of signed samples, which is then
+   multiplied with ENV & stereo PAN data and added to L/R outputs (using SIMD
+   when supported). Output is identical to rendering channels sample by sample. */
+static void pcm_channel_read(chan_t *ch, int16 *data, int length)
+{
+  int i;
+  uint32 addr = ch->addr;
+
+  for (i=0; i<length; i++)
+  {
+    /* read from current WAVE RAM address */
+    int sample = pcm.ram[(addr >> 11) & 0xffff];
+
+    /* loop data ? */
+    if (sample == 0xff)
+    {
+      /* reset WAVE RAM address */
+      addr = ch->ls.w << 11;
+
+      /* read again from WAVE RAM address */
+      sample = pcm.ram[ch->ls.w];
+
+      /* infinite loop should not output any data */
+      if (sample == 0xff)
+      {
+        data[i] = 0;
+        continue;
+      }
+    }
+    else
+    {
+      /* increment WAVE RAM address */
+      addr += ch->fd.w;
+    }
+
+    /* check sign bit (output centered around 0) */
+    if (sample & 0x80)
+    {
+      /* PCM data is positive */
+      data[i] = sample & 0x7f;
+    }
+    else
+    {
+      /* PCM data is negative */
+      data[i] = -(sample & 0x7f);
+    }
+  }
+
+  ch->addr = addr;
+}
+
+static void pcm_channel_mix(const int16 *data, int *l, int *r, int vol_l, int vol_r, int length)
+{
+  int i = 0;
+
+#ifdef HAVE_SIMD
+  simd_t vl = SIMD_SET16(vol_l);
+  simd_t vr = SIMD_SET16(vol_r);
+
+  for (; i<=(length-8); i+=8)
+  {
+    simd_t d = SIMD_LOAD(&data[i]);
+    SIMD_STORE(&l[i],   SIMD_ADD32(SIMD_LOAD(&l[i]),   SIMD_SRA32(SIMD_MULS16L(d, vl), 5)));
+    SIMD_STORE(&l[i+4], SIMD_ADD32(SIMD_LOAD(&l[i+4]), SIMD_SRA32(SIMD_MULS16H(d, vl), 5)));
+    SIMD_STORE(&r[i],   SIMD_ADD32(SIMD_LOAD(&r[i]),   SIMD_SRA32(SIMD_MULS16L(d, vr), 5)));
+    SIMD_STORE(&r[i+4], SIMD_ADD32(SIMD_LOAD(&r[i+4]), SIMD_SRA32(SIMD_MULS16H(d, vr), 5)));
+  }
+#endif
+
+  for (; i<length; i++)
+  {
+    /* multiply PCM data with ENV & stereo PAN data then add to L/R outputs (14.5 fixed point) */
+    l[i] += ((data[i] * vol_l) >> 5);
+    r[i] += ((data[i] * vol_r) >> 5);
+  }
+}
+
 void pcm_run(unsigned int length)
 {
 #ifdef LOG_PCM
@@ -123,13 +210,18 @@ void pcm_run(unsigned int length)
   /* check if PCM chip is running */
   if (pcm.enabled)
   {
-    int i, j, l, r;
-  
+    int16 data[PCM_BLOCK_SIZE];
+    int out[2][PCM_BLOCK_SIZE];
+    int i, j, l, r, count, time;
+
     /* generate PCM samples */
-    for (i=0; i<length; i++)
+    for (time=0; time<length; time+=count)
     {
+      count = length - time;
+      if (count > PCM_BLOCK_SIZE) count = PCM_BLOCK_SIZE;
+
       /* clear output */
-      l = r = 0;
+      memset(out, 0, sizeof(out));
 
       /* run eight PCM channels */
       for (j=0; j<8; j++)
@@ -137,60 +229,39 @@ void pcm_run(unsigned int length)
         /* check if channel is enabled */
         if (pcm.status & (1 << j))
         {
-          /* read from current WAVE RAM address */
-          short data = pcm.ram[(pcm.chan[j].addr >> 11) & 0xffff];
-
-          /* loop data ? */
-          if (data == 0xff)
-          {
-            /* reset WAVE RAM address */
-            pcm.chan[j].addr = pcm.chan[j].ls.w << 11;
-
-            /* read again from WAVE RAM address */
-            data = pcm.ram[pcm.chan[j].ls.w];
-          }
-          else
-          {
-            /* increment WAVE RAM address */
-            pcm.chan[j].addr += pcm.chan[j].fd.w;
-          }
+          chan_t *ch = &pcm.chan[j];
+          int vol_l = ch->env * (ch->pan & 0x0F);
+          int vol_r = ch->env * (ch->pan >> 4);
 
-          /* infinite loop should not output any data */
-          if (data != 0xff)
+          /* muted channels only update WAVE RAM address */
+          pcm_channel_read(ch, data, count);
+          if (vol_l | vol_r)
           {
-            /* check sign bit (output centered around 0) */
-            if (data & 0x80)
-            {
-              /* PCM data is positive */
-              data = data & 0x7f;
-            }
-            else
-            {
-              /* PCM data is negative */
-              data = -(data & 0x7f);
-            }
-
-            /* multiply PCM data with ENV & stereo PAN data then add to L/R outputs (14.5 fixed point) */
-            l += ((data * pcm.chan[j].env * (pcm.chan[j].pan & 0x0F)) >> 5);
-            r += ((data * pcm.chan[j].env * (pcm.chan[j].pan >> 4)) >> 5);
+            pcm_channel_mix(data, out[0], out[1], vol_l, vol_r, count);
           }
         }
       }
 
-      /* limiter */
-      if (l < -32768) l = -32768;
-      else if (l > 32767) l = 32767;
-      if (r < -32768) r = -32768;
-      else if (r > 32767) r = 32767;
-
-      /* PCM output mixing level (0-100%) */
-      l = (l * config.pcm_volume) / 100;
-      r = (r * config.pcm_volume) / 100;
-
-      /* update blip buffer */
-      blip_add_delta_fast(snd.blips[1], i, l-prev_l, r-prev_r);
-      prev_l = l;
-      prev_r = r;
+      for (i=0; i<count; i++)
+      {
+        l = out[0][i];
+        r = out[1][i];
+
+        /* limiter */
+        if (l < -32768) l = -32768;
+        else if (l > 32767) l = 32767;
+        if (r < -32768) r = -32768;
+        else if (r > 32767) r = 32767;
+
+        /* PCM output mixing level (0-100%) */
+        l = (l * config.pcm_volume) / 100;
+        r = (r * config.pcm_volume) / 100;
+
+        /* update blip buffer */
+        blip_add_delta_fast(snd.blips[1], time + i, l-prev_l, r-prev_r);
+        prev_l = l;
+        prev_r = r;
+      }
     }
 
     /* save last audio outputs */
@@ -250,6 +321,7 @@ void pcm_write(unsigned int address, unsigned char data, unsigned int cycles)
   {
     /* 4K bank access */
     pcm.bank[address & 0xfff] = data;
+    MARK_STATE_DIRTY(pcm_dirty, (pcm.bank - pcm.ram) + (address & 0xfff));
     return;
   }
 
@@ -414,6 +486,7 @@ void pcm_ram_dma_w(unsigned int length)
   {
     /* copy byte from CDC buffer to PCM RAM bank */
     pcm.bank[dst_index] = cdc.ram[src_index];
+    MARK_STATE_DIRTY(pcm_dirty, (pcm.bank - pcm.ram) + dst_index);
 
     /* increment CDC buffer source address */
     src_index = (src_index + 1) & 0x3fff;
@@ -69,6 +69,7 @@ extern void pcm_init(double clock, int rate);
 extern void pcm_reset(void);
 extern int pcm_context_save(uint8 *state);
 extern int pcm_context_load(uint8 *state);
+extern void pcm_run(unsigned int length);
 extern void pcm_update(unsigned int samples);
 extern void pcm_write(unsigned int address, unsigned char data, unsigned int cycles);
 extern unsigned char pcm_read(unsigned int address, unsigned int cycles);
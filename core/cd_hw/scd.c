@@ -38,6 +38,11 @@
 
 #include "shared.h"
 
+#ifdef USE_THREADED_SCD
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
 /*--------------------------------------------------------------------------*/
 /* Unused area (return open bus data, i.e prefetched instruction word)      */
 /*--------------------------------------------------------------------------*/
@@ -548,6 +553,14 @@ static unsigned int scd_read_byte(unsigned int address)
   /* only A1-A8 are used for decoding */
   address &= 0x1ff;
 
+#ifdef USE_THREADED_SCD
+  /* registers shared with MAIN-CPU */
+  if (address < 0x30)
+  {
+    scd_thread_access();
+  }
+#endif
+
   /* Memory Mode */
   if (address == 0x03)
   {
@@ -662,6 +675,14 @@ static unsigned int scd_read_word(unsigned int address)
   /* only A1-A8 are used for decoding */
   address &= 0x1ff;
 
+#ifdef USE_THREADED_SCD
+  /* registers shared with MAIN-CPU */
+  if (address < 0x30)
+  {
+    scd_thread_access();
+  }
+#endif
+
   /* Memory Mode */
   if (address == 0x02)
   {
@@ -824,6 +845,14 @@ static void scd_write_byte(unsigned int address, unsigned int data)
   error("[%d][%d]write byte CD register %X -> 0x%02x (%X)\n", v_counter, s68k.cycles, address, data, s68k.pc);
 #endif
 
+#ifdef USE_THREADED_SCD
+  /* registers shared with MAIN-CPU (including IEN2 flag) */
+  if (((address & 0x1ff) < 0x30) || ((address & 0x1fe) == 0x32))
+  {
+    scd_thread_access();
+  }
+#endif
+
   /* Gate-Array registers */
   switch (address & 0x1ff)
   {
@@ -1178,6 +1207,14 @@ static void scd_write_word(unsigned int address, unsigned int data)
   error("[%d][%d]write word CD register %X -> 0x%04x (%X)\n", v_counter, s68k.cycles, address, data, s68k.pc);
 #endif
 
+#ifdef USE_THREADED_SCD
+  /* registers shared with MAIN-CPU (including IEN2 flag) */
+  if (((address & 0x1ff) < 0x30) || ((address & 0x1fe) == 0x32))
+  {
+    scd_thread_access();
+  }
+#endif
+
   /* Gate-Array registers */
   switch (address & 0x1fe)
   {
@@ -1572,6 +1609,328 @@ static void scd_write_word(unsigned int address, unsigned int data)
   }
 }
 
+#ifdef USE_THREADED_SCD
+
+/*--------------------------------------------------------------------------*/
+/* SUB-CPU thread                                                           */
+/*--------------------------------------------------------------------------*/
+
+/* SUB-CPU is run on a worker thread while MAIN-CPU executes the same line slice.   */
+/* MAIN-CPU accesses that synchronize SUB-CPU (see mem68k.c) wait for the worker    */
+/* thread to reach current MAIN-CPU cycle, exactly as s68k_run() would do. Until    */
+/* then, SUB-CPU only executes instructions as long as MAIN-CPU (which reports its  */
+/* cycle count on each instruction) is known to be ahead and accesses to registers  */
+/* shared with MAIN-CPU wait for MAIN-CPU synchronization. Both threads are joined  */
+/* at the end of each slice, before CDD, CDC DMA and Timer processing. GFX          */
+/* processing then runs on the worker thread until next slice.                      */
+
+/* spin iterations before sleeping (multi-core hosts only) */
+#define SCD_THREAD_SPINS 2048
+
+static struct
+{
+  int enabled;            /* SUB-CPU thread used for next slices */
+  int running;            /* SUB-CPU thread started */
+  int spins;              /* spin iterations before sleeping */
+  int slice;              /* SUB-CPU is executed by worker thread in current slice */
+  int parked;             /* MAIN-CPU is waiting for SUB-CPU synchronization */
+  int gfx_pending;        /* GFX processing requested */
+  int quit;               /* worker thread exit requested */
+  int sleeping[2];        /* emulation / worker thread is sleeping */
+  unsigned int end;       /* SUB-CPU cycle count at the end of current slice */
+  unsigned int requests;  /* synchronizations requested by MAIN-CPU in current slice */
+  unsigned int done;      /* synchronizations completed by worker thread in current slice */
+  unsigned int target;    /* SUB-CPU cycle count requested by last synchronization */
+  int last;               /* last synchronization ends current slice */
+  unsigned int resume;    /* MAIN-CPU cycle count reported when last synchronization completed */
+  unsigned int gfx_cycles; /* CD hardware cycle count for requested GFX processing */
+} scd_thread;
+
+static pthread_t scd_thread_id;
+static pthread_mutex_t scd_thread_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t scd_thread_wake = PTHREAD_COND_INITIALIZER;
+
+/* MAIN-CPU cycle count at current instruction start (see m68kcpu.c) */
+unsigned int m68k_sync_cycles;
+
+static int scd_thread_requested(void)
+{
+  return __atomic_load_n(&scd_thread.requests, __ATOMIC_ACQUIRE) != scd_thread.done;
+}
+
+static int scd_thread_completed(void)
+{
+  return __atomic_load_n(&scd_thread.done, __ATOMIC_ACQUIRE) == scd_thread.requests;
+}
+
+static int scd_thread_idle(void)
+{
+  return !__atomic_load_n(&scd_thread.gfx_pending, __ATOMIC_ACQUIRE);
+}
+
+static int scd_thread_work(void)
+{
+  return __atomic_load_n(&scd_thread.slice, __ATOMIC_ACQUIRE) || !scd_thread_idle() || __atomic_load_n(&scd_thread.quit, __ATOMIC_ACQUIRE);
+}
+
+/* wait for condition set by the other thread (0 = emulation thread, 1 = worker thread) */
+static void scd_thread_wait_for(int (*ready)(void), int thread)
+{
+  int spins = 0;
+
+  while (!ready())
+  {
+    if (spins++ < scd_thread.spins)
+    {
+#if defined(__i386__) || defined(__x86_64__)
+      __builtin_ia32_pause();
+#endif
+      continue;
+    }
+
+    pthread_mutex_lock(&scd_thread_mutex);
+    __atomic_store_n(&scd_thread.sleeping[thread], 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    while (!ready())
+    {
+      pthread_cond_wait(&scd_thread_wake, &scd_thread_mutex);
+    }
+    __atomic_store_n(&scd_thread.sleeping[thread], 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&scd_thread_mutex);
+  }
+}
+
+/* set condition waited by the other thread */
+static void scd_thread_signal(unsigned int *cond, unsigned int value, int thread)
+{
+  __atomic_store_n(cond, value, __ATOMIC_RELEASE);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+  if (__atomic_load_n(&scd_thread.sleeping[thread], __ATOMIC_RELAXED))
+  {
+    pthread_mutex_lock(&scd_thread_mutex);
+    pthread_cond_broadcast(&scd_thread_wake);
+    pthread_mutex_unlock(&scd_thread_mutex);
+  }
+}
+
+/* wait for worker thread to complete synchronization requested by MAIN-CPU (emulation thread) */
+static void scd_thread_request(unsigned int cycles, int last)
+{
+  scd_thread.target = cycles;
+  scd_thread.last = last;
+  scd_thread.parked = 1;
+  scd_thread_signal(&scd_thread.requests, scd_thread.requests + 1, 1);
+  scd_thread_wait_for(scd_thread_completed, 0);
+  scd_thread.parked = 0;
+}
+
+unsigned int scd_thread_limit(unsigned int cycles)
+{
+  int spins = 0;
+
+  while (!scd_thread_requested())
+  {
+    /* MAIN-CPU cycle count, once resumed since last synchronization */
+    unsigned int limit = __atomic_load_n(&m68k_sync_cycles, __ATOMIC_ACQUIRE);
+    if (limit != scd_thread.resume)
+    {
+      /* next synchronization can not occur before current MAIN-CPU cycle */
+      limit = (limit * SCYCLES_PER_LINE) / MCYCLES_PER_LINE;
+      if (limit > scd_thread.end)
+      {
+        limit = scd_thread.end;
+      }
+
+      if (limit > cycles)
+      {
+        return limit;
+      }
+    }
+
+    /* MAIN-CPU is not progressing: wait for next synchronization */
+    if (spins++ >= scd_thread.spins)
+    {
+      scd_thread_wait_for(scd_thread_requested, 1);
+      break;
+    }
+
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#endif
+  }
+
+  /* end of execution frame is known */
+  s68k.cycle_end = scd_thread.target;
+  return scd_thread.target;
+}
+
+void scd_thread_access(void)
+{
+  /* SUB-CPU executed concurrently with MAIN-CPU ? */
+  if (__atomic_load_n(&scd_thread.slice, __ATOMIC_ACQUIRE))
+  {
+    /* wait for MAIN-CPU synchronization */
+    scd_thread_wait_for(scd_thread_requested, 1);
+  }
+}
+
+int scd_thread_sync(unsigned int cycles)
+{
+  if (scd_thread.slice)
+  {
+    /* called from worker thread while MAIN-CPU is waiting */
+    if (scd_thread.parked)
+    {
+      return 0;
+    }
+
+    /* MAIN-CPU waits for SUB-CPU to reach current cycle */
+    scd_thread_request(cycles, 0);
+    return 1;
+  }
+
+  /* wait for any pending GFX processing */
+  scd_thread_wait();
+  return 0;
+}
+
+static void scd_thread_slice(void)
+{
+  int last;
+
+  do
+  {
+    unsigned int cycle_end = s68k.cycle_end;
+
+    /* wait for MAIN-CPU to resume after last synchronization (or to request next one) */
+    if (__atomic_load_n(&m68k_sync_cycles, __ATOMIC_ACQUIRE) == scd_thread.resume)
+    {
+      int spins = 0;
+      while (!scd_thread_requested() && (__atomic_load_n(&m68k_sync_cycles, __ATOMIC_ACQUIRE) == scd_thread.resume))
+      {
+        if (spins++ >= scd_thread.spins)
+        {
+          scd_thread_wait_for(scd_thread_requested, 1);
+          break;
+        }
+#if defined(__i386__) || defined(__x86_64__)
+        __builtin_ia32_pause();
+#endif
+      }
+    }
+
+    if (s68k.stopped)
+    {
+      /* SUB-CPU is only run at the end of slice (as with s68k_sync) */
+      scd_thread_wait_for(scd_thread_requested, 1);
+      if (scd_thread.last)
+      {
+        s68k_run(scd_thread.target);
+      }
+    }
+    else
+    {
+      s68k_run_async();
+    }
+
+    /* restore SUB-CPU end cycle count after MAIN-CPU synchronization */
+    last = scd_thread.last;
+    if (!last)
+    {
+      s68k.cycle_end = cycle_end;
+    }
+
+    scd_thread.resume = __atomic_load_n(&m68k_sync_cycles, __ATOMIC_ACQUIRE);
+    if (last)
+    {
+      /* slice is ended before MAIN-CPU resumes */
+      __atomic_store_n(&scd_thread.slice, 0, __ATOMIC_RELAXED);
+    }
+    scd_thread_signal(&scd_thread.done, scd_thread.done + 1, 0);
+  }
+  while (!last);
+}
+
+static void *scd_thread_main(void *arg)
+{
+  while (1)
+  {
+    /* wait for next slice or GFX processing */
+    scd_thread_wait_for(scd_thread_work, 1);
+
+    if (!scd_thread_idle())
+    {
+      gfx_update(scd_thread.gfx_cycles);
+      scd_thread_signal((unsigned int *)&scd_thread.gfx_pending, 0, 0);
+    }
+
+    if (__atomic_load_n(&scd_thread.slice, __ATOMIC_ACQUIRE))
+    {
+      scd_thread_slice();
+    }
+    else if (__atomic_load_n(&scd_thread.quit, __ATOMIC_ACQUIRE))
+    {
+      break;
+    }
+  }
+
+  return NULL;
+}
+
+/* run both CPU in parallel until required cycle counters (emulation thread) */
+static void scd_thread_run(unsigned int m68k_end_cycles, unsigned int s68k_end_cycles)
+{
+  scd_thread.end = s68k_end_cycles;
+  scd_thread.requests = 0;
+  scd_thread.done = 0;
+  scd_thread.resume = 0xffffffff;
+  m68k_sync_cycles = m68k.cycles;
+  scd_thread_signal((unsigned int *)&scd_thread.slice, 1, 1);
+
+  m68k_run(m68k_end_cycles);
+
+  /* wait for SUB-CPU to reach the end of slice */
+  scd_thread_request(s68k_end_cycles, 1);
+}
+
+void scd_thread_wait(void)
+{
+  scd_thread_wait_for(scd_thread_idle, 0);
+}
+
+static void scd_thread_start(void)
+{
+  if (!scd_thread.running)
+  {
+    /* SUB-CPU thread is only enabled by default on multi-core hosts, where waiting threads spin before sleeping */
+    int multicore = (sysconf(_SC_NPROCESSORS_ONLN) > 1);
+    scd_thread.spins = multicore ? SCD_THREAD_SPINS : 0;
+    scd_thread.enabled = multicore;
+    scd_thread.quit = 0;
+    scd_thread.running = !pthread_create(&scd_thread_id, NULL, scd_thread_main, NULL);
+  }
+}
+
+void scd_thread_enable(int enable)
+{
+  scd_thread_wait();
+  scd_thread.enabled = enable;
+}
+
+void scd_thread_shutdown(void)
+{
+  if (scd_thread.running)
+  {
+    scd_thread_wait();
+    scd_thread_signal((unsigned int *)&scd_thread.quit, 1, 1);
+    pthread_join(scd_thread_id, NULL);
+    scd_thread.running = 0;
+  }
+}
+
+#endif /* USE_THREADED_SCD */
+
 void scd_init(void)
 {
   int i;
@@ -1778,6 +2137,11 @@ void scd_init(void)
   memset(scd.word_ram, 0x00, sizeof(scd.word_ram));
   memset(scd.word_ram_2M, 0x00, sizeof(scd.word_ram_2M));
   memset(scd.bram, 0x00, sizeof(scd.bram));
+
+#ifdef USE_THREADED_SCD
+  /* SUB-CPU runs on its own thread (by default on multi-core hosts) */
+  scd_thread_start();
+#endif
 }
 
 void scd_reset(int hard)
@@ -1918,9 +2282,19 @@ void scd_update(unsigned int cycles)
       m68k_end_cycles = cycles;
     }
 
-    /* run both CPU in sync until required cycle counters */
-    m68k_run(m68k_end_cycles);
-    s68k_run(scd.cycles + s68k_run_cycles);
+#ifdef USE_THREADED_SCD
+    if (scd_thread.enabled && scd_thread.running)
+    {
+      /* run both CPU in parallel until required cycle counters */
+      scd_thread_run(m68k_end_cycles, scd.cycles + s68k_run_cycles);
+    }
+    else
+#endif
+    {
+      /* run both CPU in sync until required cycle counters */
+      m68k_run(m68k_end_cycles);
+      s68k_run(scd.cycles + s68k_run_cycles);
+    }
 
     /* increment CD hardware cycle counter */
     scd.cycles += s68k_run_cycles;
@@ -1983,6 +2357,15 @@ void scd_update(unsigned int cycles)
   /* update GFX processing (if started) */
   if (scd.regs[0x58>>1].byte.h & 0x80)
   {
+#ifdef USE_THREADED_SCD
+    if (scd_thread.enabled && scd_thread.running)
+    {
+      /* processed by SUB-CPU thread until next slice */
+      scd_thread.gfx_cycles = scd.cycles;
+      scd_thread_signal((unsigned int *)&scd_thread.gfx_pending, 1, 1);
+      return;
+    }
+#endif
     gfx_update(scd.cycles);
   }
 }
@@ -1991,6 +2374,10 @@ void scd_end_frame(unsigned int cycles)
 {
   /* run Stopwatch until end of frame */
   int ticks = (cycles - scd.stopwatch) / TIMERS_SCYCLES_RATIO;
+
+  /* wait for pending GFX processing */
+  scd_thread_wait();
+
   scd.regs[0x0c>>1].w = (scd.regs[0x0c>>1].w + ticks) & 0xfff;
 
   /* adjust Stopwatch counter for next frame (can be negative) */
@@ -2358,6 +2745,14 @@ int scd_68k_irq_ack(int level)
   error("INT ack level %d  (%X)\n", level, s68k.pc);
 #endif
 
+#ifdef USE_THREADED_SCD
+  /* IFL2 flag is shared with MAIN-CPU */
+  if (level == 2)
+  {
+    scd_thread_access();
+  }
+#endif
+
   /* clear pending interrupt flag */
   scd.pending &= ~(1 << level);
 
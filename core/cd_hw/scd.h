@@ -99,4 +99,20 @@ extern int scd_context_save(uint8 *state);
 extern int scd_68k_irq_ack(int level);
 extern void prg_ram_dma_w(unsigned int length);
 
+/* SUB-CPU executed on a separate thread, in parallel with MAIN-CPU (requires pthreads) */
+#ifdef USE_THREADED_SCD
+#ifdef USE_THREAD_LOCAL_CONTEXT
+#error "USE_THREADED_SCD cannot be combined with USE_THREAD_LOCAL_CONTEXT"
+#endif
+extern void scd_thread_enable(int enable);
+extern void scd_thread_shutdown(void);
+extern void scd_thread_wait(void);
+extern void scd_thread_access(void);
+extern int scd_thread_sync(unsigned int cycles);
+#else
+#define scd_thread_enable(enable)
+#define scd_thread_shutdown()
+#define scd_thread_wait()
+#endif
+
 #endif
@@ -42,18 +42,18 @@
 #include "shared.h"
 
 #ifdef USE_DYNAMIC_ALLOC
-external_t *ext;
+THREAD_LOCAL external_t *ext;
 #else                     /* External Hardware (Cartridge, CD unit, ...) */
-external_t ext;
+THREAD_LOCAL external_t ext;
 #endif
-uint8 boot_rom[0x800];    /* Genesis BOOT ROM   */
-uint8 work_ram[0x10000];  /* 68K RAM  */
-uint8 zram[0x2000];       /* Z80 RAM  */
-uint32 zbank;             /* Z80 bank window address */
-uint8 zstate;             /* Z80 bus state (d0 = /RESET, d1 = BUSREQ, d2 = WAIT) */
-uint8 pico_current;       /* PICO current page */
+THREAD_LOCAL uint8 boot_rom[0x800];    /* Genesis BOOT ROM   */
+THREAD_LOCAL uint8 work_ram[0x10000];  /* 68K RAM  */
+THREAD_LOCAL uint8 zram[0x2000];       /* Z80 RAM  */
+THREAD_LOCAL uint32 zbank;             /* Z80 bank window address */
+THREAD_LOCAL uint8 zstate;             /* Z80 bus state (d0 = /RESET, d1 = BUSREQ, d2 = WAIT) */
+THREAD_LOCAL uint8 pico_current;       /* PICO current page */
 
-static uint8 tmss[4];     /* TMSS security register */
+static THREAD_LOCAL uint8 tmss[4];     /* TMSS security register */
 
 /*--------------------------------------------------------------------------*/
 /* Init, reset, shutdown functions                                          */
@@ -177,6 +177,9 @@ void gen_init(void)
     /* initialize cartridge hardware & Z80 memory handlers */
     sms_cart_init();
 
+    /* Z80 code can be decoded once from cartridge ROM */
+    z80_decode_cache_init(cart.rom, sizeof(cart.rom));
+
     /* initialize Z80 ports handlers */
     switch (system_hw)
     {
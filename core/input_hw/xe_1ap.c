@@ -40,7 +40,7 @@
 
 #define XE_1AP_LATENCY 3
 
-static struct
+static THREAD_LOCAL struct
 {
   uint8 State;
   uint8 Counter;
@@ -50,11 +50,11 @@
 #include "sportspad.h"
 #include "graphic_board.h"
 
-uint8 io_reg[0x10];
+THREAD_LOCAL uint8 io_reg[0x10];
 
-uint8 region_code = REGION_USA;
+THREAD_LOCAL uint8 region_code = REGION_USA;
 
-static struct port_t
+static THREAD_LOCAL struct port_t
 {
   void (*data_w)(unsigned char data, unsigned char mask);
   unsigned char (*data_r)(void);
@@ -90,10 +90,10 @@ typedef struct
 } PERIPHERALINFO;
 
 
-ROMINFO rominfo;
-uint8 romtype;
+THREAD_LOCAL ROMINFO rominfo;
+THREAD_LOCAL uint8 romtype;
 
-static uint8 rom_region;
+static THREAD_LOCAL uint8 rom_region;
 
 /***************************************************************************
  * Genesis ROM Manufacturers
@@ -232,12 +232,41 @@ typedef struct
   uint detected;
 } cpu_idle_t;
 
+#ifdef USE_IDLE_LOOP_SKIP
+/* maximal size & instruction count of skipped idle loops */
+#define M68K_LOOP_SIZE 32
+#define M68K_LOOP_OPS  16
+
+/* idle loop state flags */
+#define M68K_LOOP_BRANCH 1  /* short backward branch taken */
+#define M68K_LOOP_SAVED  2  /* registers saved at loop start */
+
+/* idle loop skipping */
+typedef struct
+{
+  uint state;                     /* loop state flags */
+  uint pc;                        /* loop start address */
+  uint dar[16];                   /* registers at loop start */
+  uint sr;                        /* status register at loop start */
+  uint count;                     /* access count at loop start */
+  uint access;                    /* memory writes & I/O reads count */
+  uint limit;                     /* cycle until polled I/O registers return the same value */
+  sint refresh;                   /* refresh cycle at loop start */
+  uint ops;                       /* instructions executed since loop start */
+  sint time[M68K_LOOP_OPS + 1];   /* instruction start cycles */
+} cpu_loop_t;
+#endif
+
 typedef struct
 {
   cpu_memory_map memory_map[256]; /* memory mapping */
 
   cpu_idle_t poll;      /* polling detection */
 
+#ifdef USE_IDLE_LOOP_SKIP
+  cpu_loop_t loop;      /* idle loop skipping */
+#endif
+
   sint cycles;          /* current master cycle count */ 
   sint refresh_cycles;  /* external bus refresh cycle */ 
   uint cycle_end;       /* aimed master cycle count for current execution frame */
@@ -286,8 +315,8 @@ typedef struct
 } m68ki_cpu_core;
 
 /* CPU cores */
-extern m68ki_cpu_core m68k;
-extern m68ki_cpu_core s68k;
+extern THREAD_LOCAL m68ki_cpu_core m68k;
+extern THREAD_LOCAL m68ki_cpu_core s68k;
 
 
 /* ======================================================================== */
@@ -366,6 +395,22 @@ extern void s68k_pulse_reset(void);
 extern void m68k_run(unsigned int cycles);
 extern void s68k_run(unsigned int cycles);
 
+/* Run SUB-CPU on its own thread, as long as MAIN-CPU is known to be ahead (see scd.c) */
+#ifdef USE_THREADED_SCD
+#define S68K_CYCLE_END_UNKNOWN 0x40000000
+extern unsigned int m68k_sync_cycles;
+extern unsigned int scd_thread_limit(unsigned int cycles);
+extern void s68k_run_async(void);
+#endif
+
+/* Skip identical iterations of idle loops (no memory write or I/O access other than polled status) */
+#ifdef USE_IDLE_LOOP_SKIP
+extern THREAD_LOCAL unsigned int m68k_loop_skipped;
+extern void m68k_idle_limit(unsigned int cycles);
+#else
+#define m68k_idle_limit(cycles)
+#endif
+
 /* Get current instruction execution time */
 extern int m68k_cycles(void);
 extern int s68k_cycles(void);
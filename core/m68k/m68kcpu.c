@@ -27,9 +27,9 @@ extern int vdp_68k_irq_ack(int int_level);
 static unsigned char m68ki_cycles[0x10000];
 #endif
 
-static int irq_latency;
+static THREAD_LOCAL int irq_latency;
 
-m68ki_cpu_core m68k;
+THREAD_LOCAL m68ki_cpu_core m68k;
 
 
 /* ======================================================================== */
@@ -191,7 +191,7 @@ void m68k_set_fc_callback(void  (*callback)(unsigned int new_fc))
 #ifdef LOGERROR
 
 extern void error(char *format, ...);
-extern uint16 v_counter;
+extern THREAD_LOCAL uint16 v_counter;
 #endif
 
 /* ASG: rewrote so that the int_level is a mask of the IPL0/IPL1/IPL2 bits */
@@ -254,6 +254,113 @@ void m68k_set_irq_delay(unsigned int int_level)
   m68ki_check_interrupts(); /* Level triggered (IRQ) */
 }
 
+#ifdef USE_IDLE_LOOP_SKIP
+THREAD_LOCAL unsigned int m68k_loop_skipped;
+
+void m68k_idle_limit(unsigned int cycles)
+{
+  /* polled I/O register read has no side effect, returned value does not change before given cycle */
+  m68k.loop.access--;
+  if (cycles < m68k.loop.limit)
+  {
+    m68k.loop.limit = cycles;
+  }
+}
+
+/* Called at loop start, when last iteration did not write memory or access I/O (except polled status) */
+static void m68ki_idle_loop(uint cycles)
+{
+  cpu_loop_t *loop = &m68k.loop;
+  uint i;
+
+  for (i=0; (loop->state & M68K_LOOP_SAVED) && (i<16) && (loop->dar[i] == REG_DA[i]); i++);
+
+  /* last iteration also did not modify registers & flags */
+  if ((i == 16) && (loop->sr == m68ki_get_sr()))
+  {
+    sint cost[M68K_LOOP_OPS];
+    sint refresh = loop->refresh;
+    sint start = m68k.cycles;
+    uint limit = (loop->limit < cycles) ? loop->limit : cycles;
+
+    /* instruction execution times, without refresh delays */
+    loop->time[loop->ops] = m68k.cycles;
+    for (i=0; i<loop->ops; i++)
+    {
+      cost[i] = loop->time[i + 1] - loop->time[i];
+      if (loop->time[i] >= (refresh + (128*7)))
+      {
+        refresh = (loop->time[i] / (128*7)) * (128*7);
+        cost[i] -= (2*7);
+      }
+    }
+
+    /* next iterations are identical: only advance cycle counters, as long as whole iteration ends before limit */
+    for (;;)
+    {
+      sint time = m68k.cycles;
+      refresh = m68k.refresh_cycles;
+
+      for (i=0; i<loop->ops; i++)
+      {
+        if (time >= (refresh + (128*7)))
+        {
+          refresh = (time / (128*7)) * (128*7);
+          time += (2*7);
+        }
+        time += cost[i];
+      }
+
+      if ((uint)time >= limit)
+      {
+        break;
+      }
+
+      m68k.cycles = time;
+      m68k.refresh_cycles = refresh;
+    }
+
+    m68k_loop_skipped += m68k.cycles - start;
+  }
+  else
+  {
+    /* start new iteration with saved registers */
+    for (i=0; i<16; i++)
+    {
+      loop->dar[i] = REG_DA[i];
+    }
+    loop->sr = m68ki_get_sr();
+  }
+
+  loop->state = M68K_LOOP_SAVED;
+  loop->limit = 0xffffffff;
+  loop->refresh = m68k.refresh_cycles;
+  loop->ops = 0;
+}
+
+/* Check for loop start, record instruction start cycle once registers have been saved */
+static void m68ki_idle_check(uint cycles)
+{
+  if (m68k.loop.state & M68K_LOOP_BRANCH)
+  {
+    m68ki_idle_loop(cycles);
+  }
+
+  if (m68k.loop.state & M68K_LOOP_SAVED)
+  {
+    if (m68k.loop.ops < M68K_LOOP_OPS)
+    {
+      m68k.loop.time[m68k.loop.ops++] = m68k.cycles;
+    }
+    else
+    {
+      /* longer iterations are not skipped */
+      m68k.loop.state = 0;
+    }
+  }
+}
+#endif
+
 void m68k_run(unsigned int cycles) 
 {
   /* Make sure CPU is not already ahead */
@@ -275,6 +382,12 @@ void m68k_run(unsigned int cycles)
   /* Save end cycles count for when CPU is stopped */
   m68k.cycle_end = cycles;
 
+#ifdef USE_IDLE_LOOP_SKIP
+  /* Idle loops are detected again in each execution frame */
+  m68k.loop.pc = 0xffffffff;
+  m68k.loop.state = 0;
+#endif
+
   /* Return point for when we have an address error (TODO: use goto) */
   m68ki_set_address_error_trap() /* auto-disable (see m68kcpu.h) */
 
@@ -284,6 +397,19 @@ void m68k_run(unsigned int cycles)
 
   while (m68k.cycles < cycles)
   {
+#ifdef USE_THREADED_SCD
+    /* Report current cycle count to SUB-CPU thread */
+    __atomic_store_n(&m68k_sync_cycles, m68k.cycles, __ATOMIC_RELEASE);
+#endif
+
+#ifdef USE_IDLE_LOOP_SKIP
+    /* Skip idle loop iterations if possible */
+    if (UNLIKELY(m68k.loop.state))
+    {
+      m68ki_idle_check(cycles);
+    }
+#endif
+
     /* Set tracing accodring to T1. */
     m68ki_trace_t1() /* auto-disable (see m68kcpu.h) */
 
@@ -336,6 +336,16 @@
 #endif /* M68K_ADDRESS_ERROR */
 
 
+/* Enable or disable idle loop skipping (count memory writes & I/O reads, detect short backward branches) */
+#ifdef USE_IDLE_LOOP_SKIP
+  #define m68ki_loop_access(N) m68ki_cpu.loop.access += (N);
+  #define m68ki_loop_branch(OFFSET) if (((OFFSET) < 0) && ((OFFSET) > -M68K_LOOP_SIZE)) m68ki_loop_start();
+#else
+  #define m68ki_loop_access(N)
+  #define m68ki_loop_branch(OFFSET)
+#endif /* USE_IDLE_LOOP_SKIP */
+
+
 /* -------------------------- EA / Operand Access ------------------------- */
 
 /*
@@ -855,7 +865,11 @@ INLINE uint m68ki_read_8(uint address)
 
   m68ki_set_fc(FLAG_S | m68ki_get_address_space()) /* auto-disable (see m68kcpu.h) */
 
-  if (temp->read8) val = (*temp->read8)(ADDRESS_68K(address));
+  if (temp->read8)
+  {
+    m68ki_loop_access(1) /* auto-disable (see m68kcpu.h) */
+    val = (*temp->read8)(ADDRESS_68K(address));
+  }
   else val = READ_BYTE(temp->base, (address) & 0xffff);
 
 #ifdef HOOK_CPU
@@ -875,7 +889,11 @@ INLINE uint m68ki_read_16(uint address)
   m68ki_check_address_error(address, MODE_READ, FLAG_S | m68ki_get_address_space()) /* auto-disable (see m68kcpu.h) */
   
   temp = &m68ki_cpu.memory_map[((address)>>16)&0xff];
-  if (temp->read16) val = (*temp->read16)(ADDRESS_68K(address));
+  if (temp->read16)
+  {
+    m68ki_loop_access(1) /* auto-disable (see m68kcpu.h) */
+    val = (*temp->read16)(ADDRESS_68K(address));
+  }
   else val = *(uint16 *)(temp->base + ((address) & 0xffff));
 
 #ifdef HOOK_CPU
@@ -895,7 +913,11 @@ INLINE uint m68ki_read_32(uint address)
   m68ki_check_address_error(address, MODE_READ, FLAG_S | m68ki_get_address_space()) /* auto-disable (see m68kcpu.h) */
 
   temp = &m68ki_cpu.memory_map[((address)>>16)&0xff];
-  if (temp->read16) val = ((*temp->read16)(ADDRESS_68K(address)) << 16) | ((*temp->read16)(ADDRESS_68K(address + 2)));
+  if (temp->read16)
+  {
+    m68ki_loop_access(2) /* auto-disable (see m68kcpu.h) */
+    val = ((*temp->read16)(ADDRESS_68K(address)) << 16) | ((*temp->read16)(ADDRESS_68K(address + 2)));
+  }
   else val = m68k_read_immediate_32(address);
 
 #ifdef HOOK_CPU
@@ -911,6 +933,7 @@ INLINE void m68ki_write_8(uint address, uint value)
   cpu_memory_map *temp;
 
   m68ki_set_fc(FLAG_S | FUNCTION_CODE_USER_DATA) /* auto-disable (see m68kcpu.h) */
+  m68ki_loop_access(1) /* auto-disable (see m68kcpu.h) */
 
 #ifdef HOOK_CPU
   if (UNLIKELY(cpu_hook))
@@ -927,6 +950,7 @@ INLINE void m68ki_write_16(uint address, uint value)
   cpu_memory_map *temp;
 
   m68ki_set_fc(FLAG_S | FUNCTION_CODE_USER_DATA) /* auto-disable (see m68kcpu.h) */
+  m68ki_loop_access(1) /* auto-disable (see m68kcpu.h) */
   m68ki_check_address_error(address, MODE_WRITE, FLAG_S | FUNCTION_CODE_USER_DATA); /* auto-disable (see m68kcpu.h) */
 
 #ifdef HOOK_CPU
@@ -944,6 +968,7 @@ INLINE void m68ki_write_32(uint address, uint value)
   cpu_memory_map *temp;
 
   m68ki_set_fc(FLAG_S | FUNCTION_CODE_USER_DATA) /* auto-disable (see m68kcpu.h) */
+  m68ki_loop_access(1) /* auto-disable (see m68kcpu.h) */
   m68ki_check_address_error(address, MODE_WRITE, FLAG_S | FUNCTION_CODE_USER_DATA) /* auto-disable (see m68kcpu.h) */
 
 #ifdef HOOK_CPU
@@ -1139,6 +1164,26 @@ INLINE void m68ki_jump_vector(uint vector)
 }
 
 
+#ifdef USE_IDLE_LOOP_SKIP
+/* Short backward branch taken, loop starts at new PC */
+INLINE void m68ki_loop_start(void)
+{
+  cpu_loop_t *loop = &m68ki_cpu.loop;
+
+  /* registers are only compared after an iteration without memory write or I/O access */
+  if ((loop->pc == REG_PC) && (loop->count == loop->access))
+  {
+    loop->state |= M68K_LOOP_BRANCH;
+  }
+  else
+  {
+    loop->pc = REG_PC;
+    loop->count = loop->access;
+    loop->state = 0;
+  }
+}
+#endif
+
 /* Branch to a new memory location.
  * The 32-bit branch will call pc_changed if it was enabled in m68kconf.h.
  * So far I've found no problems with not calling pc_changed for 8 or 16
@@ -1147,11 +1192,13 @@ INLINE void m68ki_jump_vector(uint vector)
 INLINE void m68ki_branch_8(uint offset)
 {
   REG_PC += MAKE_INT_8(offset);
+  m68ki_loop_branch(MAKE_INT_8(offset)) /* auto-disable (see m68kcpu.h) */
 }
 
 INLINE void m68ki_branch_16(uint offset)
 {
   REG_PC += MAKE_INT_16(offset);
+  m68ki_loop_branch(MAKE_INT_16(offset)) /* auto-disable (see m68kcpu.h) */
 }
 
 INLINE void m68ki_branch_32(uint offset)
@@ -26,7 +26,7 @@ extern int scd_68k_irq_ack(int level);
 #ifdef BUILD_TABLES
 static unsigned char s68ki_cycles[0x10000];
 #endif
-static int irq_latency;
+static THREAD_LOCAL int irq_latency;
 
 /* IRQ priority */
 static const uint8 irq_level[0x40] = 
@@ -41,7 +41,7 @@ static const uint8 irq_level[0x40] =
   6, 6, 6, 6, 6, 6, 6, 6
 };
 
-m68ki_cpu_core s68k;
+THREAD_LOCAL m68ki_cpu_core s68k;
 
 
 /* ======================================================================== */
@@ -201,7 +201,7 @@ void s68k_set_fc_callback(void  (*callback)(unsigned int new_fc))
 #endif
 
 extern void error(char *format, ...);
-extern uint16 v_counter;
+extern THREAD_LOCAL uint16 v_counter;
 
 /* update IRQ level according to triggered interrupts */
 void s68k_update_irq(unsigned int mask)
@@ -268,6 +268,84 @@ void s68k_run(unsigned int cycles)
   }
 }
 
+#ifdef USE_THREADED_SCD
+/* Same as s68k_run() on SUB-CPU thread: cycle count to reach is unknown until MAIN-CPU */
+/* requests synchronization, instructions are executed meanwhile as long as MAIN-CPU is */
+/* known to be ahead. CPU stopped until end of execution frame is resumed at required  */
+/* cycle count once known. */
+static unsigned int run_limit;
+
+void s68k_run_async(void)
+{
+  /* End cycles count is only modified once CPU is run */
+  unsigned int cycle_end = s68k.cycle_end;
+
+  /* End cycles count is not known yet */
+  s68k.cycle_end = S68K_CYCLE_END_UNKNOWN;
+  run_limit = scd_thread_limit(s68k.cycles);
+
+  /* Make sure CPU is not already ahead */
+  if (s68k.cycles >= run_limit)
+  {
+    s68k.cycle_end = cycle_end;
+    return;
+  }
+
+  /* Check interrupt mask to process IRQ if needed */
+  m68ki_check_interrupts();
+
+  /* Make sure we're not stopped */
+  if (CPU_STOPPED)
+  {
+    s68k.cycles = scd_thread_limit(S68K_CYCLE_END_UNKNOWN);
+    s68k.cycle_end = cycle_end;
+    return;
+  }
+
+  /* Return point for when we have an address error (TODO: use goto) */
+  m68ki_set_address_error_trap() /* auto-disable (see m68kcpu.h) */
+
+  while (1)
+  {
+    while (s68k.cycles < run_limit)
+    {
+      /* Set tracing accodring to T1. */
+      m68ki_trace_t1() /* auto-disable (see m68kcpu.h) */
+
+      /* Set the address space for reads */
+      m68ki_use_data_space() /* auto-disable (see m68kcpu.h) */
+
+      /* Save current instruction PC */
+      s68k.prev_pc = REG_PC;
+
+      /* Decode next instruction */
+      REG_IR = m68ki_read_imm_16();
+
+      /* Execute instruction */
+      m68ki_instruction_jump_table[REG_IR]();
+      USE_CYCLES(CYC_INSTRUCTION[REG_IR]);
+
+      /* Trace m68k_exception, if necessary */
+      m68ki_exception_if_trace(); /* auto-disable (see m68kcpu.h) */
+    }
+
+    /* CPU stopped until unknown end cycles count ? */
+    if (s68k.cycles >= S68K_CYCLE_END_UNKNOWN)
+    {
+      s68k.cycles -= S68K_CYCLE_END_UNKNOWN;
+      s68k.cycles += scd_thread_limit(S68K_CYCLE_END_UNKNOWN);
+    }
+
+    /* End cycles count reached ? */
+    if ((s68k.cycle_end != S68K_CYCLE_END_UNKNOWN) && (s68k.cycles >= s68k.cycle_end))
+    {
+      return;
+    }
+
+    run_limit = scd_thread_limit(s68k.cycles);
+  }
+}
+#endif
 
 int s68k_cycles(void)
 {
@@ -53,6 +53,22 @@
 #define ALIGNED_(x) __attribute__ ((aligned(x)))
 #endif
 
+/* Storage class of emulated machine state (CPU, memory, chips, cartridge hardware)   */
+/* Define USE_THREAD_LOCAL_CONTEXT to give each thread its own copy of the machine     */
+/* state, allowing several independent instances to run concurrently in one process.  */
+/* Constant lookup tables built on initialization remain shared between threads.      */
+#ifdef USE_THREAD_LOCAL_CONTEXT
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__)
+#define THREAD_LOCAL __thread
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+#else
+#define THREAD_LOCAL
+#endif
+
 /* Provide the compiler with branch prediction information */
 #if defined(__GNUC__)
 #define LIKELY(x) __builtin_expect(!!(x), 1)
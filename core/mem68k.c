@@ -268,10 +268,15 @@ static void m68k_poll_detect(unsigned int reg_mask)
   m68k.poll.pc = m68k.pc;
 }
 
-static void m68k_poll_sync(unsigned int reg_mask)
+static void s68k_sync_cycles(unsigned int cycles)
 {
-  /* relative SUB-CPU cycle counter */
-  unsigned int cycles = (m68k.cycles * SCYCLES_PER_LINE) / MCYCLES_PER_LINE;
+#ifdef USE_THREADED_SCD
+  /* SUB-CPU running on its own thread ? */
+  if (scd_thread_sync(cycles))
+  {
+    return;
+  }
+#endif
 
   if (!s68k.stopped)
   {
@@ -284,6 +289,15 @@ static void m68k_poll_sync(unsigned int reg_mask)
     /* restore SUB-CPU end cycle count */
     s68k.cycle_end = end_cycle;
   }
+}
+
+static void m68k_poll_sync(unsigned int reg_mask)
+{
+  /* relative SUB-CPU cycle counter */
+  unsigned int cycles = (m68k.cycles * SCYCLES_PER_LINE) / MCYCLES_PER_LINE;
+
+  /* sync SUB-CPU with MAIN-CPU */
+  s68k_sync_cycles(cycles);
 
   /* SUB-CPU idle on register polling ? */
   if (s68k.stopped & reg_mask)
@@ -305,20 +319,8 @@ static void m68k_poll_sync(unsigned int reg_mask)
 
 static void s68k_sync(void)
 {
-  if (!s68k.stopped)
-  {
-    /* relative SUB-CPU cycle counter */
-    unsigned int cycles = (m68k.cycles * SCYCLES_PER_LINE) / MCYCLES_PER_LINE;
-
-    /* save current SUB-CPU end cycle count (recursive execution is possible) */
-    int end_cycle = s68k.cycle_end;
-
-    /* sync SUB-CPU with MAIN-CPU */
-    s68k_run(cycles);
-
-    /* restore SUB-CPU end cycle count */
-    s68k.cycle_end = end_cycle;
-  }
+  /* sync SUB-CPU with MAIN-CPU */
+  s68k_sync_cycles((m68k.cycles * SCYCLES_PER_LINE) / MCYCLES_PER_LINE);
 }
 
 /*--------------------------------------------------------------------------*/
@@ -705,7 +707,13 @@ void ctrl_io_write_byte(unsigned int address, unsigned int data)
 
           case 0x01:  /* SUB-CPU control */
           {
-            unsigned int halted = s68k.stopped;
+            unsigned int halted;
+
+#ifdef USE_THREADED_SCD
+            /* SUB-CPU state can not be modified while running on its own thread */
+            s68k_sync();
+#endif
+            halted = s68k.stopped;
 
             /* RESET bit */
             if (data & 0x01)
@@ -806,6 +814,10 @@ void ctrl_io_write_byte(unsigned int address, unsigned int data)
 
           case 0x02:  /* PRG-RAM Write Protection */
           {
+#ifdef USE_THREADED_SCD
+            /* PRG-RAM write protection can not be modified while SUB-CPU is running on its own thread */
+            s68k_sync();
+#endif
             scd.regs[0x02>>1].byte.h = data;
             return;
           }
@@ -1034,7 +1046,13 @@ void ctrl_io_write_word(unsigned int address, unsigned int data)
         {
           case 0x00:  /* SUB-CPU interrupt & control */
           {
-            unsigned int halted = s68k.stopped;
+            unsigned int halted;
+
+#ifdef USE_THREADED_SCD
+            /* SUB-CPU state can not be modified while running on its own thread */
+            s68k_sync();
+#endif
+            halted = s68k.stopped;
 
             /* RESET bit */
             if (data & 0x01)
@@ -40,7 +40,7 @@
 #include "shared.h"
 
 
-t_zbank_memory_map zbank_memory_map[256];
+THREAD_LOCAL t_zbank_memory_map zbank_memory_map[256];
 
 /*
   Handlers for access to unused addresses and those which make the
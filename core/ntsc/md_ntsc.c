@@ -4,6 +4,7 @@
 
 #include "shared.h"
 #include "md_ntsc.h"
+#include "simd.h"
 
 /* Copyright (C) 2006 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
@@ -86,6 +87,117 @@ void md_ntsc_init( md_ntsc_t* ntsc, md_ntsc_setup_t const* setup )
 }
 
 #ifndef CUSTOM_BLITTER
+#ifdef HAVE_SIMD
+
+/* Output pixels are generated in two passes: kernels of each input pixel are first */
+/* added together eight entries at a time into partial sums (one array per kernel   */
+/* offset, with an extra chunk at start of line), which are then combined, clamped */
+/* and converted to output pixels eight at a time.                                  */
+#define MD_NTSC_MAX_CHUNKS (0x200 / md_ntsc_in_chunk)
+static THREAD_LOCAL md_ntsc_rgb_t md_ntsc_sum[4][(MD_NTSC_MAX_CHUNKS + 1) * md_ntsc_out_chunk];
+
+#define MD_NTSC_SUM( out, k, kx ) {\
+  SIMD_STORE( &(out)[0], SIMD_ADD32( SIMD_LOAD( &(k)[0] ), SIMD_LOAD( &(kx)[0] ) ) );\
+  SIMD_STORE( &(out)[4], SIMD_ADD32( SIMD_LOAD( &(k)[4] ), SIMD_LOAD( &(kx)[4] ) ) );\
+}
+
+INLINE simd_t md_ntsc_rgb_out( simd_t raw )
+{
+  simd_t sub = SIMD_AND( SIMD_SRL32( raw, 9 ), SIMD_SET32( md_ntsc_clamp_mask ) );
+  simd_t clamp = SIMD_SUB32( SIMD_SET32( md_ntsc_clamp_add ), sub );
+  raw = SIMD_OR( raw, clamp );
+  clamp = SIMD_SUB32( clamp, sub );
+  raw = SIMD_AND( raw, clamp );
+#if MD_NTSC_OUT_DEPTH == 15
+  return SIMD_OR( SIMD_OR( SIMD_AND( SIMD_SRL32( raw, 14 ), SIMD_SET32( 0x7C00 ) ),
+                           SIMD_AND( SIMD_SRL32( raw,  9 ), SIMD_SET32( 0x03E0 ) ) ),
+                           SIMD_AND( SIMD_SRL32( raw,  4 ), SIMD_SET32( 0x001F ) ) );
+#else
+  return SIMD_OR( SIMD_OR( SIMD_AND( SIMD_SRL32( raw, 13 ), SIMD_SET32( 0xF800 ) ),
+                           SIMD_AND( SIMD_SRL32( raw,  8 ), SIMD_SET32( 0x07E0 ) ) ),
+                           SIMD_AND( SIMD_SRL32( raw,  4 ), SIMD_SET32( 0x001F ) ) );
+#endif
+}
+
+void md_ntsc_blit( md_ntsc_t const* ntsc, MD_NTSC_IN_T const* table, unsigned char* input,
+                   int in_width, int vline)
+{
+  int const chunk_count = in_width / md_ntsc_in_chunk - 1;
+  int const out_width = (chunk_count + 1) * md_ntsc_out_chunk;
+
+  /* use palette entry 0 for unused pixels */
+  MD_NTSC_IN_T border = table[0];
+
+  MD_NTSC_BEGIN_ROW( ntsc, border,
+        MD_NTSC_ADJ_IN( table[*input++] ),
+        MD_NTSC_ADJ_IN( table[*input++] ),
+        MD_NTSC_ADJ_IN( table[*input++] ) );
+
+  md_ntsc_out_t* restrict line_out  = (md_ntsc_out_t*)(&bitmap.data[(vline * bitmap.pitch)]);
+
+  md_ntsc_rgb_t* s0 = md_ntsc_sum[0];
+  md_ntsc_rgb_t* s1 = md_ntsc_sum[1];
+  md_ntsc_rgb_t* s2 = md_ntsc_sum[2];
+  md_ntsc_rgb_t* s3 = md_ntsc_sum[3];
+
+  int n;
+
+  /* kernels of first pixels are already used by last output pixels of previous chunk */
+  MD_NTSC_SUM( s1, kernel1 + 16, kernelx1 + 24 );
+  MD_NTSC_SUM( s2, kernel2,      kernelx2 + 8 );
+  MD_NTSC_SUM( s3, kernel3 + 16, kernelx3 + 24 );
+
+  for ( n = chunk_count; n >= 0; --n )
+  {
+    s0 += md_ntsc_out_chunk;
+    s1 += md_ntsc_out_chunk;
+    s2 += md_ntsc_out_chunk;
+    s3 += md_ntsc_out_chunk;
+
+    MD_NTSC_COLOR_IN( 0, ntsc, MD_NTSC_ADJ_IN( table[*input++] ) );
+    MD_NTSC_SUM( s0, kernel0, kernelx0 + 8 );
+
+    if ( n )
+    {
+      MD_NTSC_COLOR_IN( 1, ntsc, MD_NTSC_ADJ_IN( table[*input++] ) );
+      MD_NTSC_COLOR_IN( 2, ntsc, MD_NTSC_ADJ_IN( table[*input++] ) );
+      MD_NTSC_COLOR_IN( 3, ntsc, MD_NTSC_ADJ_IN( table[*input++] ) );
+    }
+    else
+    {
+      /* finish final pixels */
+      MD_NTSC_COLOR_IN( 1, ntsc, border );
+      MD_NTSC_COLOR_IN( 2, ntsc, border );
+      MD_NTSC_COLOR_IN( 3, ntsc, border );
+    }
+
+    MD_NTSC_SUM( s1, kernel1 + 16, kernelx1 + 24 );
+    MD_NTSC_SUM( s2, kernel2,      kernelx2 + 8 );
+    MD_NTSC_SUM( s3, kernel3 + 16, kernelx3 + 24 );
+  }
+
+  /* output pixel x of each chunk uses kernel entry x of pixel 0, x-2 of pixel 1, x-4 of pixel 2 and x-6 of pixel 3 */
+  s0 = md_ntsc_sum[0] + 8;
+  s1 = md_ntsc_sum[1] + 6;
+  s2 = md_ntsc_sum[2] + 4;
+  s3 = md_ntsc_sum[3] + 2;
+
+  for ( n = 0; n + 8 <= out_width; n += 8 )
+  {
+    simd_t lo = SIMD_ADD32( SIMD_ADD32( SIMD_LOAD( &s0[n] ), SIMD_LOAD( &s1[n] ) ), SIMD_ADD32( SIMD_LOAD( &s2[n] ), SIMD_LOAD( &s3[n] ) ) );
+    simd_t hi = SIMD_ADD32( SIMD_ADD32( SIMD_LOAD( &s0[n+4] ), SIMD_LOAD( &s1[n+4] ) ), SIMD_ADD32( SIMD_LOAD( &s2[n+4] ), SIMD_LOAD( &s3[n+4] ) ) );
+    SIMD_STORE( &line_out[n], SIMD_PACK32( md_ntsc_rgb_out( lo ), md_ntsc_rgb_out( hi ) ) );
+  }
+
+  for ( ; n < out_width; n++ )
+  {
+    raw_ = s0[n] + s1[n] + s2[n] + s3[n];
+    MD_NTSC_CLAMP_( raw_, 0 );
+    MD_NTSC_RGB_OUT_( line_out[n], 0 );
+  }
+}
+
+#else
 void md_ntsc_blit( md_ntsc_t const* ntsc, MD_NTSC_IN_T const* table, unsigned char* input,
                    int in_width, int vline)
 {
@@ -141,3 +253,4 @@ void md_ntsc_blit( md_ntsc_t const* ntsc, MD_NTSC_IN_T const* table, unsigned ch
   MD_NTSC_RGB_OUT( 7, *line_out++ );
 }
 #endif
+#endif
@@ -101,7 +101,7 @@ Declares variables, so must be before first statement in a block (unless you're
 
 /* private */
 enum { md_ntsc_entry_size = 2 * 16 };
-typedef unsigned long md_ntsc_rgb_t;
+typedef unsigned int md_ntsc_rgb_t;
 struct md_ntsc_t {
   md_ntsc_rgb_t table [md_ntsc_palette_size] [md_ntsc_entry_size];
 };
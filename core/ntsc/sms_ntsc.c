@@ -4,6 +4,7 @@
 
 #include "shared.h"
 #include "sms_ntsc.h"
+#include "simd.h"
 
 /* Copyright (C) 2006-2007 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
@@ -85,6 +86,116 @@ void sms_ntsc_init( sms_ntsc_t* ntsc, sms_ntsc_setup_t const* setup )
 }
 
 #ifndef CUSTOM_BLITTER
+#ifdef HAVE_SIMD
+
+/* Output pixels are generated in two passes: kernels of each input pixel are first */
+/* added together eight entries at a time into partial sums (one array per kernel   */
+/* offset, with an extra chunk at start of line), which are then combined, clamped */
+/* and converted to output pixels eight at a time. Chunks being seven pixels wide,  */
+/* the last sum of each chunk is overwritten by the next one.                       */
+#define SMS_NTSC_MAX_CHUNKS (0x200 / sms_ntsc_in_chunk)
+static THREAD_LOCAL sms_ntsc_rgb_t sms_ntsc_sum[3][(SMS_NTSC_MAX_CHUNKS + 2) * sms_ntsc_out_chunk + 1];
+
+#define SMS_NTSC_SUM( out, k, kx ) {\
+  SIMD_STORE( &(out)[0], SIMD_ADD32( SIMD_LOAD( &(k)[0] ), SIMD_LOAD( &(kx)[0] ) ) );\
+  SIMD_STORE( &(out)[4], SIMD_ADD32( SIMD_LOAD( &(k)[4] ), SIMD_LOAD( &(kx)[4] ) ) );\
+}
+
+INLINE simd_t sms_ntsc_rgb_out( simd_t raw )
+{
+  simd_t sub = SIMD_AND( SIMD_SRL32( raw, 9 ), SIMD_SET32( sms_ntsc_clamp_mask ) );
+  simd_t clamp = SIMD_SUB32( SIMD_SET32( sms_ntsc_clamp_add ), sub );
+  raw = SIMD_OR( raw, clamp );
+  clamp = SIMD_SUB32( clamp, sub );
+  raw = SIMD_AND( raw, clamp );
+#if SMS_NTSC_OUT_DEPTH == 15
+  return SIMD_OR( SIMD_OR( SIMD_AND( SIMD_SRL32( raw, 14 ), SIMD_SET32( 0x7C00 ) ),
+                           SIMD_AND( SIMD_SRL32( raw,  9 ), SIMD_SET32( 0x03E0 ) ) ),
+                           SIMD_AND( SIMD_SRL32( raw,  4 ), SIMD_SET32( 0x001F ) ) );
+#else
+  return SIMD_OR( SIMD_OR( SIMD_AND( SIMD_SRL32( raw, 13 ), SIMD_SET32( 0xF800 ) ),
+                           SIMD_AND( SIMD_SRL32( raw,  8 ), SIMD_SET32( 0x07E0 ) ) ),
+                           SIMD_AND( SIMD_SRL32( raw,  4 ), SIMD_SET32( 0x001F ) ) );
+#endif
+}
+
+void sms_ntsc_blit( sms_ntsc_t const* ntsc, SMS_NTSC_IN_T const* table, unsigned char* input,
+                    int in_width, int vline)
+{
+  int n;
+  int const chunk_count = in_width / sms_ntsc_in_chunk;
+  int const out_width = (chunk_count + 1) * sms_ntsc_out_chunk;
+
+  /* handle extra 0, 1, or 2 pixels by placing them at beginning of row */
+  int const in_extra = in_width - chunk_count * sms_ntsc_in_chunk;
+  unsigned const extra2 = (unsigned) -(in_extra >> 1 & 1); /* (unsigned) -1 = ~0 */
+  unsigned const extra1 = (unsigned) -(in_extra & 1) | extra2;
+
+  /* use palette entry 0 for unused pixels */
+  SMS_NTSC_IN_T border = table[0];
+
+  SMS_NTSC_BEGIN_ROW( ntsc, border,
+      (SMS_NTSC_ADJ_IN( table[input[0]] )) & extra2,
+      (SMS_NTSC_ADJ_IN( table[input[extra2 & 1]] )) & extra1 );
+
+  sms_ntsc_out_t* line_out  = (sms_ntsc_out_t*)(&bitmap.data[(vline * bitmap.pitch)]);
+
+  sms_ntsc_rgb_t* s0 = sms_ntsc_sum[0];
+  sms_ntsc_rgb_t* s1 = sms_ntsc_sum[1];
+  sms_ntsc_rgb_t* s2 = sms_ntsc_sum[2];
+
+  input += in_extra;
+
+  /* kernels of first pixels are already used by last output pixels of previous chunk */
+  SMS_NTSC_SUM( s1, kernel1 + 14, kernelx1 + 21 );
+  SMS_NTSC_SUM( s2, kernel2 + 28, kernelx2 + 35 );
+
+  for ( n = chunk_count; n >= 0; --n )
+  {
+    s0 += sms_ntsc_out_chunk;
+    s1 += sms_ntsc_out_chunk;
+    s2 += sms_ntsc_out_chunk;
+
+    if ( n )
+    {
+      SMS_NTSC_COLOR_IN( 0, ntsc, SMS_NTSC_ADJ_IN( table[*input++] ) );
+      SMS_NTSC_COLOR_IN( 1, ntsc, SMS_NTSC_ADJ_IN( table[*input++] ) );
+      SMS_NTSC_COLOR_IN( 2, ntsc, SMS_NTSC_ADJ_IN( table[*input++] ) );
+    }
+    else
+    {
+      /* finish final pixels */
+      SMS_NTSC_COLOR_IN( 0, ntsc, border );
+      SMS_NTSC_COLOR_IN( 1, ntsc, border );
+      SMS_NTSC_COLOR_IN( 2, ntsc, border );
+    }
+
+    SMS_NTSC_SUM( s0, kernel0,      kernelx0 + 7 );
+    SMS_NTSC_SUM( s1, kernel1 + 14, kernelx1 + 21 );
+    SMS_NTSC_SUM( s2, kernel2 + 28, kernelx2 + 35 );
+  }
+
+  /* output pixel x of each chunk uses kernel entry x of pixel 0, x-2 of pixel 1 and x-4 of pixel 2 */
+  s0 = sms_ntsc_sum[0] + 7;
+  s1 = sms_ntsc_sum[1] + 5;
+  s2 = sms_ntsc_sum[2] + 3;
+
+  for ( n = 0; n + 8 <= out_width; n += 8 )
+  {
+    simd_t lo = SIMD_ADD32( SIMD_ADD32( SIMD_LOAD( &s0[n] ), SIMD_LOAD( &s1[n] ) ), SIMD_LOAD( &s2[n] ) );
+    simd_t hi = SIMD_ADD32( SIMD_ADD32( SIMD_LOAD( &s0[n+4] ), SIMD_LOAD( &s1[n+4] ) ), SIMD_LOAD( &s2[n+4] ) );
+    SIMD_STORE( &line_out[n], SIMD_PACK32( sms_ntsc_rgb_out( lo ), sms_ntsc_rgb_out( hi ) ) );
+  }
+
+  for ( ; n < out_width; n++ )
+  {
+    raw_ = s0[n] + s1[n] + s2[n];
+    SMS_NTSC_CLAMP_( raw_, 0 );
+    SMS_NTSC_RGB_OUT_( line_out[n], 0 );
+  }
+}
+
+#else
 void sms_ntsc_blit( sms_ntsc_t const* ntsc, SMS_NTSC_IN_T const* table, unsigned char* input,
                     int in_width, int vline)
 {
@@ -139,3 +250,4 @@ void sms_ntsc_blit( sms_ntsc_t const* ntsc, SMS_NTSC_IN_T const* table, unsigned
   SMS_NTSC_RGB_OUT( 6, *line_out++ );
 }
 #endif
+#endif
@@ -87,9 +87,10 @@ Declares variables, so must be before first statement in a block (unless you're
 
 /* private */
 enum { sms_ntsc_entry_size = 3 * 14 };
-typedef unsigned long sms_ntsc_rgb_t;
+typedef unsigned int sms_ntsc_rgb_t;
 struct sms_ntsc_t {
   sms_ntsc_rgb_t table [sms_ntsc_palette_size] [sms_ntsc_entry_size];
+  sms_ntsc_rgb_t padding; /* allows vector reads past last kernel entry */
 };
 
 #define SMS_NTSC_BGR12( ntsc, n ) (ntsc)->table [n & 0xFFF]
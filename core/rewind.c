@@ -0,0 +1,349 @@
+#include "shared.h"
+
+/* Rewind buffer
+
+   Snapshots are stored as delta savestates (see state.c), compressed with a simple
+   LZ77 scheme, in a ring arena allocated once on initialization. Deltas are XORed
+   with the previous snapshot, so the last snapshot is kept uncompressed and each
+   delta rebuilds the snapshot before it. Oldest snapshots are therefore discarded
+   without any other snapshot being modified, whenever arena or frame count limits
+   are reached. */
+
+/* LZ77 compression */
+#define LZ_HASH_BITS  12
+#define LZ_MIN_MATCH  4
+#define LZ_MAX_OFFSET 0xffff
+#define LZ_BOUND(n)   ((n) + ((n) / 255) + 16)
+
+typedef struct
+{
+  int offset;             /* arena offset */
+  int length;             /* stored size */
+} t_rewind_entry;
+
+typedef struct
+{
+  uint8 *arena;           /* compressed snapshots */
+  int arena_size;
+  int head;               /* arena offset of next snapshot */
+  int used;               /* arena bytes used by snapshots */
+  t_rewind_entry *entries;
+  int max_frames;
+  int first;              /* oldest snapshot */
+  int count;              /* number of snapshots */
+  uint8 *state;           /* last snapshot */
+  int state_size;         /* last snapshot size (0 if none) */
+  uint8 *current;         /* current savestate */
+  uint8 *delta;           /* current delta */
+  uint8 *packed;          /* compressed delta */
+  int *hash;              /* LZ77 match positions */
+} t_rewind;
+
+static THREAD_LOCAL t_rewind rwd;
+
+static uint32 lz_read32(const uint8 *src)
+{
+  uint32 data;
+  memcpy(&data, src, 4);
+  return data;
+}
+
+static int lz_length(uint8 *dst, int out, int length)
+{
+  /* lengths above 15 are extended with additional bytes */
+  while (length >= 255)
+  {
+    dst[out++] = 255;
+    length -= 255;
+  }
+  dst[out++] = length;
+  return out;
+}
+
+static int lz_sequence(uint8 *dst, int out, const uint8 *literals, int count, int offset, int length)
+{
+  /* token: literal count (4 bits) & match length (4 bits) */
+  int token = out++;
+  dst[token] = ((count < 15) ? count : 15) << 4;
+  if (count >= 15)
+  {
+    out = lz_length(dst, out, count - 15);
+  }
+
+  memcpy(&dst[out], literals, count);
+  out += count;
+
+  /* last sequence has no match */
+  if (length)
+  {
+    dst[out++] = offset & 0xff;
+    dst[out++] = offset >> 8;
+    length -= LZ_MIN_MATCH;
+    dst[token] |= (length < 15) ? length : 15;
+    if (length >= 15)
+    {
+      out = lz_length(dst, out, length - 15);
+    }
+  }
+
+  return out;
+}
+
+static int lz_compress(const uint8 *src, int size, uint8 *dst, int *hash)
+{
+  int pos = 0;
+  int anchor = 0;
+  int out = 0;
+
+  memset(hash, 0xff, sizeof(int) << LZ_HASH_BITS);
+
+  while ((pos + LZ_MIN_MATCH) <= size)
+  {
+    uint32 data = lz_read32(&src[pos]);
+    int h = (data * 2654435761U) >> (32 - LZ_HASH_BITS);
+    int ref = hash[h];
+    int length;
+
+    hash[h] = pos;
+
+    if ((ref < 0) || ((pos - ref) > LZ_MAX_OFFSET) || (lz_read32(&src[ref]) != data))
+    {
+      pos++;
+      continue;
+    }
+
+    length = LZ_MIN_MATCH;
+    while (((pos + length) < size) && (src[ref + length] == src[pos + length]))
+    {
+      length++;
+    }
+
+    out = lz_sequence(dst, out, &src[anchor], pos - anchor, pos - ref, length);
+    pos += length;
+    anchor = pos;
+  }
+
+  /* remaining literals */
+  return lz_sequence(dst, out, &src[anchor], size - anchor, 0, 0);
+}
+
+static int lz_decompress(const uint8 *src, int length, uint8 *dst)
+{
+  int in = 0;
+  int out = 0;
+
+  while (in < length)
+  {
+    int token = src[in++];
+    int count = token >> 4;
+    int offset;
+
+    if (count == 15)
+    {
+      do
+      {
+        count += src[in];
+      }
+      while (src[in++] == 255);
+    }
+
+    memcpy(&dst[out], &src[in], count);
+    in += count;
+    out += count;
+
+    if (in >= length)
+    {
+      break;
+    }
+
+    offset = src[in] | (src[in + 1] << 8);
+    in += 2;
+
+    count = token & 15;
+    if (count == 15)
+    {
+      do
+      {
+        count += src[in];
+      }
+      while (src[in++] == 255);
+    }
+    count += LZ_MIN_MATCH;
+
+    /* matches may overlap with output */
+    while (count--)
+    {
+      dst[out] = dst[out - offset];
+      out++;
+    }
+  }
+
+  return out;
+}
+
+static void rewind_discard(void)
+{
+  /* discard oldest snapshot */
+  rwd.used -= rwd.entries[rwd.first].length;
+  rwd.first = (rwd.first + 1) % rwd.max_frames;
+  rwd.count--;
+}
+
+int rewind_init(int frames, int size)
+{
+  /* Shutdown first */
+  rewind_shutdown();
+
+  if ((frames <= 0) || (size <= 0))
+  {
+    return -1;
+  }
+
+  rwd.arena = malloc(size);
+  rwd.entries = malloc(frames * sizeof(t_rewind_entry));
+  rwd.state = malloc(STATE_SIZE);
+  rwd.current = malloc(STATE_SIZE);
+  rwd.delta = malloc(STATE_DELTA_SIZE);
+  rwd.packed = malloc(4 + LZ_BOUND(STATE_DELTA_SIZE));
+  rwd.hash = malloc(sizeof(int) << LZ_HASH_BITS);
+
+  if (!rwd.arena || !rwd.entries || !rwd.state || !rwd.current || !rwd.delta || !rwd.packed || !rwd.hash)
+  {
+    rewind_shutdown();
+    return -1;
+  }
+
+  rwd.arena_size = size;
+  rwd.max_frames = frames;
+  rewind_reset();
+
+  return 0;
+}
+
+void rewind_shutdown(void)
+{
+  free(rwd.arena);
+  free(rwd.entries);
+  free(rwd.state);
+  free(rwd.current);
+  free(rwd.delta);
+  free(rwd.packed);
+  free(rwd.hash);
+  memset(&rwd, 0, sizeof(rwd));
+}
+
+void rewind_reset(void)
+{
+  rwd.head = 0;
+  rwd.used = 0;
+  rwd.first = 0;
+  rwd.count = 0;
+  rwd.state_size = 0;
+}
+
+void rewind_save(void)
+{
+  int size, length;
+
+  if (!rwd.arena)
+  {
+    return;
+  }
+
+  size = state_save(rwd.current);
+
+  /* first snapshot (or system changed) */
+  if (size != rwd.state_size)
+  {
+    rewind_reset();
+    memcpy(rwd.state, rwd.current, size);
+    rwd.state_size = size;
+    return;
+  }
+
+  /* delta between last and current snapshots, preceded by its size */
+  length = state_delta_encode(rwd.delta, rwd.current, rwd.state, size);
+  memcpy(rwd.packed, &length, 4);
+  length = 4 + lz_compress(rwd.delta, length, rwd.packed + 4, rwd.hash);
+
+  if (length > rwd.arena_size)
+  {
+    /* snapshot does not fit, history is lost */
+    rewind_reset();
+    rwd.state_size = size;
+  }
+  else
+  {
+    int end;
+
+    if (rwd.count == rwd.max_frames)
+    {
+      rewind_discard();
+    }
+
+    /* wrap to arena start, discarding older snapshots stored after head */
+    if ((rwd.head + length) > rwd.arena_size)
+    {
+      while (rwd.count && (rwd.entries[rwd.first].offset >= rwd.head))
+      {
+        rewind_discard();
+      }
+      rwd.head = 0;
+    }
+
+    /* discard snapshots overwritten by new one */
+    end = rwd.head + length;
+    while (rwd.count && (rwd.entries[rwd.first].offset < end) && ((rwd.entries[rwd.first].offset + rwd.entries[rwd.first].length) > rwd.head))
+    {
+      rewind_discard();
+    }
+
+    memcpy(&rwd.arena[rwd.head], rwd.packed, length);
+    rwd.entries[(rwd.first + rwd.count) % rwd.max_frames].offset = rwd.head;
+    rwd.entries[(rwd.first + rwd.count) % rwd.max_frames].length = length;
+    rwd.count++;
+    rwd.used += length;
+    rwd.head = end;
+  }
+
+  /* current savestate becomes last snapshot */
+  {
+    uint8 *temp = rwd.state;
+    rwd.state = rwd.current;
+    rwd.current = temp;
+  }
+}
+
+int rewind_load(void)
+{
+  int length;
+  t_rewind_entry *entry;
+
+  if (!rwd.count)
+  {
+    return 0;
+  }
+
+  /* most recent delta rebuilds previous snapshot */
+  rwd.count--;
+  entry = &rwd.entries[(rwd.first + rwd.count) % rwd.max_frames];
+  memcpy(&length, &rwd.arena[entry->offset], 4);
+  lz_decompress(&rwd.arena[entry->offset + 4], entry->length - 4, rwd.delta);
+  state_delta_apply(rwd.state, rwd.delta, length);
+
+  /* arena space is reused by next snapshot */
+  rwd.head = entry->offset;
+  rwd.used -= entry->length;
+
+  return state_restore(rwd.state) ? 1 : 0;
+}
+
+int rewind_frames(void)
+{
+  return rwd.count;
+}
+
+int rewind_used(void)
+{
+  return rwd.used;
+}
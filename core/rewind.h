@@ -0,0 +1,15 @@
+/* Rewind buffer of compressed delta snapshots (see rewind.c) */
+
+#ifndef _REWIND_H_
+#define _REWIND_H_
+
+/* Function prototypes */
+extern int rewind_init(int frames, int size);
+extern void rewind_shutdown(void);
+extern void rewind_reset(void);
+extern void rewind_save(void);
+extern int rewind_load(void);
+extern int rewind_frames(void);
+extern int rewind_used(void);
+
+#endif
@@ -0,0 +1,143 @@
+/* SIMD helpers shared by VDP pixel output, NTSC filters, YM2612 & PCM sound chips,  */
+/* 3-band EQ and blip_buf resampling routines                                        */
+
+#ifndef _SIMD_H_
+#define _SIMD_H_
+
+/* 128-bit vectors (SSE2 on x86, NEON on ARM) are used when supported by the target */
+/* AVX2 code paths are compiled separately and only selected at runtime             */
+/* Define DISABLE_SIMD to only use portable C code                                  */
+
+#ifndef DISABLE_SIMD
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+
+#include <emmintrin.h>
+
+#define HAVE_SIMD
+
+typedef __m128i simd_t;
+
+#define SIMD_LOAD(p)      _mm_loadu_si128((__m128i const *)(p))
+#define SIMD_STORE(p,v)   _mm_storeu_si128((__m128i *)(p), v)
+#define SIMD_AND(a,b)     _mm_and_si128(a, b)
+#define SIMD_OR(a,b)      _mm_or_si128(a, b)
+
+/* 4 x 32-bit / 8 x 16-bit lanes set from scalar values (first value in lowest lane) */
+#define SIMD_SET32X4(a,b,c,d)         _mm_set_epi32((int)(d), (int)(c), (int)(b), (int)(a))
+#define SIMD_SET16X8(a,b,c,d,e,f,g,h) _mm_set_epi16((short)(h), (short)(g), (short)(f), (short)(e), (short)(d), (short)(c), (short)(b), (short)(a))
+
+/* 4 x 32-bit lanes */
+#define SIMD_SET32(x)     _mm_set1_epi32((int)(x))
+#define SIMD_ADD32(a,b)   _mm_add_epi32(a, b)
+#define SIMD_SUB32(a,b)   _mm_sub_epi32(a, b)
+#define SIMD_SRL32(a,n)   _mm_srli_epi32(a, n)
+#define SIMD_SRA32(a,n)   _mm_srai_epi32(a, n)
+#define SIMD_SLL32(a,n)   _mm_slli_epi32(a, n)
+
+/* 8 x 16-bit lanes */
+#define SIMD_SET16(x)     _mm_set1_epi16((short)(x))
+#define SIMD_ADD16(a,b)   _mm_add_epi16(a, b)
+#define SIMD_SUBS16(a,b)  _mm_subs_epu16(a, b)
+#define SIMD_MUL16(a,b)   _mm_mullo_epi16(a, b)
+#define SIMD_SRL16(a,n)   _mm_srli_epi16(a, n)
+#define SIMD_SLL16(a,n)   _mm_slli_epi16(a, n)
+
+/* 8 x signed 16-bit lanes multiplied to 2 x 4 x 32-bit lanes (low / high lanes) */
+#define SIMD_MULS16L(a,b) _mm_unpacklo_epi16(_mm_mullo_epi16(a, b), _mm_mulhi_epi16(a, b))
+#define SIMD_MULS16H(a,b) _mm_unpackhi_epi16(_mm_mullo_epi16(a, b), _mm_mulhi_epi16(a, b))
+
+/* 8 x signed 16-bit lanes multiplied, adjacent products added to 4 x 32-bit lanes */
+#define SIMD_MADDS16(a,b) _mm_madd_epi16(a, b)
+
+/* 2 x 8 x 16-bit lanes interleaved (low / high lanes) */
+#define SIMD_ZIP16L(a,b)  _mm_unpacklo_epi16(a, b)
+#define SIMD_ZIP16H(a,b)  _mm_unpackhi_epi16(a, b)
+
+/* 2 x 4 x 32-bit lanes truncated to 8 x 16-bit lanes */
+#define SIMD_PACK32(a,b)  _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16), _mm_srai_epi32(_mm_slli_epi32(b, 16), 16))
+
+/* 4 x signed 32-bit lanes multiplied, 64-bit products shifted right by n (1-32) and truncated to 4 x 32-bit lanes */
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#define SIMD_MULS32SR(a,b,n)   _mm_blend_epi16(_mm_srli_epi64(_mm_mul_epi32(a, b), n), _mm_slli_epi64(_mm_mul_epi32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32)), 32 - (n)), 0xCC)
+#else
+/* SSE2 only has unsigned 32 x 32 -> 64-bit products (even lanes), so the sign correction is applied to high 32 bits */
+#define SIMD_MULS32_SIGN(a,b)  _mm_add_epi32(_mm_and_si128(_mm_srai_epi32(a, 31), b), _mm_and_si128(_mm_srai_epi32(b, 31), a))
+#define SIMD_MULS32_EVEN(a,b)  _mm_sub_epi64(_mm_mul_epu32(a, b), _mm_slli_epi64(SIMD_MULS32_SIGN(a, b), 32))
+#define SIMD_MULS32_ODD(a,b)   _mm_sub_epi64(_mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32)), _mm_and_si128(SIMD_MULS32_SIGN(a, b), _mm_set_epi32(-1, 0, -1, 0)))
+#define SIMD_MULS32SR(a,b,n)   _mm_or_si128(_mm_and_si128(_mm_srli_epi64(SIMD_MULS32_EVEN(a, b), n), _mm_set_epi32(0, -1, 0, -1)), _mm_and_si128(_mm_slli_epi64(SIMD_MULS32_ODD(a, b), 32 - (n)), _mm_set_epi32(-1, 0, -1, 0)))
+#endif
+
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#include <arm_neon.h>
+
+#define HAVE_SIMD
+
+typedef uint32x4_t simd_t;
+
+#define SIMD_U16(v)       vreinterpretq_u16_u32(v)
+#define SIMD_U32(v)       vreinterpretq_u32_u16(v)
+#define SIMD_S16(v)       vreinterpretq_s16_u32(v)
+#define SIMD_S32(v)       vreinterpretq_s32_u32(v)
+
+#define SIMD_LOAD(p)      vreinterpretq_u32_u8(vld1q_u8((uint8_t const *)(p)))
+#define SIMD_STORE(p,v)   vst1q_u8((uint8_t *)(p), vreinterpretq_u8_u32(v))
+#define SIMD_AND(a,b)     vandq_u32(a, b)
+#define SIMD_OR(a,b)      vorrq_u32(a, b)
+
+/* 4 x 32-bit / 8 x 16-bit lanes set from scalar values (first value in lowest lane) */
+#define SIMD_PAIR32(a,b)              ((uint64_t)(uint32_t)(a) | ((uint64_t)(uint32_t)(b) << 32))
+#define SIMD_QUAD16(a,b,c,d)          SIMD_PAIR32((uint16_t)(a) | ((uint32_t)(uint16_t)(b) << 16), (uint16_t)(c) | ((uint32_t)(uint16_t)(d) << 16))
+#define SIMD_SET32X4(a,b,c,d)         vcombine_u32(vcreate_u32(SIMD_PAIR32(a, b)), vcreate_u32(SIMD_PAIR32(c, d)))
+#define SIMD_SET16X8(a,b,c,d,e,f,g,h) vcombine_u32(vcreate_u32(SIMD_QUAD16(a, b, c, d)), vcreate_u32(SIMD_QUAD16(e, f, g, h)))
+
+/* 4 x 32-bit lanes */
+#define SIMD_SET32(x)     vdupq_n_u32((uint32_t)(x))
+#define SIMD_ADD32(a,b)   vaddq_u32(a, b)
+#define SIMD_SUB32(a,b)   vsubq_u32(a, b)
+#define SIMD_SRL32(a,n)   vshrq_n_u32(a, n)
+#define SIMD_SRA32(a,n)   vreinterpretq_u32_s32(vshrq_n_s32(vreinterpretq_s32_u32(a), n))
+#define SIMD_SLL32(a,n)   vshlq_n_u32(a, n)
+
+/* 8 x 16-bit lanes */
+#define SIMD_SET16(x)     SIMD_U32(vdupq_n_u16((uint16_t)(x)))
+#define SIMD_ADD16(a,b)   SIMD_U32(vaddq_u16(SIMD_U16(a), SIMD_U16(b)))
+#define SIMD_SUBS16(a,b)  SIMD_U32(vqsubq_u16(SIMD_U16(a), SIMD_U16(b)))
+#define SIMD_MUL16(a,b)   SIMD_U32(vmulq_u16(SIMD_U16(a), SIMD_U16(b)))
+#define SIMD_SRL16(a,n)   SIMD_U32(vshrq_n_u16(SIMD_U16(a), n))
+#define SIMD_SLL16(a,n)   SIMD_U32(vshlq_n_u16(SIMD_U16(a), n))
+
+/* 8 x signed 16-bit lanes multiplied to 2 x 4 x 32-bit lanes (low / high lanes) */
+#define SIMD_MULS16L(a,b) vreinterpretq_u32_s32(vmull_s16(vget_low_s16(SIMD_S16(a)), vget_low_s16(SIMD_S16(b))))
+#define SIMD_MULS16H(a,b) vreinterpretq_u32_s32(vmull_s16(vget_high_s16(SIMD_S16(a)), vget_high_s16(SIMD_S16(b))))
+
+/* 8 x signed 16-bit lanes multiplied, adjacent products added to 4 x 32-bit lanes */
+#define SIMD_PADD32(l,h)  vreinterpretq_u32_s32(vcombine_s32(vpadd_s32(vget_low_s32(l), vget_high_s32(l)), vpadd_s32(vget_low_s32(h), vget_high_s32(h))))
+#define SIMD_MADDS16(a,b) SIMD_PADD32(vreinterpretq_s32_u32(SIMD_MULS16L(a, b)), vreinterpretq_s32_u32(SIMD_MULS16H(a, b)))
+
+/* 2 x 8 x 16-bit lanes interleaved (low / high lanes) */
+#define SIMD_ZIP16L(a,b)  SIMD_U32(vzipq_u16(SIMD_U16(a), SIMD_U16(b)).val[0])
+#define SIMD_ZIP16H(a,b)  SIMD_U32(vzipq_u16(SIMD_U16(a), SIMD_U16(b)).val[1])
+
+/* 2 x 4 x 32-bit lanes truncated to 8 x 16-bit lanes */
+#define SIMD_PACK32(a,b)  SIMD_U32(vcombine_u16(vmovn_u32(a), vmovn_u32(b)))
+
+/* 4 x signed 32-bit lanes multiplied, 64-bit products shifted right by n (1-32) and truncated to 4 x 32-bit lanes */
+#define SIMD_MULS32SR(a,b,n)   vreinterpretq_u32_s32(vcombine_s32(vshrn_n_s64(vmull_s32(vget_low_s32(SIMD_S32(a)), vget_low_s32(SIMD_S32(b))), n), vshrn_n_s64(vmull_s32(vget_high_s32(SIMD_S32(a)), vget_high_s32(SIMD_S32(b))), n)))
+
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+/* AVX2 functions are compiled for that instruction set only, callers must check CPU support first */
+#define HAVE_SIMD_AVX2
+#define SIMD_AVX2_TARGET __attribute__((target("avx2")))
+#define SIMD_AVX2_SUPPORTED() __builtin_cpu_supports("avx2")
+
+#endif
+
+#endif /* DISABLE_SIMD */
+
+#endif /* _SIMD_H_ */
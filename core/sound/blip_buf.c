@@ -6,8 +6,10 @@
 /*  - added blip_mix_samples function (see blip_buf.h)              */
 /*  - added stereo buffer support (define #BLIP_MONO to disable)    */
 /*  - added inverted stereo output (define #BLIP_INVERT to enable)*/
+/*  - added batched delta functions, using SIMD when available      */
 
 #include "blip_buf.h"
+#include "simd.h"
 
 #ifdef BLIP_ASSERT
 #include <assert.h>
@@ -215,6 +217,63 @@ void blip_clear( blip_t* m )
 #endif
 }
 
+int blip_state_size( const blip_t* m )
+{
+#ifdef BLIP_MONO
+	return sizeof m->offset + sizeof m->integrator + (m->size + buf_extra) * sizeof (buf_t);
+#else
+	return sizeof m->offset + sizeof m->integrator + (m->size + buf_extra) * sizeof (buf_t) * 2;
+#endif
+}
+
+int blip_save_state( const blip_t* m, unsigned char state [] )
+{
+	/* samples after pending ones (and their deltas) are always cleared */
+	int count = (int) (m->offset >> time_bits) + buf_extra;
+	int size = 0;
+
+	memcpy( &state [size], &m->offset, sizeof m->offset );
+	size += sizeof m->offset;
+	memcpy( &state [size], &m->integrator, sizeof m->integrator );
+	size += sizeof m->integrator;
+#ifdef BLIP_MONO
+	memcpy( &state [size], SAMPLES( m ), count * sizeof (buf_t) );
+	size += count * sizeof (buf_t);
+#else
+	memcpy( &state [size], m->buffer[0], count * sizeof (buf_t) );
+	size += count * sizeof (buf_t);
+	memcpy( &state [size], m->buffer[1], count * sizeof (buf_t) );
+	size += count * sizeof (buf_t);
+#endif
+	return size;
+}
+
+int blip_load_state( blip_t* m, const unsigned char state [] )
+{
+	int count;
+	int size = 0;
+
+	memcpy( &m->offset, &state [size], sizeof m->offset );
+	size += sizeof m->offset;
+	memcpy( &m->integrator, &state [size], sizeof m->integrator );
+	size += sizeof m->integrator;
+
+	count = (int) (m->offset >> time_bits) + buf_extra;
+#ifdef BLIP_MONO
+	memcpy( SAMPLES( m ), &state [size], count * sizeof (buf_t) );
+	memset( SAMPLES( m ) + count, 0, (m->size + buf_extra - count) * sizeof (buf_t) );
+	size += count * sizeof (buf_t);
+#else
+	memcpy( m->buffer[0], &state [size], count * sizeof (buf_t) );
+	memset( m->buffer[0] + count, 0, (m->size + buf_extra - count) * sizeof (buf_t) );
+	size += count * sizeof (buf_t);
+	memcpy( m->buffer[1], &state [size], count * sizeof (buf_t) );
+	memset( m->buffer[1] + count, 0, (m->size + buf_extra - count) * sizeof (buf_t) );
+	size += count * sizeof (buf_t);
+#endif
+	return size;
+}
+
 int blip_clocks_needed( const blip_t* m, int samples )
 {
 	fixed_t needed;
@@ -328,6 +387,17 @@ int blip_read_samples( blip_t* m, short out [], int count)
 	return count;
 }
 
+int blip_discard_samples( blip_t* m, int count )
+{
+	if ( count > (m->offset >> time_bits) )
+		count = m->offset >> time_bits;
+
+	if ( count > 0 )
+		remove_samples( m, count );
+
+	return count;
+}
+
 int blip_mix_samples( blip_t* m1, blip_t* m2, blip_t* m3, short out [], int count)
 {
 #ifdef BLIP_ASSERT
@@ -627,6 +697,161 @@ void blip_add_delta_fast( blip_t* m, unsigned time, int delta_l, int delta_r )
   }
 }
 
+#ifdef HAVE_SIMD
+
+/* Band-limited step kernels: for each phase, first half holds bl_step [phase] taps and
+second half holds reversed bl_step [phase_count - phase] taps, as used by blip_add_delta() */
+static short blip_kernel [phase_count + 1] [half_width * 2];
+static int blip_kernel_init;
+
+static void make_kernel( void )
+{
+	int phase, i;
+
+	for ( phase = 0; phase <= phase_count; phase++ )
+	{
+		for ( i = 0; i < half_width; i++ )
+		{
+			blip_kernel [phase] [i] = bl_step [phase] [i];
+			blip_kernel [phase] [half_width * 2 - 1 - i] = bl_step [phase_count - phase] [i];
+		}
+	}
+
+	blip_kernel_init = 1;
+}
+
+/* Multiplies 16 taps (interleaved current & next phase kernel taps) by their respective delta.
+Deltas are split into high & low 15-bit parts so that 16-bit multiplications can be used, which
+gives the exact same 32-bit results as blip_add_delta() */
+static void mul_kernel( simd_t out [4], simd_t const taps [4], int delta, int delta2 )
+{
+	int i;
+	simd_t hi = SIMD_SET32( ((unsigned) ARITH_SHIFT( delta2, 15 ) << 16) | (ARITH_SHIFT( delta, 15 ) & 0xFFFF) );
+	simd_t lo = SIMD_SET32( ((unsigned) (delta2 & 0x7FFF) << 16) | (delta & 0x7FFF) );
+
+	for ( i = 0; i < 4; i++ )
+		out [i] = SIMD_ADD32( SIMD_SLL32( SIMD_MADDS16( taps [i], hi ), 15 ), SIMD_MADDS16( taps [i], lo ) );
+}
+
+static void add_kernel( buf_t* out, simd_t const in [4] )
+{
+	SIMD_STORE( &out [0],  SIMD_ADD32( SIMD_LOAD( &out [0] ),  in [0] ) );
+	SIMD_STORE( &out [4],  SIMD_ADD32( SIMD_LOAD( &out [4] ),  in [1] ) );
+	SIMD_STORE( &out [8],  SIMD_ADD32( SIMD_LOAD( &out [8] ),  in [2] ) );
+	SIMD_STORE( &out [12], SIMD_ADD32( SIMD_LOAD( &out [12] ), in [3] ) );
+}
+
+void blip_add_deltas( blip_t* m, unsigned time, unsigned period, const int deltas [], int count )
+{
+	fixed_t fixed_time = time * m->factor + m->offset;
+	fixed_t fixed_period = period * m->factor;
+
+	if ( !blip_kernel_init )
+		make_kernel();
+
+	for ( ; count > 0; count--, deltas += 2, fixed_time += fixed_period )
+	{
+		int delta_l = deltas [0];
+		int delta_r = deltas [1];
+
+		if (delta_l | delta_r)
+		{
+			unsigned fixed = (unsigned) (fixed_time >> pre_shift);
+			int phase = fixed >> phase_shift & (phase_count - 1);
+			int interp = fixed >> (phase_shift - delta_bits) & (delta_unit - 1);
+			int pos = fixed >> frac_bits;
+			short const* k = blip_kernel [phase];
+			simd_t taps [4], out [4];
+			simd_t k0, k1;
+			int delta;
+
+#ifdef BLIP_INVERT
+			buf_t* out_l = m->buffer[1] + pos;
+			buf_t* out_r = m->buffer[0] + pos;
+#else
+			buf_t* out_l = m->buffer[0] + pos;
+			buf_t* out_r = m->buffer[1] + pos;
+#endif
+
+#ifdef BLIP_ASSERT
+			/* Fails if buffer size was exceeded */
+			assert( pos <= m->size + end_frame_extra );
+#endif
+
+			/* current & next phase kernel taps */
+			k0 = SIMD_LOAD( &k [0] );
+			k1 = SIMD_LOAD( &k [half_width * 2] );
+			taps [0] = SIMD_ZIP16L( k0, k1 );
+			taps [1] = SIMD_ZIP16H( k0, k1 );
+			k0 = SIMD_LOAD( &k [half_width] );
+			k1 = SIMD_LOAD( &k [half_width * 3] );
+			taps [2] = SIMD_ZIP16L( k0, k1 );
+			taps [3] = SIMD_ZIP16H( k0, k1 );
+
+			delta = (delta_l * interp) >> delta_bits;
+			mul_kernel( out, taps, delta_l - delta, delta );
+			add_kernel( out_l, out );
+
+			if (delta_l != delta_r)
+			{
+				delta = (delta_r * interp) >> delta_bits;
+				mul_kernel( out, taps, delta_r - delta, delta );
+			}
+			add_kernel( out_r, out );
+		}
+	}
+}
+
+#else
+
+void blip_add_deltas( blip_t* m, unsigned time, unsigned period, const int deltas [], int count )
+{
+	for ( ; count > 0; count--, deltas += 2, time += period )
+		blip_add_delta( m, time, deltas [0], deltas [1] );
+}
+
+#endif
+
+void blip_add_deltas_fast( blip_t* m, unsigned time, unsigned period, const int deltas [], int count )
+{
+	fixed_t fixed_time = time * m->factor + m->offset;
+	fixed_t fixed_period = period * m->factor;
+
+	for ( ; count > 0; count--, deltas += 2, fixed_time += fixed_period )
+	{
+		int delta_l = deltas [0];
+		int delta_r = deltas [1];
+
+		if (delta_l | delta_r)
+		{
+			unsigned fixed = (unsigned) (fixed_time >> pre_shift);
+			int interp = fixed >> (frac_bits - delta_bits) & (delta_unit - 1);
+			int pos = fixed >> frac_bits;
+
+#ifdef BLIP_INVERT
+			buf_t* out_l = m->buffer[1] + pos;
+			buf_t* out_r = m->buffer[0] + pos;
+#else
+			buf_t* out_l = m->buffer[0] + pos;
+			buf_t* out_r = m->buffer[1] + pos;
+#endif
+
+			int delta = delta_l * interp;
+
+#ifdef BLIP_ASSERT
+			/* Fails if buffer size was exceeded */
+			assert( pos <= m->size + end_frame_extra );
+#endif
+
+			out_l[7] += delta_l * delta_unit - delta;
+			out_l[8] += delta;
+			delta = delta_r * interp;
+			out_r[7] += delta_r * delta_unit - delta;
+			out_r[8] += delta;
+		}
+	}
+}
+
 #else
 
 void blip_add_delta( blip_t* m, unsigned time, int delta )
@@ -683,4 +908,16 @@ void blip_add_delta_fast( blip_t* m, unsigned time, int delta )
 	out [7] += delta * delta_unit - delta2;
 	out [8] += delta2;
 }
+
+void blip_add_deltas( blip_t* m, unsigned time, unsigned period, const int deltas [], int count )
+{
+	for ( ; count > 0; count--, deltas++, time += period )
+		blip_add_delta( m, time, *deltas );
+}
+
+void blip_add_deltas_fast( blip_t* m, unsigned time, unsigned period, const int deltas [], int count )
+{
+	for ( ; count > 0; count--, deltas++, time += period )
+		blip_add_delta_fast( m, time, *deltas );
+}
 #endif
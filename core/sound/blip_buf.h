@@ -36,6 +36,14 @@ void blip_add_delta( blip_t*, unsigned time, int delta_l, int delta_r );
 /** Same as blip_add_delta(), but uses faster, lower-quality synthesis. */
 void blip_add_delta_fast( blip_t*, unsigned int clock_time, int delta_l, int delta_r );
 
+/** Adds 'count' pairs of left & right deltas (interleaved) into stereo buffers, first one
+at specified clock time, then every 'period' clocks. Same as calling blip_add_delta() for
+each pair, but faster. */
+void blip_add_deltas( blip_t*, unsigned int clock_time, unsigned int period, const int deltas [], int count );
+
+/** Same as blip_add_deltas(), but uses faster, lower-quality synthesis. */
+void blip_add_deltas_fast( blip_t*, unsigned int clock_time, unsigned int period, const int deltas [], int count );
+
 #else
 
 /** Adds positive/negative delta into buffer at specified clock time. */
@@ -44,6 +52,13 @@ void blip_add_delta( blip_t*, unsigned int clock_time, int delta );
 /** Same as blip_add_delta(), but uses faster, lower-quality synthesis. */
 void blip_add_delta_fast( blip_t*, unsigned int clock_time, int delta );
 
+/** Adds 'count' deltas into buffer, first one at specified clock time, then every 'period'
+clocks. Same as calling blip_add_delta() for each delta, but faster. */
+void blip_add_deltas( blip_t*, unsigned int clock_time, unsigned int period, const int deltas [], int count );
+
+/** Same as blip_add_deltas(), but uses faster, lower-quality synthesis. */
+void blip_add_deltas_fast( blip_t*, unsigned int clock_time, unsigned int period, const int deltas [], int count );
+
 #endif
 
 /** Length of time frame, in clocks, needed to make sample_count additional
@@ -71,6 +86,20 @@ int blip_read_samples( blip_t*, short out [], int count);
 /* Same as above function except sample is mixed from three blip buffers source */
 int blip_mix_samples( blip_t* m1, blip_t* m2, blip_t* m3, short out [], int count);
 
+/** Removes at most 'count' samples without reading them. Returns number of samples
+actually removed. */
+int blip_discard_samples( blip_t*, int count );
+
+/** Size of state saved by blip_save_state(), in bytes. */
+int blip_state_size( const blip_t* );
+
+/** Saves buffered samples and synthesis state, so that anything added after
+can be discarded by blip_load_state(). Returns number of bytes written. */
+int blip_save_state( const blip_t*, unsigned char state [] );
+
+/** Restores buffer as saved by blip_save_state(). Returns number of bytes read. */
+int blip_load_state( blip_t*, const unsigned char state [] );
+
 /** Frees buffer. No effect if NULL is passed. */
 void blip_delete( blip_t* );
 
@@ -22,7 +22,9 @@
 //
 // - Uses 4 first order filters in series, should give 24dB per octave
 //
-// - Now with P4 Denormal fix :)
+// - Now using fixed point arithmetic (no more denormals), with both stereo
+//   channels processed at once (4 filters in parallel, using SIMD if available),
+//   double precision being kept for filter frequencies above fixed point range
 
 
 //----------------------------------------------------------------------------*/
@@ -35,6 +37,7 @@
 #include <math.h>
 #include "eq.h"
 #include "macros.h"
+#include "simd.h"
 
 
 /* -----------
@@ -43,6 +46,11 @@
 
 static double vsa = (1.0 / 4294967295.0); /* Very small amount (Denormal Fix) */
 
+/* Maximal filter frequency processed with fixed point arithmetic: each pole gain */
+/* is at most f / (2 - f), so 4 poles in series never exceed 20.12 fixed point    */
+/* range (16-bit samples with 4 bits of headroom) as long as f <= 1.25           */
+#define EQ_FIXED_MAX_FREQ 1.25
+
 
 /* ---------------
 //| Initialise EQ |
@@ -57,76 +65,217 @@ static double vsa = (1.0 / 4294967295.0); /* Very small amount (Denormal Fix) */
 
 void init_3band_state(EQSTATE * es, int lowfreq, int highfreq, int mixfreq)
 {
+    double lf, hf;
+
     /* Clear state */
 
     memset(es, 0, sizeof(EQSTATE));
 
     /* Set Low/Mid/High gains to unity */
 
-    es->lg = 1.0;
-    es->mg = 1.0;
-    es->hg = 1.0;
+    es->lg = 0x10000;
+    es->mg = 0x10000;
+    es->hg = 0x10000;
+
+    /* Calculate filter cutoff frequencies (0.0 to 2.0) */
+
+    lf = 2 * sin(M_PI * ((double) lowfreq / (double) mixfreq));
+    hf = 2 * sin(M_PI * ((double) highfreq / (double) mixfreq));
+
+    es->f[0] = es->f[1] = (int32_t) (lf * (1 << 29));
+    es->f[2] = es->f[3] = (int32_t) (hf * (1 << 29));
 
-    /* Calculate filter cutoff frequencies */
+    es->df[0] = es->df[1] = lf;
+    es->df[2] = es->df[3] = hf;
 
-    es->lf = 2 * sin(M_PI * ((double) lowfreq / (double) mixfreq));
-    es->hf = 2 * sin(M_PI * ((double) highfreq / (double) mixfreq));
+    /* Use fixed point arithmetic when poles can not exceed fixed point range */
+
+    es->fixed = (lf <= EQ_FIXED_MAX_FREQ) && (hf <= EQ_FIXED_MAX_FREQ);
 }
 
 
-/* ---------------
-//| EQ one sample |
-// ---------------*/
+/* ------------------
+//| EQ stereo buffer |
+// ------------------*/
 
-/* - sample can be any range you like :)
+/* - buffer holds interleaved 16-bit stereo samples, which are replaced by
+//   EQ output (clipped to 16-bit), optionally mixed to mono
 //
 // Note that the output will depend on the gain settings for each band 
 // (especially the bass) so may require clipping before output, but you 
 // knew that anyway :)*/
 
-double do_3band(EQSTATE * es, int sample)
+#ifdef HAVE_SIMD
+
+/* Left & right channels lanes */
+static const int32_t eq_lanes[2][4] = {{-1, 0, -1, 0}, {0, -1, 0, -1}};
+
+/* p += f * (in - p), for all 4 filters */
+INLINE simd_t eq_pole(simd_t p, simd_t in, simd_t f)
+{
+    return SIMD_ADD32(p, SIMD_MULS32SR(f, SIMD_SUB32(in, p), 29));
+}
+
+#endif
+
+static void do_3band_double(EQSTATE * es, short * buffer, int samples, int mono)
 {
     /* Locals */
 
+    int i;
+    double x[4];      /* Input samples (left, right, left, right) */
     double l, m, h;   /* Low / Mid / High - Sample Values */
+    int out[2];
+
+    double lg = es->lg / 65536.0;
+    double mg = es->mg / 65536.0;
+    double hg = es->hg / 65536.0;
 
-    /* Filter #1 (lowpass) */
+    do
+    {
+        x[0] = x[2] = buffer[0];
+        x[1] = x[3] = buffer[1];
 
-    es->f1p0 += (es->lf * ((double) sample - es->f1p0)) + vsa;
-    es->f1p1 += (es->lf * (es->f1p0 - es->f1p1));
-    es->f1p2 += (es->lf * (es->f1p1 - es->f1p2));
-    es->f1p3 += (es->lf * (es->f1p2 - es->f1p3));
+        /* Filter #1 (lowpass) & Filter #2 (highpass) */
 
-    l = es->f1p3;
+        for (i = 0; i < 4; i++)
+        {
+            es->dp[0][i] += (es->df[i] * (x[i] - es->dp[0][i])) + vsa;
+            es->dp[1][i] += (es->df[i] * (es->dp[0][i] - es->dp[1][i]));
+            es->dp[2][i] += (es->df[i] * (es->dp[1][i] - es->dp[2][i]));
+            es->dp[3][i] += (es->df[i] * (es->dp[2][i] - es->dp[3][i]));
+        }
 
-    /* Filter #2 (highpass) */
+        for (i = 0; i < 2; i++)
+        {
+            l = es->dp[3][i];
+            h = es->dsdm[2][i] - es->dp[3][i + 2];
 
-    es->f2p0 += (es->hf * ((double) sample - es->f2p0)) + vsa;
-    es->f2p1 += (es->hf * (es->f2p0 - es->f2p1));
-    es->f2p2 += (es->hf * (es->f2p1 - es->f2p2));
-    es->f2p3 += (es->hf * (es->f2p2 - es->f2p3));
+            /* Calculate midrange (signal - (low + high)) */
 
-    h = es->sdm3 - es->f2p3;
+            m = x[i] - (h + l);
 
-    /* Calculate midrange (signal - (low + high)) */
+            /* Scale, Combine & clip */
 
-    /* m = es->sdm3 - (h + l); */
-    /* fix from http://www.musicdsp.org/showArchiveComment.php?ArchiveID=236 ? */
-    m = sample - (h + l);
+            out[i] = (int) (l * lg + m * mg + h * hg);
+            if (out[i] > 32767) out[i] = 32767;
+            else if (out[i] < -32768) out[i] = -32768;
 
-    /* Scale, Combine and store */
+            /* Shuffle history buffer */
 
-    l *= es->lg;
-    m *= es->mg;
-    h *= es->hg;
+            es->dsdm[2][i] = es->dsdm[1][i];
+            es->dsdm[1][i] = es->dsdm[0][i];
+            es->dsdm[0][i] = x[i];
+        }
 
-    /* Shuffle history buffer */
+        /* Mono output mixing */
 
-    es->sdm3 = es->sdm2;
-    es->sdm2 = es->sdm1;
-    es->sdm1 = sample;
+        if (mono)
+        {
+            out[0] = out[1] = (out[0] + out[1]) / 2;
+        }
 
-    /* Return result */
+        *buffer++ = out[0];
+        *buffer++ = out[1];
+    }
+    while (--samples);
+}
+
+void do_3band(EQSTATE * es, short * buffer, int samples, int mono)
+{
+    /* Locals */
 
-    return (int) (l + m + h);
+    int i;
+    int32_t x[4];      /* Input samples (left, right, left, right) */
+    int32_t *lp;       /* Filter outputs */
+    int64_t l, m, h;   /* Low / Mid / High - Sample Values */
+    int out[2];
+
+#ifdef HAVE_SIMD
+    int32_t y[4];
+    simd_t lmask = SIMD_LOAD(eq_lanes[0]);
+    simd_t rmask = SIMD_LOAD(eq_lanes[1]);
+    simd_t f  = SIMD_LOAD(es->f);
+    simd_t p0 = SIMD_LOAD(es->p[0]);
+    simd_t p1 = SIMD_LOAD(es->p[1]);
+    simd_t p2 = SIMD_LOAD(es->p[2]);
+    simd_t p3 = SIMD_LOAD(es->p[3]);
+    lp = y;
+#else
+    lp = es->p[3];
+#endif
+
+    if (samples <= 0) return;
+
+    if (!es->fixed)
+    {
+        do_3band_double(es, buffer, samples, mono);
+        return;
+    }
+
+    do
+    {
+        /* 20.12 fixed point */
+
+        x[0] = x[2] = buffer[0] * (1 << 12);
+        x[1] = x[3] = buffer[1] * (1 << 12);
+
+        /* Filter #1 (lowpass) & Filter #2 (highpass) */
+
+#ifdef HAVE_SIMD
+        p0 = eq_pole(p0, SIMD_OR(SIMD_AND(SIMD_SET32(x[0]), lmask), SIMD_AND(SIMD_SET32(x[1]), rmask)), f);
+        p1 = eq_pole(p1, p0, f);
+        p2 = eq_pole(p2, p1, f);
+        p3 = eq_pole(p3, p2, f);
+        SIMD_STORE(y, p3);
+#else
+        for (i = 0; i < 4; i++)
+        {
+            es->p[0][i] += (int32_t) (((int64_t) es->f[i] * (x[i] - es->p[0][i])) >> 29);
+            es->p[1][i] += (int32_t) (((int64_t) es->f[i] * (es->p[0][i] - es->p[1][i])) >> 29);
+            es->p[2][i] += (int32_t) (((int64_t) es->f[i] * (es->p[1][i] - es->p[2][i])) >> 29);
+            es->p[3][i] += (int32_t) (((int64_t) es->f[i] * (es->p[2][i] - es->p[3][i])) >> 29);
+        }
+#endif
+
+        for (i = 0; i < 2; i++)
+        {
+            l = lp[i];
+            h = (int64_t) es->sdm[2][i] - lp[i + 2];
+
+            /* Calculate midrange (signal - (low + high)) */
+
+            m = x[i] - (h + l);
+
+            /* Scale, Combine (16.16 x 20.12 fixed point) & clip */
+
+            out[i] = (int) ((l * es->lg + m * es->mg + h * es->hg) >> 28);
+            if (out[i] > 32767) out[i] = 32767;
+            else if (out[i] < -32768) out[i] = -32768;
+
+            /* Shuffle history buffer */
+
+            es->sdm[2][i] = es->sdm[1][i];
+            es->sdm[1][i] = es->sdm[0][i];
+            es->sdm[0][i] = x[i];
+        }
+
+        /* Mono output mixing */
+
+        if (mono)
+        {
+            out[0] = out[1] = (out[0] + out[1]) / 2;
+        }
+
+        *buffer++ = out[0];
+        *buffer++ = out[1];
+    }
+    while (--samples);
+
+#ifdef HAVE_SIMD
+    SIMD_STORE(es->p[0], p0);
+    SIMD_STORE(es->p[1], p1);
+    SIMD_STORE(es->p[2], p2);
+    SIMD_STORE(es->p[3], p3);
+#endif
 }
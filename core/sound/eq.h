@@ -19,38 +19,50 @@
 #ifndef __EQ3BAND__
 #define __EQ3BAND__
 
+/* ----------
+//| Includes |
+// ----------*/
+
+#include <stdint.h>
+
+
 /* ------------
 //| Structures |
 // ------------*/
 
+/* Stereo EQ state, using fixed point arithmetic. Low band & high band filters of */
+/* both channels are processed in parallel, using 4 lanes:                         */
+/* left low band, right low band, left high band, right high band                  */
+/* Double precision is used for filter frequencies above fixed point range.        */
+
 typedef struct {
-    /* Filter #1 (Low band) */
+    /* Filter frequencies (3.29 fixed point) */
+
+    int32_t f[4];
+
+    /* Filter poles (20.12 fixed point) */
+
+    int32_t p[4][4];
+
+    /* Sample history buffer (20.12 fixed point, left & right channels) */
 
-    double lf;      /* Frequency */
-    double f1p0;      /* Poles ... */
-    double f1p1;
-    double f1p2;
-    double f1p3;
+    int32_t sdm[3][2];
 
-    /* Filter #2 (High band) */
+    /* Double precision filter frequencies, poles & sample history buffer */
 
-    double hf;      /* Frequency */
-    double f2p0;      /* Poles ... */
-    double f2p1;
-    double f2p2;
-    double f2p3;
+    double df[4];
+    double dp[4][4];
+    double dsdm[3][2];
 
-    /* Sample history buffer */
+    /* Fixed point arithmetic enabled */
 
-    double sdm1;      /* Sample data minus 1 */
-    double sdm2;      /*                   2 */
-    double sdm3;      /*                   3 */
+    int fixed;
 
-    /* Gain Controls */
+    /* Gain controls (16.16 fixed point) */
 
-    double lg;      /* low  gain */
-    double mg;      /* mid  gain */
-    double hg;      /* high gain */
+    int32_t lg;      /* low  gain */
+    int32_t mg;      /* mid  gain */
+    int32_t hg;      /* high gain */
 
 } EQSTATE;
 
@@ -61,7 +73,7 @@ typedef struct {
 
 extern void init_3band_state(EQSTATE * es, int lowfreq, int highfreq,
            int mixfreq);
-extern double do_3band(EQSTATE * es, int sample);
+extern void do_3band(EQSTATE * es, short * buffer, int samples, int mono);
 
 
 #endif        /* #ifndef __EQ3BAND__ */
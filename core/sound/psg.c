@@ -74,7 +74,7 @@ static const uint16 chanVolume[16] = {
   0                             /*  OFF  */
 };
 
-static struct
+static THREAD_LOCAL struct
 {
   int clocks;
   int latch;
@@ -222,6 +222,25 @@ int psg_context_load(uint8 *state)
   return bufferptr;
 }
 
+/* pending channel output variations, not included in savestates (see sound_output_save) */
+int psg_output_save(uint8 *state)
+{
+  int bufferptr = 0;
+
+  save_param(psg.chanDelta,sizeof(psg.chanDelta));
+
+  return bufferptr;
+}
+
+int psg_output_load(uint8 *state)
+{
+  int bufferptr = 0;
+
+  load_param(psg.chanDelta,sizeof(psg.chanDelta));
+
+  return bufferptr;
+}
+
 void psg_write(unsigned int clocks, unsigned int data)
 {
   int index;
@@ -461,14 +480,17 @@ static void psg_update(unsigned int clocks)
     /* apply any pending channel volume variations */
     if (psg.chanDelta[i][0] | psg.chanDelta[i][1])
     {
-      /* update channel output */
-      if (config.hq_psg)
-      {
-        blip_add_delta(snd.blips[0], psg.clocks, psg.chanDelta[i][0], psg.chanDelta[i][1]);
-      }
-      else
+      /* update channel output (if sound emulation is enabled) */
+      if (snd.enabled)
       {
-        blip_add_delta_fast(snd.blips[0], psg.clocks, psg.chanDelta[i][0], psg.chanDelta[i][1]);
+        if (config.hq_psg)
+        {
+          blip_add_delta(snd.blips[0], psg.clocks, psg.chanDelta[i][0], psg.chanDelta[i][1]);
+        }
+        else
+        {
+          blip_add_delta_fast(snd.blips[0], psg.clocks, psg.chanDelta[i][0], psg.chanDelta[i][1]);
+        }
       }
 
       /* clear pending channel volume variations */
@@ -485,24 +507,45 @@ static void psg_update(unsigned int clocks)
     /* Tone channels */
     if (i < 3)
     {
-      /* process all transitions occurring until current clock timestamp */
-      while (timestamp < clocks)
+      /* sound emulation disabled: skip all transitions occurring until current clock timestamp */
+      if (!snd.enabled)
       {
-        /* invert tone generator polarity */
-        polarity = -polarity;
-
-        /* update channel output */
-        if (config.hq_psg)
+        if (timestamp < clocks)
         {
-          blip_add_delta(snd.blips[0], timestamp, polarity*psg.chanOut[i][0], polarity*psg.chanOut[i][1]);
+          /* number of transitions */
+          int count = (clocks - timestamp + psg.freqInc[i] - 1) / psg.freqInc[i];
+
+          /* tone generator polarity is inverted on each transition */
+          if (count & 1)
+          {
+            polarity = -polarity;
+          }
+
+          /* timestamp of next transition */
+          timestamp += (count * psg.freqInc[i]);
         }
-        else
+      }
+      else
+      {
+        /* process all transitions occurring until current clock timestamp */
+        while (timestamp < clocks)
         {
-          blip_add_delta_fast(snd.blips[0], timestamp, polarity*psg.chanOut[i][0], polarity*psg.chanOut[i][1]);
-        }
+          /* invert tone generator polarity */
+          polarity = -polarity;
 
-        /* timestamp of next transition */
-        timestamp += psg.freqInc[i];
+          /* update channel output */
+          if (config.hq_psg)
+          {
+            blip_add_delta(snd.blips[0], timestamp, polarity*psg.chanOut[i][0], polarity*psg.chanOut[i][1]);
+          }
+          else
+          {
+            blip_add_delta_fast(snd.blips[0], timestamp, polarity*psg.chanOut[i][0], polarity*psg.chanOut[i][1]);
+          }
+
+          /* timestamp of next transition */
+          timestamp += psg.freqInc[i];
+        }
       }
     }
 
@@ -541,14 +584,17 @@ static void psg_update(unsigned int clocks)
           /* shift register output variation */
           shiftOutput = (shiftValue & 0x1) - shiftOutput;
 
-          /* update noise channel output */
-          if (config.hq_psg)
-          {
-            blip_add_delta(snd.blips[0], timestamp, shiftOutput*psg.chanOut[3][0], shiftOutput*psg.chanOut[3][1]);
-          }
-          else
+          /* update noise channel output (if sound emulation is enabled) */
+          if (snd.enabled)
           {
-            blip_add_delta_fast(snd.blips[0], timestamp, shiftOutput*psg.chanOut[3][0], shiftOutput*psg.chanOut[3][1]);
+            if (config.hq_psg)
+            {
+              blip_add_delta(snd.blips[0], timestamp, shiftOutput*psg.chanOut[3][0], shiftOutput*psg.chanOut[3][1]);
+            }
+            else
+            {
+              blip_add_delta_fast(snd.blips[0], timestamp, shiftOutput*psg.chanOut[3][0], shiftOutput*psg.chanOut[3][1]);
+            }
           }
         }
 
@@ -45,39 +45,40 @@
 
 /* FM output buffer (large enough to hold a whole frame at original chips rate) */
 #if defined(HAVE_YM3438_CORE) || defined(HAVE_OPLL_CORE)
-static int fm_buffer[1080 * 2 * 24];
+static THREAD_LOCAL int fm_buffer[1080 * 2 * 24];
 #else
-static int fm_buffer[1080 * 2];
+static THREAD_LOCAL int fm_buffer[1080 * 2];
 #endif
 
-static int fm_last[2];
-static int *fm_ptr;
+static THREAD_LOCAL int fm_last[2];
+static THREAD_LOCAL int *fm_ptr;
 
 /* Cycle-accurate FM samples */
-static int fm_cycles_ratio;
-static int fm_cycles_start;
-static int fm_cycles_count;
-static int fm_cycles_busy;
+static THREAD_LOCAL int fm_cycles_ratio;
+static THREAD_LOCAL int fm_cycles_start;
+static THREAD_LOCAL int fm_cycles_count;
+static THREAD_LOCAL int fm_cycles_busy;
 
 /* YM chip function pointers */
-static void (*YM_Update)(int *buffer, int length);
-void (*fm_reset)(unsigned int cycles);
-void (*fm_write)(unsigned int cycles, unsigned int address, unsigned int data);
-unsigned int (*fm_read)(unsigned int cycles, unsigned int address);
+static THREAD_LOCAL void (*YM_Update)(int *buffer, int length);
+static THREAD_LOCAL void (*YM_Timers)(int length);
+THREAD_LOCAL void (*fm_reset)(unsigned int cycles);
+THREAD_LOCAL void (*fm_write)(unsigned int cycles, unsigned int address, unsigned int data);
+THREAD_LOCAL unsigned int (*fm_read)(unsigned int cycles, unsigned int address);
 
 #ifdef HAVE_YM3438_CORE
-static ym3438_t ym3438;
-static short ym3438_accm[24][2];
-static int ym3438_sample[2];
-static int ym3438_cycles;
+static THREAD_LOCAL ym3438_t ym3438;
+static THREAD_LOCAL short ym3438_accm[24][2];
+static THREAD_LOCAL int ym3438_sample[2];
+static THREAD_LOCAL int ym3438_cycles;
 #endif
 
 #ifdef HAVE_OPLL_CORE
-static opll_t opll;
-static int opll_accm[18][2];
-static int opll_sample;
-static int opll_cycles;
-static int opll_status;
+static THREAD_LOCAL opll_t opll;
+static THREAD_LOCAL int opll_accm[18][2];
+static THREAD_LOCAL int opll_sample;
+static THREAD_LOCAL int opll_cycles;
+static THREAD_LOCAL int opll_status;
 #endif
 
 /* Run FM chip until required M-cycles */
@@ -88,11 +89,19 @@ INLINE void fm_update(int cycles)
     /* number of samples to run */
     int samples = (cycles - fm_cycles_count + fm_cycles_ratio - 1) / fm_cycles_ratio;
 
-    /* run FM chip to sample buffer */
-    YM_Update(fm_ptr, samples);
+    if (snd.enabled || !YM_Timers)
+    {
+      /* run FM chip to sample buffer */
+      YM_Update(fm_ptr, samples);
 
-    /* update FM buffer pointer */
-    fm_ptr += (samples * 2);
+      /* update FM buffer pointer */
+      fm_ptr += (samples * 2);
+    }
+    else
+    {
+      /* only run FM chip timers when sound emulation is disabled */
+      YM_Timers(samples);
+    }
 
     /* update FM cycle counter */
     fm_cycles_count += (samples * fm_cycles_ratio);
@@ -175,6 +184,11 @@ static void YM2413_Write(unsigned int cycles, unsigned int a, unsigned int v)
   YM2413Write(a, v);
 }
 
+static void YM2413_Timers(int length)
+{
+  /* YM2413 has no timers */
+}
+
 static unsigned int YM2413_Read(unsigned int cycles, unsigned int a)
 {
     return YM2413Read();
@@ -184,12 +198,31 @@ static unsigned int YM2413_Read(unsigned int cycles, unsigned int a)
 static void YM3438_Update(int *buffer, int length)
 {
   int i, j;
-  for (i = 0; i < length; i++)
+  while (length > 0)
   {
-    OPN2_Clock(&ym3438, ym3438_accm[ym3438_cycles]);
-    ym3438_cycles = (ym3438_cycles + 1) % 24;
-    if (ym3438_cycles == 0)
+    /* clock chip until end of current sample (24 cycles) */
+    int count = 24 - ym3438_cycles;
+    if (count > length)
+    {
+      count = length;
+    }
+
+    for (i = 0; i < count; i++)
     {
+      OPN2_Clock(&ym3438, ym3438_accm[ym3438_cycles++]);
+    }
+    length -= count;
+
+    /* previous sample output */
+    for (i = 1; i < count; i++)
+    {
+      *buffer++ = ym3438_sample[0] * 11;
+      *buffer++ = ym3438_sample[1] * 11;
+    }
+
+    if (ym3438_cycles == 24)
+    {
+      ym3438_cycles = 0;
       ym3438_sample[0] = 0;
       ym3438_sample[1] = 0;
       for (j = 0; j < 24; j++)
@@ -198,6 +231,7 @@ static void YM3438_Update(int *buffer, int length)
         ym3438_sample[1] += ym3438_accm[j][1];
       }
     }
+
     *buffer++ = ym3438_sample[0] * 11;
     *buffer++ = ym3438_sample[1] * 11;
   }
@@ -298,6 +332,7 @@ void sound_init( void )
       memset(&ym3438_sample, 0, sizeof(ym3438_sample));
       memset(&ym3438_accm, 0, sizeof(ym3438_accm));
       YM_Update = YM3438_Update;
+      YM_Timers = NULL;
       fm_reset = YM3438_Reset;
       fm_write = YM3438_Write;
       fm_read = YM3438_Read;
@@ -312,6 +347,7 @@ void sound_init( void )
       YM2612Init();
       YM2612Config(config.ym2612);
       YM_Update = YM2612Update;
+      YM_Timers = YM2612UpdateTimers;
       fm_reset = YM2612_Reset;
       fm_write = YM2612_Write;
       fm_read = YM2612_Read;
@@ -332,6 +368,7 @@ void sound_init( void )
       opll_sample = 0;
       opll_status = 0;
       YM_Update = (config.ym2413 & 1) ? OPLL2413_Update : NULL;
+      YM_Timers = NULL;
       fm_reset = OPLL2413_Reset;
       fm_write = OPLL2413_Write;
       fm_read = OPLL2413_Read;
@@ -344,6 +381,7 @@ void sound_init( void )
     {
       YM2413Init();
       YM_Update = (config.ym2413 & 1) ? YM2413Update : NULL;
+      YM_Timers = YM2413_Timers;
       fm_reset = YM2413_Reset;
       fm_write = YM2413_Write;
       fm_read = YM2413_Read;
@@ -401,32 +439,21 @@ int sound_update(unsigned int cycles)
     ptr = fm_buffer;
 
     /* flush FM samples */
-    if (config.hq_fm)
+    if (!snd.enabled)
     {
-      /* high-quality Band-Limited synthesis */
-      do
-      {
-        /* left & right channels */
-        l = ((*ptr++ * preamp) / 100);
-        r = ((*ptr++ * preamp) / 100);
-        blip_add_delta(snd.blips[0], time, l-prev_l, r-prev_r);
-        prev_l = l;
-        prev_r = r;
-
-        /* increment time counter */
-        time += fm_cycles_ratio;
-      }
-      while (time < cycles);
+      /* sound emulation disabled: no FM samples to flush */
+      time = fm_cycles_count;
     }
     else
     {
-      /* faster Linear Interpolation */
+      /* FM samples are replaced by output deltas */
       do
       {
         /* left & right channels */
-        l = ((*ptr++ * preamp) / 100);
-        r = ((*ptr++ * preamp) / 100);
-        blip_add_delta_fast(snd.blips[0], time, l-prev_l, r-prev_r);
+        l = ((ptr[0] * preamp) / 100);
+        r = ((ptr[1] * preamp) / 100);
+        *ptr++ = l - prev_l;
+        *ptr++ = r - prev_r;
         prev_l = l;
         prev_r = r;
 
@@ -434,6 +461,17 @@ int sound_update(unsigned int cycles)
         time += fm_cycles_ratio;
       }
       while (time < cycles);
+
+      if (config.hq_fm)
+      {
+        /* high-quality Band-Limited synthesis */
+        blip_add_deltas(snd.blips[0], fm_cycles_start, fm_cycles_ratio, fm_buffer, (ptr - fm_buffer) >> 1);
+      }
+      else
+      {
+        /* faster Linear Interpolation */
+        blip_add_deltas_fast(snd.blips[0], fm_cycles_start, fm_cycles_ratio, fm_buffer, (ptr - fm_buffer) >> 1);
+      }
     }
 
     /* reset FM buffer pointer */
@@ -511,6 +549,29 @@ int sound_context_save(uint8 *state)
   return bufferptr;
 }
 
+/* FM & PSG output, FM busy state, not included in savestates (see audio_context_save) */
+int sound_output_save(uint8 *state)
+{
+  int bufferptr = 0;
+
+  save_param(fm_last, sizeof(fm_last));
+  save_param(&fm_cycles_busy, sizeof(fm_cycles_busy));
+  bufferptr += psg_output_save(&state[bufferptr]);
+
+  return bufferptr;
+}
+
+int sound_output_load(uint8 *state)
+{
+  int bufferptr = 0;
+
+  load_param(fm_last, sizeof(fm_last));
+  load_param(&fm_cycles_busy, sizeof(fm_cycles_busy));
+  bufferptr += psg_output_load(&state[bufferptr]);
+
+  return bufferptr;
+}
+
 int sound_context_load(uint8 *state)
 {
   int bufferptr = 0;
@@ -45,9 +45,11 @@ extern void sound_init(void);
 extern void sound_reset(void);
 extern int sound_context_save(uint8 *state);
 extern int sound_context_load(uint8 *state);
+extern int sound_output_save(uint8 *state);
+extern int sound_output_load(uint8 *state);
 extern int sound_update(unsigned int cycles);
-extern void (*fm_reset)(unsigned int cycles);
-extern void (*fm_write)(unsigned int cycles, unsigned int address, unsigned int data);
-extern unsigned int (*fm_read)(unsigned int cycles, unsigned int address);
+extern THREAD_LOCAL void (*fm_reset)(unsigned int cycles);
+extern THREAD_LOCAL void (*fm_write)(unsigned int cycles, unsigned int address, unsigned int data);
+extern THREAD_LOCAL unsigned int (*fm_read)(unsigned int cycles, unsigned int address);
 
 #endif /* _SOUND_H_ */
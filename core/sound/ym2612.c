@@ -148,6 +148,11 @@
 /************************************************************************/
 
 #include "shared.h"
+#include "simd.h"
+
+#ifdef HAVE_SIMD_AVX2
+#include <immintrin.h>
+#endif
 
 /* envelope generator */
 #define ENV_BITS    10
@@ -625,16 +630,16 @@ typedef struct
 } YM2612;
 
 /* emulated chip */
-static YM2612 ym2612;
+static THREAD_LOCAL YM2612 ym2612;
 
 /* current chip state */
-static INT32  m2,c1,c2;   /* Phase Modulation input for operators 2,3,4 */
-static INT32  mem;        /* one sample delay memory */
-static INT32  out_fm[6];  /* outputs of working channels */
+static THREAD_LOCAL INT32  m2,c1,c2;   /* Phase Modulation input for operators 2,3,4 */
+static THREAD_LOCAL INT32  mem;        /* one sample delay memory */
+static THREAD_LOCAL INT32  out_fm[6];  /* outputs of working channels */
 
 /* chip type */
-static UINT32 op_mask[8][4];  /* operator output bitmasking (DAC quantization) */
-static int chip_type = YM2612_DISCRETE;
+static THREAD_LOCAL UINT32 op_mask[8][4];  /* operator output bitmasking (DAC quantization) */
+static THREAD_LOCAL int chip_type = YM2612_DISCRETE;
 
 
 INLINE void FM_KEYON(FM_CH *CH , int s )
@@ -1433,6 +1438,35 @@ INLINE signed int op_calc1(UINT32 phase, unsigned int env, unsigned int pm, unsi
   return (tl_tab[p] & opmask);
 }
 
+INLINE void update_phase_channel(FM_CH *CH)
+{
+  if (CH->pms)
+  {
+    /* 3-slot mode */
+    if ((ym2612.OPN.ST.mode & 0xC0) && (CH == &ym2612.CH[2]))
+    {
+      /* keyscale code is not modifiedby LFO */
+      UINT8 kc = ym2612.CH[2].kcode;
+      UINT32 pm = ym2612.CH[2].pms + ym2612.OPN.LFO_PM;
+      update_phase_lfo_slot(&ym2612.CH[2].SLOT[SLOT1], pm, kc, ym2612.OPN.SL3.block_fnum[1]);
+      update_phase_lfo_slot(&ym2612.CH[2].SLOT[SLOT2], pm, kc, ym2612.OPN.SL3.block_fnum[2]);
+      update_phase_lfo_slot(&ym2612.CH[2].SLOT[SLOT3], pm, kc, ym2612.OPN.SL3.block_fnum[0]);
+      update_phase_lfo_slot(&ym2612.CH[2].SLOT[SLOT4], pm, kc, ym2612.CH[2].block_fnum);
+    }
+    else
+    {
+      update_phase_lfo_channel(CH);
+    }
+  }
+  else  /* no LFO phase modulation */
+  {
+    CH->SLOT[SLOT1].phase += CH->SLOT[SLOT1].Incr;
+    CH->SLOT[SLOT2].phase += CH->SLOT[SLOT2].Incr;
+    CH->SLOT[SLOT3].phase += CH->SLOT[SLOT3].Incr;
+    CH->SLOT[SLOT4].phase += CH->SLOT[SLOT4].Incr;
+  }
+}
+
 INLINE void chan_calc(FM_CH *CH, int num)
 {
   do
@@ -1481,37 +1515,235 @@ INLINE void chan_calc(FM_CH *CH, int num)
     CH->mem_value = mem;
 
     /* update phase counters AFTER output calculations */
-    if (CH->pms)
+    update_phase_channel(CH);
+
+    /* next channel */
+    CH++;
+  } while (--num);
+}
+
+#ifdef HAVE_SIMD_AVX2
+
+/* AVX2 block rendering                                                                                  */
+/*                                                                                                       */
+/* Phase and envelope generators, LFO and timers never depend on operators outputs, so samples are      */
+/* rendered in two passes: the first one only runs these (scalar) units and records each operator phase */
+/* and attenuation, the second one evaluates operators of all channels in parallel (one channel per     */
+/* 32-bit lane) then mixes channels outputs. Operators connections are converted to bitmasks and, like  */
+/* other channel parameters, cannot be modified during YM2612Update().                                  */
+#define FM_BLOCK_LEN 64
+
+typedef struct
+{
+  UINT32 phase[4][8];   /* SLOT1, SLOT2, SLOT3, SLOT4 phase counters */
+  UINT32 env[4][8];     /* SLOT1, SLOT2, SLOT3, SLOT4 attenuation (including LFO AM) */
+} FM_SAMPLE_VEC;
+
+typedef struct
+{
+  INT32 active[8];      /* channel enabled mask (channel 6 is disabled in DAC mode) */
+  INT32 op1_out[2][8];  /* op1 output for feedback */
+  INT32 mem_value[8];   /* delayed sample (MEM) value */
+  INT32 fb_shift[8];    /* feedback shift */
+  INT32 fb_mask[8];     /* feedback enabled mask */
+  INT32 opmask[4][8];   /* operator output bitmasks (SLOT1, SLOT2, SLOT3, SLOT4) */
+  INT32 mem_m2[8];      /* MEM restored to m2 */
+  INT32 mem_c2[8];      /* MEM restored to c2 */
+  INT32 mem_mem[8];     /* MEM not used */
+  INT32 op1_c1[8];      /* SLOT1 output to c1 */
+  INT32 op1_mem[8];     /* SLOT1 output to MEM */
+  INT32 op1_c2[8];      /* SLOT1 output to c2 */
+  INT32 op1_out_fm[8];  /* SLOT1 output to channel output */
+  INT32 op3_c2[8];      /* SLOT3 output to c2 */
+  INT32 op3_out_fm[8];  /* SLOT3 output to channel output */
+  INT32 op2_mem[8];     /* SLOT2 output to MEM */
+  INT32 op2_out_fm[8];  /* SLOT2 output to channel output */
+  INT32 out_fm[8];      /* disabled channels output (DAC) */
+  INT32 pan[2][8];      /* left & right output masks */
+  INT32 ladder_p[8];    /* DAC 'ladder effect' offset on positive output */
+  INT32 ladder_n[2][8]; /* DAC 'ladder effect' left & right offsets on negative output */
+} FM_CH_VEC;
+
+static THREAD_LOCAL FM_SAMPLE_VEC fm_block[FM_BLOCK_LEN];
+static THREAD_LOCAL FM_CH_VEC ch_vec;
+
+/* AVX2 block rendering enabled (set on initialization, shared by all threads) */
+static int chan_avx2;
+
+static void chan_setup_avx2(int num)
+{
+  int c, s;
+
+  memset(&ch_vec, 0, sizeof(ch_vec));
+
+  for (c=0; c<6; c++)
+  {
+    FM_CH *CH = &ym2612.CH[c];
+    INT32 *carrier = &out_fm[c];
+
+    ch_vec.active[c]     = (c < num) ? -1 : 0;
+    ch_vec.op1_out[0][c] = CH->op1_out[0];
+    ch_vec.op1_out[1][c] = CH->op1_out[1];
+    ch_vec.mem_value[c]  = CH->mem_value;
+    ch_vec.fb_shift[c]   = (CH->FB < SIN_BITS) ? CH->FB : 0;
+    ch_vec.fb_mask[c]    = (CH->FB < SIN_BITS) ? -1 : 0;
+
+    for (s=0; s<4; s++)
     {
-      /* 3-slot mode */
-      if ((ym2612.OPN.ST.mode & 0xC0) && (CH == &ym2612.CH[2]))
-      {
-        /* keyscale code is not modifiedby LFO */
-        UINT8 kc = ym2612.CH[2].kcode;
-        UINT32 pm = ym2612.CH[2].pms + ym2612.OPN.LFO_PM;
-        update_phase_lfo_slot(&ym2612.CH[2].SLOT[SLOT1], pm, kc, ym2612.OPN.SL3.block_fnum[1]);
-        update_phase_lfo_slot(&ym2612.CH[2].SLOT[SLOT2], pm, kc, ym2612.OPN.SL3.block_fnum[2]);
-        update_phase_lfo_slot(&ym2612.CH[2].SLOT[SLOT3], pm, kc, ym2612.OPN.SL3.block_fnum[0]);
-        update_phase_lfo_slot(&ym2612.CH[2].SLOT[SLOT4], pm, kc, ym2612.CH[2].block_fnum);
-      }
-      else
-      {
-        update_phase_lfo_channel(CH);
-      }
+      ch_vec.opmask[s][c] = op_mask[CH->ALGO][s];
     }
-    else  /* no LFO phase modulation */
+
+    ch_vec.mem_m2[c]     = (CH->mem_connect == &m2) ? -1 : 0;
+    ch_vec.mem_c2[c]     = (CH->mem_connect == &c2) ? -1 : 0;
+    ch_vec.mem_mem[c]    = (CH->mem_connect == &mem) ? -1 : 0;
+    ch_vec.op1_c1[c]     = (!CH->connect1 || (CH->connect1 == &c1)) ? -1 : 0;
+    ch_vec.op1_mem[c]    = (!CH->connect1 || (CH->connect1 == &mem)) ? -1 : 0;
+    ch_vec.op1_c2[c]     = (!CH->connect1 || (CH->connect1 == &c2)) ? -1 : 0;
+    ch_vec.op1_out_fm[c] = (CH->connect1 == carrier) ? -1 : 0;
+    ch_vec.op3_c2[c]     = (CH->connect3 == &c2) ? -1 : 0;
+    ch_vec.op3_out_fm[c] = (CH->connect3 == carrier) ? -1 : 0;
+    ch_vec.op2_mem[c]    = (CH->connect2 == &mem) ? -1 : 0;
+    ch_vec.op2_out_fm[c] = (CH->connect2 == carrier) ? -1 : 0;
+
+    ch_vec.pan[0][c] = ym2612.OPN.pan[(2*c)+0];
+    ch_vec.pan[1][c] = ym2612.OPN.pan[(2*c)+1];
+
+    /* discrete YM2612 DAC */
+    if (chip_type == YM2612_DISCRETE)
     {
-      CH->SLOT[SLOT1].phase += CH->SLOT[SLOT1].Incr;
-      CH->SLOT[SLOT2].phase += CH->SLOT[SLOT2].Incr;
-      CH->SLOT[SLOT3].phase += CH->SLOT[SLOT3].Incr;
-      CH->SLOT[SLOT4].phase += CH->SLOT[SLOT4].Incr;
+      ch_vec.ladder_p[c]    = (4 << 5);
+      ch_vec.ladder_n[0][c] = -((4 - (ym2612.OPN.pan[(2*c)+0] & 1)) << 5);
+      ch_vec.ladder_n[1][c] = -((4 - (ym2612.OPN.pan[(2*c)+1] & 1)) << 5);
     }
+  }
+
+  /* DAC Mode */
+  if (num < 6)
+  {
+    ch_vec.out_fm[5] = ym2612.dacout;
+  }
+}
+
+static void chan_store_avx2(int num)
+{
+  int c;
+
+  for (c=0; c<num; c++)
+  {
+    ym2612.CH[c].op1_out[0] = ch_vec.op1_out[0][c];
+    ym2612.CH[c].op1_out[1] = ch_vec.op1_out[1][c];
+    ym2612.CH[c].mem_value  = ch_vec.mem_value[c];
+  }
+}
+
+/* record operators inputs for one sample then update phase counters */
+INLINE void chan_record(FM_SAMPLE_VEC *rec, int num)
+{
+  FM_CH *CH = &ym2612.CH[0];
+  int c = 0;
+
+  do
+  {
+    UINT32 AM = ym2612.OPN.LFO_AM >> CH->ams;
+
+    rec->phase[0][c] = CH->SLOT[SLOT1].phase;
+    rec->phase[1][c] = CH->SLOT[SLOT2].phase;
+    rec->phase[2][c] = CH->SLOT[SLOT3].phase;
+    rec->phase[3][c] = CH->SLOT[SLOT4].phase;
+    rec->env[0][c] = volume_calc(&CH->SLOT[SLOT1]);
+    rec->env[1][c] = volume_calc(&CH->SLOT[SLOT2]);
+    rec->env[2][c] = volume_calc(&CH->SLOT[SLOT3]);
+    rec->env[3][c] = volume_calc(&CH->SLOT[SLOT4]);
+
+    update_phase_channel(CH);
 
     /* next channel */
     CH++;
-  } while (--num);
+  } while (++c < num);
+}
+
+#define CH_VEC(field) _mm256_loadu_si256((__m256i const *)ch_vec.field)
+#define REC_VEC(field) _mm256_loadu_si256((__m256i const *)rec->field)
+
+SIMD_AVX2_TARGET INLINE __m256i op_calc_avx2(__m256i phase, __m256i env, __m256i pm, __m256i opmask)
+{
+  /* output is also zero when env >= ENV_QUIET */
+  __m256i p = _mm256_and_si256(_mm256_add_epi32(_mm256_srli_epi32(phase, SIN_BITS), pm), _mm256_set1_epi32(SIN_MASK));
+  p = _mm256_add_epi32(_mm256_slli_epi32(env, 3), _mm256_i32gather_epi32((int const *)sin_tab, p, 4));
+  p = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), tl_tab, p, _mm256_cmpgt_epi32(_mm256_set1_epi32(TL_TAB_LEN), p), 4);
+  return _mm256_and_si256(p, opmask);
+}
+
+SIMD_AVX2_TARGET static void chan_render_avx2(int *buffer, int length)
+{
+  const FM_SAMPLE_VEC *rec = fm_block;
+  __m256i op1_out0 = CH_VEC(op1_out[0]);
+  __m256i op1_out1 = CH_VEC(op1_out[1]);
+  __m256i mem_value = CH_VEC(mem_value);
+  __m256i vm2, vc1, vc2, vmem, out, carrier, lt, rt;
+  __m128i sum;
+
+  do
+  {
+    /* restore delayed sample (MEM) value to m2 or c2 */
+    vm2  = _mm256_and_si256(mem_value, CH_VEC(mem_m2));
+    vc2  = _mm256_and_si256(mem_value, CH_VEC(mem_c2));
+    vmem = _mm256_and_si256(mem_value, CH_VEC(mem_mem));
+
+    /* SLOT 1 */
+    out = _mm256_and_si256(_mm256_srav_epi32(_mm256_add_epi32(op1_out0, op1_out1), CH_VEC(fb_shift)), CH_VEC(fb_mask));
+    out = op_calc_avx2(REC_VEC(phase[0]), REC_VEC(env[0]), out, CH_VEC(opmask[0]));
+    op1_out0 = op1_out1;
+    op1_out1 = out;
+    vc1     = _mm256_and_si256(out, CH_VEC(op1_c1));
+    vmem    = _mm256_add_epi32(vmem, _mm256_and_si256(out, CH_VEC(op1_mem)));
+    vc2     = _mm256_add_epi32(vc2, _mm256_and_si256(out, CH_VEC(op1_c2)));
+    carrier = _mm256_and_si256(out, CH_VEC(op1_out_fm));
+
+    /* SLOT 3 */
+    out = op_calc_avx2(REC_VEC(phase[2]), REC_VEC(env[2]), _mm256_srai_epi32(vm2, 1), CH_VEC(opmask[2]));
+    vc2     = _mm256_add_epi32(vc2, _mm256_and_si256(out, CH_VEC(op3_c2)));
+    carrier = _mm256_add_epi32(carrier, _mm256_and_si256(out, CH_VEC(op3_out_fm)));
+
+    /* SLOT 2 */
+    out = op_calc_avx2(REC_VEC(phase[1]), REC_VEC(env[1]), _mm256_srai_epi32(vc1, 1), CH_VEC(opmask[1]));
+    vmem    = _mm256_add_epi32(vmem, _mm256_and_si256(out, CH_VEC(op2_mem)));
+    carrier = _mm256_add_epi32(carrier, _mm256_and_si256(out, CH_VEC(op2_out_fm)));
+
+    /* SLOT 4 */
+    out = op_calc_avx2(REC_VEC(phase[3]), REC_VEC(env[3]), _mm256_srai_epi32(vc2, 1), CH_VEC(opmask[3]));
+    carrier = _mm256_add_epi32(carrier, out);
+
+    /* store current MEM */
+    mem_value = vmem;
+
+    /* disabled channels output */
+    carrier = _mm256_blendv_epi8(CH_VEC(out_fm), carrier, CH_VEC(active));
+
+    /* channels accumulator output clipping (14-bit max) */
+    carrier = _mm256_max_epi32(_mm256_min_epi32(carrier, _mm256_set1_epi32(8191)), _mm256_set1_epi32(-8192));
+
+    /* stereo DAC output panning & mixing, including DAC 'ladder effect' */
+    out = _mm256_cmpgt_epi32(_mm256_setzero_si256(), carrier);
+    lt  = _mm256_add_epi32(_mm256_and_si256(carrier, CH_VEC(pan[0])), _mm256_blendv_epi8(CH_VEC(ladder_p), CH_VEC(ladder_n[0]), out));
+    rt  = _mm256_add_epi32(_mm256_and_si256(carrier, CH_VEC(pan[1])), _mm256_blendv_epi8(CH_VEC(ladder_p), CH_VEC(ladder_n[1]), out));
+    lt  = _mm256_hadd_epi32(lt, rt);
+    lt  = _mm256_hadd_epi32(lt, lt);
+    sum = _mm_add_epi32(_mm256_castsi256_si128(lt), _mm256_extracti128_si256(lt, 1));
+
+    /* buffering */
+    _mm_storel_epi64((__m128i *)buffer, sum);
+    buffer += 2;
+    rec++;
+  } while (--length);
+
+  _mm256_storeu_si256((__m256i *)ch_vec.op1_out[0], op1_out0);
+  _mm256_storeu_si256((__m256i *)ch_vec.op1_out[1], op1_out1);
+  _mm256_storeu_si256((__m256i *)ch_vec.mem_value, mem_value);
 }
 
+#endif
+
 /* write a OPN mode register 0x20-0x2f */
 INLINE void OPNWriteMode(int r, int v)
 {
@@ -1906,6 +2138,7 @@ void YM2612Init(void)
 {
   memset(&ym2612,0,sizeof(YM2612));
   init_tables();
+  YM2612ConfigSIMD(1);
 }
 
 /* reset OPN registers */
@@ -2002,6 +2235,48 @@ unsigned int YM2612Read(void)
   return ym2612.OPN.ST.status;
 }
 
+/* EG is updated every 3 samples */
+INLINE void advance_eg(void)
+{
+  ym2612.OPN.eg_timer++;
+  if (ym2612.OPN.eg_timer >= 3)
+  {
+    /* reset EG timer */
+    ym2612.OPN.eg_timer = 0;
+
+    /* increment EG counter */
+    ym2612.OPN.eg_cnt++;
+
+    /* EG counter is 12-bit only and zero value is skipped (verified on real hardware) */
+    if (ym2612.OPN.eg_cnt == 4096)
+      ym2612.OPN.eg_cnt = 1;
+
+    /* advance envelope generator */
+    advance_eg_channels(&ym2612.CH[0], ym2612.OPN.eg_cnt);
+  }
+}
+
+INLINE void update_timer_a(void)
+{
+  /* CSM mode: if CSM Key ON has occurred, CSM Key OFF need to be sent      */
+  /* only if Timer A does not overflow again (i.e CSM Key ON not set again) */
+  ym2612.OPN.SL3.key_csm <<= 1;
+
+  /* timer A control */
+  INTERNAL_TIMER_A();
+
+  /* CSM Mode Key ON still disabled */
+  if (ym2612.OPN.SL3.key_csm & 2)
+  {
+    /* CSM Mode Key OFF (verified by Nemesis on real hardware) */
+    FM_KEYOFF_CSM(&ym2612.CH[2],SLOT1);
+    FM_KEYOFF_CSM(&ym2612.CH[2],SLOT2);
+    FM_KEYOFF_CSM(&ym2612.CH[2],SLOT3);
+    FM_KEYOFF_CSM(&ym2612.CH[2],SLOT4);
+    ym2612.OPN.SL3.key_csm = 0;
+  }
+}
+
 /* Generate samples for ym2612 */
 void YM2612Update(int *buffer, int length)
 {
@@ -2032,6 +2307,51 @@ void YM2612Update(int *buffer, int length)
   refresh_fc_eg_chan(&ym2612.CH[4]);
   refresh_fc_eg_chan(&ym2612.CH[5]);
 
+#ifdef HAVE_SIMD_AVX2
+  if (chan_avx2)
+  {
+    /* DAC Mode: channel 6 is not calculated */
+    int num = ym2612.dacen ? 5 : 6;
+    int samples = length;
+
+    chan_setup_avx2(num);
+
+    while (samples > 0)
+    {
+      int block = (samples < FM_BLOCK_LEN) ? samples : FM_BLOCK_LEN;
+
+      for (i=0; i<block; i++)
+      {
+        /* update SSG-EG output */
+        update_ssg_eg_channels(&ym2612.CH[0]);
+
+        /* record operators phase & attenuation */
+        chan_record(&fm_block[i], num);
+
+        /* advance LFO */
+        advance_lfo();
+
+        /* advance envelope generator */
+        advance_eg();
+
+        /* timer A control & CSM mode */
+        update_timer_a();
+      }
+
+      /* calculate FM & mix recorded samples */
+      chan_render_avx2(buffer, block);
+      buffer += block * 2;
+      samples -= block;
+    }
+
+    chan_store_avx2(num);
+
+    /* timer B control */
+    INTERNAL_TIMER_B(length);
+    return;
+  }
+#endif
+
   /* buffering */
   for(i=0; i<length; i++)
   {
@@ -2061,23 +2381,8 @@ void YM2612Update(int *buffer, int length)
     /* advance LFO */
     advance_lfo();
 
-    /* EG is updated every 3 samples */
-    ym2612.OPN.eg_timer++;
-    if (ym2612.OPN.eg_timer >= 3)
-    {
-      /* reset EG timer */
-      ym2612.OPN.eg_timer = 0;
-
-      /* increment EG counter */
-      ym2612.OPN.eg_cnt++;
-
-      /* EG counter is 12-bit only and zero value is skipped (verified on real hardware) */
-      if (ym2612.OPN.eg_cnt == 4096)
-        ym2612.OPN.eg_cnt = 1;
-
-      /* advance envelope generator */
-      advance_eg_channels(&ym2612.CH[0], ym2612.OPN.eg_cnt);
-    }
+    /* advance envelope generator */
+    advance_eg();
 
     /* channels accumulator output clipping (14-bit max) */
     if (out_fm[0] > 8191) out_fm[0] = 8191;
@@ -2134,22 +2439,29 @@ void YM2612Update(int *buffer, int length)
     *buffer++ = lt;
     *buffer++ = rt;
 
-    /* CSM mode: if CSM Key ON has occurred, CSM Key OFF need to be sent      */
-    /* only if Timer A does not overflow again (i.e CSM Key ON not set again) */
-    ym2612.OPN.SL3.key_csm <<= 1;
+    /* timer A control & CSM mode */
+    update_timer_a();
+  }
 
-    /* timer A control */
-    INTERNAL_TIMER_A();
+  /* timer B control */
+  INTERNAL_TIMER_B(length);
+}
 
-    /* CSM Mode Key ON still disabled */
-    if (ym2612.OPN.SL3.key_csm & 2)
+/* Update ym2612 timers without generating samples (sound emulation disabled) */
+void YM2612UpdateTimers(int length)
+{
+  /* timer A control (CSM mode key on/off only affects sound output) */
+  if (ym2612.OPN.ST.mode & 0x01)
+  {
+    ym2612.OPN.ST.TAC -= length;
+    if (ym2612.OPN.ST.TAC <= 0)
     {
-      /* CSM Mode Key OFF (verified by Nemesis on real hardware) */
-      FM_KEYOFF_CSM(&ym2612.CH[2],SLOT1);
-      FM_KEYOFF_CSM(&ym2612.CH[2],SLOT2);
-      FM_KEYOFF_CSM(&ym2612.CH[2],SLOT3);
-      FM_KEYOFF_CSM(&ym2612.CH[2],SLOT4);
-      ym2612.OPN.SL3.key_csm = 0;
+      /* set status (if enabled) */
+      if (ym2612.OPN.ST.mode & 0x04)
+        ym2612.OPN.ST.status |= 0x01;
+
+      /* reload the counter, taking into account all overflows that occured since last update */
+      ym2612.OPN.ST.TAC = ym2612.OPN.ST.TAL - ((-ym2612.OPN.ST.TAC) % ym2612.OPN.ST.TAL);
     }
   }
 
@@ -2205,6 +2517,17 @@ void YM2612Config(int type)
   }
 }
 
+int YM2612ConfigSIMD(int enable)
+{
+#ifdef HAVE_SIMD_AVX2
+  /* AVX2 channel calculation, if supported by CPU */
+  chan_avx2 = enable && SIMD_AVX2_SUPPORTED();
+  return chan_avx2;
+#else
+  return 0;
+#endif
+}
+
 int YM2612LoadContext(unsigned char *state)
 {
   int c,s;
@@ -24,8 +24,10 @@ enum {
 
 extern void YM2612Init(void);
 extern void YM2612Config(int type);
+extern int YM2612ConfigSIMD(int enable);
 extern void YM2612ResetChip(void);
 extern void YM2612Update(int *buffer, int length);
+extern void YM2612UpdateTimers(int length);
 extern void YM2612Write(unsigned int a, unsigned int v);
 extern unsigned int YM2612Read(void);
 extern int YM2612LoadContext(unsigned char *state);
@@ -38,7 +38,20 @@
 
 #include "shared.h"
 
-int state_load(unsigned char *state)
+/* memories tracked by pages in last savestate (see state_delta_encode) */
+typedef struct
+{
+  int offset;
+  int size;
+  unsigned char *dirty;
+} t_state_tracked;
+
+static THREAD_LOCAL t_state_tracked state_tracked[STATE_TRACKED_MAX];
+static THREAD_LOCAL int state_tracked_count;
+static THREAD_LOCAL int state_tracked_size;
+static THREAD_LOCAL const unsigned char *state_tracked_base;
+
+static int state_unserialize(unsigned char *state, int restore)
 {
   int i, bufferptr = 0;
 
@@ -58,7 +71,14 @@ int state_load(unsigned char *state)
   }
 
   /* reset system */
-  system_reset();
+  if (restore)
+  {
+    system_restore();
+  }
+  else
+  {
+    system_reset();
+  }
 
   /* enable VDP access for TMSS systems */
   for (i=0xc0; i<0xe0; i+=8)
@@ -102,7 +122,13 @@ int state_load(unsigned char *state)
   load_param(io_reg, sizeof(io_reg));
   if ((system_hw & SYSTEM_PBC) == SYSTEM_MD)
   {
-    io_reg[0] = region_code | 0x20 | (config.bios & 1);
+    io_reg[0] = region_code | (config.bios & 1);
+
+    /* CD unit detection */
+    if (system_hw != SYSTEM_MCD)
+    {
+      io_reg[0] |= 0x20;
+    }
   }
   else
   {
@@ -190,6 +216,17 @@ int state_load(unsigned char *state)
   return bufferptr;
 }
 
+int state_load(unsigned char *state)
+{
+  return state_unserialize(state, 0);
+}
+
+/* Restore a savestate from the running system (rewind or run-ahead), without clearing the display */
+int state_restore(unsigned char *state)
+{
+  return state_unserialize(state, 1);
+}
+
 int state_save(unsigned char *state)
 {
   /* buffer size */
@@ -200,6 +237,10 @@ int state_save(unsigned char *state)
   memcpy(version,STATE_VERSION,16);
   save_param(version, 16);
 
+  /* tracked memories offsets are recorded while saving */
+  state_tracked_base = state;
+  state_tracked_count = 0;
+
   /* GENESIS */
   if ((system_hw & SYSTEM_PBC) == SYSTEM_MD)
   {
@@ -278,6 +319,227 @@ int state_save(unsigned char *state)
     bufferptr += sms_cart_context_save(&state[bufferptr]);
   }
 
+  state_tracked_base = NULL;
+  state_tracked_size = bufferptr;
+
   /* return total size */
   return bufferptr;
 }
+
+void state_track(const unsigned char *data, int size, unsigned char *dirty)
+{
+  if (state_tracked_base && (state_tracked_count < STATE_TRACKED_MAX))
+  {
+    state_tracked[state_tracked_count].offset = data - state_tracked_base;
+    state_tracked[state_tracked_count].size = size;
+    state_tracked[state_tracked_count].dirty = dirty;
+    state_tracked_count++;
+  }
+}
+
+/* Snapshots
+
+   Savestates don't include internal CPU state (prefetch, bus refresh, ...), display
+   viewport or audio output state (resampling buffers & filters), which are all
+   reinitialized on load. To restore the running system exactly (run-ahead),
+   snapshots add them to savestate */
+
+int state_snapshot_size(void)
+{
+  return STATE_SIZE + sizeof(m68k) + sizeof(s68k) + sizeof(bitmap.viewport) + audio_context_size();
+}
+
+int state_snapshot_save(unsigned char *state)
+{
+  int bufferptr = state_save(state);
+
+  save_param(&m68k, sizeof(m68k));
+  if (system_hw == SYSTEM_MCD)
+  {
+    save_param(&s68k, sizeof(s68k));
+  }
+
+  save_param(&bitmap.viewport, sizeof(bitmap.viewport));
+
+  bufferptr += audio_context_save(&state[bufferptr]);
+
+  return bufferptr;
+}
+
+int state_snapshot_load(unsigned char *state)
+{
+  int bufferptr = state_restore(state);
+
+  if (!bufferptr)
+  {
+    return 0;
+  }
+
+  load_param(&m68k, sizeof(m68k));
+  if (system_hw == SYSTEM_MCD)
+  {
+    load_param(&s68k, sizeof(s68k));
+  }
+
+  load_param(&bitmap.viewport, sizeof(bitmap.viewport));
+
+  bufferptr += audio_context_load(&state[bufferptr]);
+
+  return bufferptr;
+}
+
+/* Delta savestates
+
+   A delta holds the modified blocks of a savestate, compared to a base savestate
+   of the same size (usually the previous snapshot of a rewind buffer or netplay
+   session). Only a few KB of work RAM, VRAM or Mega CD RAM generally change from
+   one frame to another, so deltas are much smaller than full savestates.
+
+   Format is the savestate size, followed by runs of consecutive modified blocks:
+   offset, length (32-bit little-endian values) then run data, XORed with base data.
+   Because of the XOR, applying a delta to the base savestate restores the new
+   savestate and applying it to the new savestate restores the base savestate.
+
+   Memories that are only written through handlers (VRAM, CRAM, VSRAM, PCM RAM)
+   mark modified pages, so that only these pages need to be compared. Pages are
+   cleared by each delta, base savestate is therefore expected to be the one that
+   was encoded by previous call. Other data (work RAM, Z80 RAM, Mega CD PRG-RAM and
+   Word-RAM, which are directly accessed by CPU cores) are always compared. */
+
+static void state_delta_put32(unsigned char *ptr, uint32 data)
+{
+  ptr[0] = data & 0xff;
+  ptr[1] = (data >> 8) & 0xff;
+  ptr[2] = (data >> 16) & 0xff;
+  ptr[3] = data >> 24;
+}
+
+static uint32 state_delta_get32(const unsigned char *ptr)
+{
+  return ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | ((uint32)ptr[3] << 24);
+}
+
+int state_delta_encode(unsigned char *delta, const unsigned char *state, const unsigned char *base, int size)
+{
+  int i, offset, length, modified;
+  int run = -1;
+  int bufferptr = 4;
+  int tracked = 0;
+
+  /* tracked memories offsets are only valid for savestates with same layout */
+  int count = (size == state_tracked_size) ? state_tracked_count : 0;
+
+  /* savestate size */
+  state_delta_put32(delta, size);
+
+  for (offset = 0; offset < size; offset += length)
+  {
+    length = size - offset;
+    if (length > STATE_DELTA_BLOCK)
+    {
+      length = STATE_DELTA_BLOCK;
+    }
+
+    /* next tracked memory */
+    while ((tracked < count) && (offset >= (state_tracked[tracked].offset + state_tracked[tracked].size)))
+    {
+      tracked++;
+    }
+
+    if ((tracked < count) && (offset >= state_tracked[tracked].offset) && ((offset + length) <= (state_tracked[tracked].offset + state_tracked[tracked].size)))
+    {
+      /* block is only compared if its first or last page was modified */
+      int start = offset - state_tracked[tracked].offset;
+      modified = (state_tracked[tracked].dirty[start >> STATE_PAGE_SHIFT] || state_tracked[tracked].dirty[(start + length - 1) >> STATE_PAGE_SHIFT]) &&
+                 memcmp(&state[offset], &base[offset], length);
+    }
+    else
+    {
+      modified = memcmp(&state[offset], &base[offset], length);
+    }
+
+    if (modified)
+    {
+      /* start a new run, header is written once run is complete */
+      if (run < 0)
+      {
+        run = bufferptr;
+        state_delta_put32(&delta[bufferptr], offset);
+        bufferptr += 8;
+      }
+
+      for (i = 0; i < length; i++)
+      {
+        delta[bufferptr++] = state[offset + i] ^ base[offset + i];
+      }
+    }
+    else if (run >= 0)
+    {
+      /* run length */
+      state_delta_put32(&delta[run + 4], bufferptr - run - 8);
+      run = -1;
+    }
+  }
+
+  if (run >= 0)
+  {
+    state_delta_put32(&delta[run + 4], bufferptr - run - 8);
+  }
+
+  /* next delta only compares pages modified from now on */
+  for (i = 0; i < state_tracked_count; i++)
+  {
+    memset(state_tracked[i].dirty, 0, STATE_PAGES(state_tracked[i].size));
+  }
+
+  /* return delta size */
+  return bufferptr;
+}
+
+int state_delta_apply(unsigned char *state, const unsigned char *delta, int length)
+{
+  int i, size;
+  uint32 offset, count;
+  int bufferptr = 4;
+
+  /* savestate size */
+  if (length < 4)
+  {
+    return 0;
+  }
+  size = state_delta_get32(delta);
+
+  while (bufferptr < length)
+  {
+    /* run header */
+    if ((length - bufferptr) < 8)
+    {
+      return 0;
+    }
+    offset = state_delta_get32(&delta[bufferptr]);
+    count = state_delta_get32(&delta[bufferptr + 4]);
+    bufferptr += 8;
+
+    /* runs are checked before anything is modified */
+    if ((offset > (uint32)size) || (count > ((uint32)size - offset)) || (count > (uint32)(length - bufferptr)))
+    {
+      return 0;
+    }
+    bufferptr += count;
+  }
+
+  for (bufferptr = 4; bufferptr < length; bufferptr += count)
+  {
+    offset = state_delta_get32(&delta[bufferptr]);
+    count = state_delta_get32(&delta[bufferptr + 4]);
+    bufferptr += 8;
+
+    for (i = 0; i < (int)count; i++)
+    {
+      state[offset + i] ^= delta[bufferptr + i];
+    }
+  }
+
+  /* return savestate size */
+  return size;
+}
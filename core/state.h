@@ -42,6 +42,17 @@
 #define STATE_SIZE    0xfd000
 #define STATE_VERSION "GENPLUS-GX 1.7.6"
 
+/* delta savestates: blocks that changed between two savestates of the same size */
+#define STATE_DELTA_BLOCK 64
+#define STATE_DELTA_SIZE  (4 + STATE_SIZE + ((STATE_SIZE / STATE_DELTA_BLOCK / 2) + 1) * 8)
+
+/* delta savestates: memories only written through handlers mark modified pages */
+#define STATE_PAGE_SHIFT  10
+#define STATE_PAGES(size) (((size) + (1 << STATE_PAGE_SHIFT) - 1) >> STATE_PAGE_SHIFT)
+#define STATE_TRACKED_MAX 8
+
+#define MARK_STATE_DIRTY(dirty, addr) dirty[(addr) >> STATE_PAGE_SHIFT] = 1
+
 #define load_param(param, size) \
   memcpy(param, &state[bufferptr], size); \
   bufferptr+= size;
@@ -50,8 +61,19 @@
   memcpy(&state[bufferptr], param, size); \
   bufferptr+= size;
 
+#define save_tracked(param, size, dirty) \
+  state_track(&state[bufferptr], size, dirty); \
+  save_param(param, size);
+
 /* Function prototypes */
 extern int state_load(unsigned char *state);
+extern int state_restore(unsigned char *state);
+extern int state_snapshot_size(void);
+extern int state_snapshot_save(unsigned char *state);
+extern int state_snapshot_load(unsigned char *state);
 extern int state_save(unsigned char *state);
+extern int state_delta_encode(unsigned char *delta, const unsigned char *state, const unsigned char *base, int size);
+extern int state_delta_apply(unsigned char *state, const unsigned char *delta, int length);
+extern void state_track(const unsigned char *data, int size, unsigned char *dirty);
 
 #endif
@@ -43,17 +43,17 @@
 #include "eq.h"
 
 /* Global variables */
-t_bitmap bitmap;
-t_snd snd;
-uint32 mcycles_vdp;
-uint8 system_hw;
-uint8 system_bios;
-uint32 system_clock;
-int16 SVP_cycles = 800; 
-
-static uint8 pause_b;
-static EQSTATE eq[2];
-static int16 llp,rrp;
+THREAD_LOCAL t_bitmap bitmap;
+THREAD_LOCAL t_snd snd;
+THREAD_LOCAL uint32 mcycles_vdp;
+THREAD_LOCAL uint8 system_hw;
+THREAD_LOCAL uint8 system_bios;
+THREAD_LOCAL uint32 system_clock;
+THREAD_LOCAL int16 SVP_cycles = 800; 
+
+static THREAD_LOCAL uint8 pause_b;
+static THREAD_LOCAL EQSTATE eq;
+static THREAD_LOCAL int16 llp,rrp;
 
 /******************************************************************************************/
 /* Audio subsystem                                                                        */
@@ -169,13 +169,74 @@ void audio_reset(void)
   audio_set_equalizer();
 }
 
+/* Audio output state (resampling buffers & filters), not included in savestates.
+   Restoring it after a savestate saved at the same time discards any audio output
+   generated in between, without any discontinuity (run-ahead) */
+int audio_context_size(void)
+{
+  int i;
+  /* filters, FM & PSG output state (see sound_output_save) */
+  int size = sizeof(llp) + sizeof(rrp) + sizeof(eq) + (3 + 4*2) * sizeof(int);
+
+  for (i=0; i<3; i++)
+  {
+    if (snd.blips[i])
+    {
+      size += blip_state_size(snd.blips[i]);
+    }
+  }
+
+  return size;
+}
+
+int audio_context_save(uint8 *state)
+{
+  int i, bufferptr = 0;
+
+  for (i=0; i<3; i++)
+  {
+    if (snd.blips[i])
+    {
+      bufferptr += blip_save_state(snd.blips[i], &state[bufferptr]);
+    }
+  }
+
+  save_param(&llp, sizeof(llp));
+  save_param(&rrp, sizeof(rrp));
+  save_param(&eq, sizeof(eq));
+
+  bufferptr += sound_output_save(&state[bufferptr]);
+
+  return bufferptr;
+}
+
+int audio_context_load(uint8 *state)
+{
+  int i, bufferptr = 0;
+
+  for (i=0; i<3; i++)
+  {
+    if (snd.blips[i])
+    {
+      bufferptr += blip_load_state(snd.blips[i], &state[bufferptr]);
+    }
+  }
+
+  load_param(&llp, sizeof(llp));
+  load_param(&rrp, sizeof(rrp));
+  load_param(&eq, sizeof(eq));
+
+  bufferptr += sound_output_load(&state[bufferptr]);
+
+  return bufferptr;
+}
+
 void audio_set_equalizer(void)
 {
-  init_3band_state(&eq[0],config.low_freq,config.high_freq,snd.sample_rate);
-  init_3band_state(&eq[1],config.low_freq,config.high_freq,snd.sample_rate);
-  eq[0].lg = eq[1].lg = (double)(config.lg) / 100.0;
-  eq[0].mg = eq[1].mg = (double)(config.mg) / 100.0;
-  eq[0].hg = eq[1].hg = (double)(config.hg) / 100.0;
+  init_3band_state(&eq,config.low_freq,config.high_freq,snd.sample_rate);
+  eq.lg = (config.lg << 16) / 100;
+  eq.mg = (config.mg << 16) / 100;
+  eq.hg = (config.hg << 16) / 100;
 }
 
 void audio_shutdown(void)
@@ -209,8 +270,17 @@ int audio_update(int16 *buffer)
     size &= ALIGN_SND;
 #endif
 
-    /* resample & mix FM/PSG, PCM & CD-DA streams to output buffer */
-    blip_mix_samples(snd.blips[0], snd.blips[1], snd.blips[2], buffer, size);
+    if (snd.enabled)
+    {
+      /* resample & mix FM/PSG, PCM & CD-DA streams to output buffer */
+      blip_mix_samples(snd.blips[0], snd.blips[1], snd.blips[2], buffer, size);
+    }
+    else
+    {
+      /* discard PCM & CD-DA samples */
+      blip_discard_samples(snd.blips[1], size);
+      blip_discard_samples(snd.blips[2], size);
+    }
   }
   else
   {
@@ -219,71 +289,72 @@ int audio_update(int16 *buffer)
     size &= ALIGN_SND;
 #endif
 
-    /* resample FM/PSG mixed stream to output buffer */
-    blip_read_samples(snd.blips[0], buffer, size);
+    if (snd.enabled)
+    {
+      /* resample FM/PSG mixed stream to output buffer */
+      blip_read_samples(snd.blips[0], buffer, size);
+    }
+  }
+
+  /* sound emulation disabled ? */
+  if (!snd.enabled)
+  {
+    /* FM/PSG samples are not generated */
+    blip_discard_samples(snd.blips[0], size);
+
+    /* silent output */
+    memset(buffer, 0, size * 4);
+    return size;
   }
 
-  /* Audio filtering */
-  if (config.filter)
+  /* Audio filtering & mono output mixing (single pass) */
+  if (config.filter & 1)
   {
+    /* single-pole low-pass filter (6 dB/octave) */
+    uint32 factora  = config.lp_range;
+    uint32 factorb  = 0x10000 - factora;
     int samples = size;
     int16 *out = buffer;
     int32 l, r;
 
-    if (config.filter & 1)
+    /* restore previous sample */
+    l = llp;
+    r = rrp;
+
+    do
     {
-      /* single-pole low-pass filter (6 dB/octave) */
-      uint32 factora  = config.lp_range;
-      uint32 factorb  = 0x10000 - factora;
+      /* apply low-pass filter */
+      l = l*factora + out[0]*factorb;
+      r = r*factora + out[1]*factorb;
 
-      /* restore previous sample */
-      l = llp;
-      r = rrp;
+      /* 16.16 fixed point */
+      l >>= 16;
+      r >>= 16;
 
-      do
+      /* update sound buffer */
+      if (config.mono)
       {
-        /* apply low-pass filter */
-        l = l*factora + out[0]*factorb;
-        r = r*factora + out[1]*factorb;
-
-        /* 16.16 fixed point */
-        l >>= 16;
-        r >>= 16;
-
-        /* update sound buffer */
-        *out++ = l;
-        *out++ = r;
+        out[0] = out[1] = (l + r) / 2;
       }
-      while (--samples);
-
-      /* save last samples for next frame */
-      llp = l;
-      rrp = r;
-    }
-    else if (config.filter & 2)
-    {
-      do
+      else
       {
-        /* 3 Band EQ */
-        l = do_3band(&eq[0],out[0]);
-        r = do_3band(&eq[1],out[1]);
-
-        /* clipping (16-bit samples) */
-        if (l > 32767) l = 32767;
-        else if (l < -32768) l = -32768;
-        if (r > 32767) r = 32767;
-        else if (r < -32768) r = -32768;
-
-        /* update sound buffer */
-        *out++ = l;
-        *out++ = r;
+        out[0] = l;
+        out[1] = r;
       }
-      while (--samples);
+      out += 2;
     }
-  }
+    while (--samples);
 
-  /* Mono output mixing */
-  if (config.mono)
+    /* save last samples for next frame */
+    llp = l;
+    rrp = r;
+  }
+  else if (config.filter & 2)
+  {
+    /* 3 Band EQ */
+    do_3band(&eq, buffer, size, config.mono);
+  }
+  else if (config.mono)
   {
     int16 out;
     int samples = size;
@@ -325,6 +396,17 @@ void system_reset(void)
   audio_reset();
 }
 
+void system_restore(void)
+{
+  /* same as system_reset, before a savestate is restored on the running system */
+  gen_reset(1);
+  io_reset();
+  render_restore();
+  vdp_reset();
+  sound_reset();
+  audio_reset();
+}
+
 void system_frame_gen(int do_skip)
 {
   /* line counters */
@@ -416,7 +498,7 @@ void system_frame_gen(int do_skip)
   /* first line of overscan */
   if (bitmap.viewport.y)
   {
-    blank_line(bitmap.viewport.h, -bitmap.viewport.x, bitmap.viewport.w + 2*bitmap.viewport.x);
+    blank_line_async(bitmap.viewport.h, -bitmap.viewport.x, bitmap.viewport.w + 2*bitmap.viewport.x);
   }
   
   /* clear DMA Busy, FIFO FULL & field flags */
@@ -520,7 +602,7 @@ void system_frame_gen(int do_skip)
     /* render overscan */
     if ((line < end) || (line >= start))
     {
-      blank_line(line, -bitmap.viewport.x, bitmap.viewport.w + 2*bitmap.viewport.x);
+      blank_line_async(line, -bitmap.viewport.x, bitmap.viewport.w + 2*bitmap.viewport.x);
     }
 
     /* update 6-Buttons & Lightguns */
@@ -550,7 +632,7 @@ void system_frame_gen(int do_skip)
   /* last line of overscan */
   if (bitmap.viewport.y)
   {
-    blank_line(line, -bitmap.viewport.x, bitmap.viewport.w + 2*bitmap.viewport.x);
+    blank_line_async(line, -bitmap.viewport.x, bitmap.viewport.w + 2*bitmap.viewport.x);
   }
 
   /* reload H-Int counter */
@@ -568,7 +650,7 @@ void system_frame_gen(int do_skip)
   /* parse first line of sprites */
   if (reg[1] & 0x40)
   {
-    parse_satb(-1);
+    parse_satb_async(-1);
   }
 
   /* update 6-Buttons & Lightguns */
@@ -608,7 +690,13 @@ void system_frame_gen(int do_skip)
     /* render scanline */
     if (!do_skip)
     {
-      render_line(line);
+      render_line_async(line);
+    }
+
+    /* only update sprite status */
+    else if (do_skip & SKIP_RENDER_STATUS)
+    {
+      parse_line_async(line);
     }
 
     /* update 6-Buttons & Lightguns */
@@ -659,6 +747,9 @@ void system_frame_gen(int do_skip)
     bitmap.viewport.changed |= 1;
   }
 
+  /* wait for end of frame rendering */
+  render_sync();
+
   /* adjust timings for next frame */
   input_end_frame(mcycles_vdp);
   m68k.refresh_cycles -= mcycles_vdp;
@@ -759,7 +850,7 @@ void system_frame_scd(int do_skip)
   /* first line of overscan */
   if (bitmap.viewport.y)
   {
-    blank_line(bitmap.viewport.h, -bitmap.viewport.x, bitmap.viewport.w + 2*bitmap.viewport.x);
+    blank_line_async(bitmap.viewport.h, -bitmap.viewport.x, bitmap.viewport.w + 2*bitmap.viewport.x);
   }
   
   /* clear DMA Busy, FIFO FULL & field flags */
@@ -859,7 +950,7 @@ void system_frame_scd(int do_skip)
     /* render overscan */
     if ((line < end) || (line >= start))
     {
-      blank_line(line, -bitmap.viewport.x, bitmap.viewport.w + 2*bitmap.viewport.x);
+      blank_line_async(line, -bitmap.viewport.x, bitmap.viewport.w + 2*bitmap.viewport.x);
     }
 
     /* update 6-Buttons & Lightguns */
@@ -885,7 +976,7 @@ void system_frame_scd(int do_skip)
   /* last line of overscan */
   if (bitmap.viewport.y)
   {
-    blank_line(line, -bitmap.viewport.x, bitmap.viewport.w + 2*bitmap.viewport.x);
+    blank_line_async(line, -bitmap.viewport.x, bitmap.viewport.w + 2*bitmap.viewport.x);
   }
 
   /* reload H-Int counter */
@@ -903,7 +994,7 @@ void system_frame_scd(int do_skip)
   /* parse first line of sprites */
   if (reg[1] & 0x40)
   {
-    parse_satb(-1);
+    parse_satb_async(-1);
   }
 
   /* update 6-Buttons & Lightguns */
@@ -939,7 +1030,13 @@ void system_frame_scd(int do_skip)
     /* render scanline */
     if (!do_skip)
     {
-      render_line(line);
+      render_line_async(line);
+    }
+
+    /* only update sprite status */
+    else if (do_skip & SKIP_RENDER_STATUS)
+    {
+      parse_line_async(line);
     }
     
     /* update 6-Buttons & Lightguns */
@@ -986,6 +1083,9 @@ void system_frame_scd(int do_skip)
     bitmap.viewport.changed |= 1;
   }
   
+  /* wait for end of frame rendering */
+  render_sync();
+
   /* adjust timings for next frame */
   scd_end_frame(scd.cycles);
   input_end_frame(mcycles_vdp);
@@ -1347,6 +1447,12 @@ void system_frame_sms(int do_skip)
       {
         render_line(line);
       }
+
+      /* only update sprite status */
+      else if (do_skip & SKIP_RENDER_STATUS)
+      {
+        parse_line(line);
+      }
     }
 
     /* update 6-Buttons & Lightguns */
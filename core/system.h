@@ -69,6 +69,10 @@
 #define SMS_CYCLE_OFFSET  530
 #define PBC_CYCLE_OFFSET  560
 
+/* Frame skipping modes (system_frame_xxx do_skip parameter) */
+#define SKIP_RENDER         0x01  /* active lines are not rendered */
+#define SKIP_RENDER_STATUS  0x02  /* active lines are not rendered but sprite collision & overflow status is still updated */
+
 typedef struct
 {
   uint8 *data;      /* Bitmap data */
@@ -91,18 +95,18 @@ typedef struct
 {
   int sample_rate;      /* Output Sample rate (8000-48000) */
   double frame_rate;    /* Output Frame rate (usually 50 or 60 frames per second) */
-  int enabled;          /* 1= sound emulation is enabled */
+  int enabled;          /* 1= sound emulation is enabled, 0= sound chips state is updated but no samples are generated */
   blip_t* blips[3];     /* Blip Buffer resampling (stereo) */
 } t_snd;
 
 /* Global variables */
-extern t_bitmap bitmap;
-extern t_snd snd;
-extern uint32 mcycles_vdp;
-extern int16 SVP_cycles; 
-extern uint8 system_hw;
-extern uint8 system_bios;
-extern uint32 system_clock;
+extern THREAD_LOCAL t_bitmap bitmap;
+extern THREAD_LOCAL t_snd snd;
+extern THREAD_LOCAL uint32 mcycles_vdp;
+extern THREAD_LOCAL int16 SVP_cycles; 
+extern THREAD_LOCAL uint8 system_hw;
+extern THREAD_LOCAL uint8 system_bios;
+extern THREAD_LOCAL uint32 system_clock;
 
 /* Function prototypes */
 extern int audio_init(int samplerate, double framerate);
@@ -110,9 +114,13 @@ extern void audio_set_rate(int samplerate, double framerate);
 extern void audio_reset(void);
 extern void audio_shutdown(void);
 extern int audio_update(int16 *buffer);
+extern int audio_context_size(void);
+extern int audio_context_save(uint8 *state);
+extern int audio_context_load(uint8 *state);
 extern void audio_set_equalizer(void);
 extern void system_init(void);
 extern void system_reset(void);
+extern void system_restore(void);
 extern void system_frame_gen(int do_skip);
 extern void system_frame_scd(int do_skip);
 extern void system_frame_sms(int do_skip);
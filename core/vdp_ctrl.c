@@ -42,9 +42,10 @@
 #include "shared.h"
 #include "hvc.h"
 
-/* Mark a pattern as modified */
+/* Mark a pattern (and savestate VRAM page) as modified */
 #define MARK_BG_DIRTY(addr)                         \
 {                                                   \
+  MARK_STATE_DIRTY(vram_dirty, addr);               \
   name = (addr >> 5) & 0x7FF;                       \
   if (bg_name_dirty[name] == 0)                     \
   {                                                 \
@@ -64,51 +65,51 @@
 #define HBLANK_H40_END_MCYCLE   (872)
 
 /* VDP context */
-uint8 ALIGNED_(4) sat[0x400];     /* Internal copy of sprite attribute table */
-uint8 ALIGNED_(4) vram[0x10000];  /* Video RAM (64K x 8-bit) */
-uint8 ALIGNED_(4) cram[0x80];     /* On-chip color RAM (64 x 9-bit) */
-uint8 ALIGNED_(4) vsram[0x80];    /* On-chip vertical scroll RAM (40 x 11-bit) */
-uint8 reg[0x20];                  /* Internal VDP registers (23 x 8-bit) */
-uint8 hint_pending;               /* 0= Line interrupt is pending */
-uint8 vint_pending;               /* 1= Frame interrupt is pending */
-uint16 status;                    /* VDP status flags */
-uint32 dma_length;                /* DMA remaining length */
-uint32 dma_endCycles;             /* DMA end cycle */
-uint8 dma_type;                   /* DMA mode */
+THREAD_LOCAL uint8 ALIGNED_(4) sat[0x400];     /* Internal copy of sprite attribute table */
+THREAD_LOCAL uint8 ALIGNED_(4) vram[0x10000];  /* Video RAM (64K x 8-bit) */
+THREAD_LOCAL uint8 ALIGNED_(4) cram[0x80];     /* On-chip color RAM (64 x 9-bit) */
+THREAD_LOCAL uint8 ALIGNED_(4) vsram[0x80];    /* On-chip vertical scroll RAM (40 x 11-bit) */
+THREAD_LOCAL uint8 reg[0x20];                  /* Internal VDP registers (23 x 8-bit) */
+THREAD_LOCAL uint8 hint_pending;               /* 0= Line interrupt is pending */
+THREAD_LOCAL uint8 vint_pending;               /* 1= Frame interrupt is pending */
+THREAD_LOCAL uint16 status;                    /* VDP status flags */
+THREAD_LOCAL uint32 dma_length;                /* DMA remaining length */
+THREAD_LOCAL uint32 dma_endCycles;             /* DMA end cycle */
+THREAD_LOCAL uint8 dma_type;                   /* DMA mode */
 
 /* Global variables */
-uint16 ntab;                      /* Name table A base address */
-uint16 ntbb;                      /* Name table B base address */
-uint16 ntwb;                      /* Name table W base address */
-uint16 satb;                      /* Sprite attribute table base address */
-uint16 hscb;                      /* Horizontal scroll table base address */
-uint8 bg_name_dirty[0x800];       /* 1= This pattern is dirty */
-uint16 bg_name_list[0x800];       /* List of modified pattern indices */
-uint16 bg_list_index;             /* # of modified patterns in list */
-uint8 hscroll_mask;               /* Horizontal Scrolling line mask */
-uint8 playfield_shift;            /* Width of planes A, B (in bits) */
-uint8 playfield_col_mask;         /* Playfield column mask */
-uint16 playfield_row_mask;        /* Playfield row mask */
-uint16 vscroll;                   /* Latched vertical scroll value */
-uint8 odd_frame;                  /* 1: odd field, 0: even field */
-uint8 im2_flag;                   /* 1= Interlace mode 2 is being used */
-uint8 interlaced;                 /* 1: Interlaced mode 1 or 2 */
-uint8 vdp_pal;                    /* 1: PAL , 0: NTSC (default) */
-uint8 h_counter;                  /* Horizontal counter */
-uint16 v_counter;                 /* Vertical counter */
-uint16 vc_max;                    /* Vertical counter overflow value */
-uint16 lines_per_frame;           /* PAL: 313 lines, NTSC: 262 lines */
-uint16 max_sprite_pixels;         /* Max. sprites pixels per line (parsing & rendering) */
-uint32 fifo_cycles[4];            /* VDP FIFO read-out cycles */
-uint32 hvc_latch;                 /* latched HV counter */
-uint32 vint_cycle;                /* VINT occurence cycle */
-const uint8 *hctab;               /* pointer to H Counter table */
+THREAD_LOCAL uint16 ntab;                      /* Name table A base address */
+THREAD_LOCAL uint16 ntbb;                      /* Name table B base address */
+THREAD_LOCAL uint16 ntwb;                      /* Name table W base address */
+THREAD_LOCAL uint16 satb;                      /* Sprite attribute table base address */
+THREAD_LOCAL uint16 hscb;                      /* Horizontal scroll table base address */
+THREAD_LOCAL uint8 bg_name_dirty[0x800];       /* 1= This pattern is dirty */
+THREAD_LOCAL uint16 bg_name_list[0x800];       /* List of modified pattern indices */
+THREAD_LOCAL uint16 bg_list_index;             /* # of modified patterns in list */
+THREAD_LOCAL uint8 hscroll_mask;               /* Horizontal Scrolling line mask */
+THREAD_LOCAL uint8 playfield_shift;            /* Width of planes A, B (in bits) */
+THREAD_LOCAL uint8 playfield_col_mask;         /* Playfield column mask */
+THREAD_LOCAL uint16 playfield_row_mask;        /* Playfield row mask */
+THREAD_LOCAL uint16 vscroll;                   /* Latched vertical scroll value */
+THREAD_LOCAL uint8 odd_frame;                  /* 1: odd field, 0: even field */
+THREAD_LOCAL uint8 im2_flag;                   /* 1= Interlace mode 2 is being used */
+THREAD_LOCAL uint8 interlaced;                 /* 1: Interlaced mode 1 or 2 */
+THREAD_LOCAL uint8 vdp_pal;                    /* 1: PAL , 0: NTSC (default) */
+THREAD_LOCAL uint8 h_counter;                  /* Horizontal counter */
+THREAD_LOCAL uint16 v_counter;                 /* Vertical counter */
+THREAD_LOCAL uint16 vc_max;                    /* Vertical counter overflow value */
+THREAD_LOCAL uint16 lines_per_frame;           /* PAL: 313 lines, NTSC: 262 lines */
+THREAD_LOCAL uint16 max_sprite_pixels;         /* Max. sprites pixels per line (parsing & rendering) */
+THREAD_LOCAL uint32 fifo_cycles[4];            /* VDP FIFO read-out cycles */
+THREAD_LOCAL uint32 hvc_latch;                 /* latched HV counter */
+THREAD_LOCAL uint32 vint_cycle;                /* VINT occurence cycle */
+THREAD_LOCAL const uint8 *hctab;               /* pointer to H Counter table */
 
 /* Function pointers */
-void (*vdp_68k_data_w)(unsigned int data);
-void (*vdp_z80_data_w)(unsigned int data);
-unsigned int (*vdp_68k_data_r)(void);
-unsigned int (*vdp_z80_data_r)(void);
+THREAD_LOCAL void (*vdp_68k_data_w)(unsigned int data);
+THREAD_LOCAL void (*vdp_z80_data_w)(unsigned int data);
+THREAD_LOCAL unsigned int (*vdp_68k_data_r)(void);
+THREAD_LOCAL unsigned int (*vdp_z80_data_r)(void);
 
 /* Function prototypes */
 static void vdp_68k_data_w_m4(unsigned int data);
@@ -136,26 +137,29 @@ static const uint8 shift_table[]        = { 6, 7, 0, 8 };
 static const uint8 col_mask_table[]     = { 0x0F, 0x1F, 0x0F, 0x3F };
 static const uint16 row_mask_table[]    = { 0x0FF, 0x1FF, 0x2FF, 0x3FF };
 
-static uint8 border;            /* Border color index */
-static uint8 pending;           /* Pending write flag */
-static uint8 code;              /* Code register */
-static uint16 addr;             /* Address register */
-static uint16 addr_latch;       /* Latched A15, A14 of address */
-static uint16 sat_base_mask;    /* Base bits of SAT */
-static uint16 sat_addr_mask;    /* Index bits of SAT */
-static uint16 dma_src;          /* DMA source address */
-static int dmafill;             /* DMA Fill pending flag */
-static int cached_write;        /* 2nd part of 32-bit CTRL port write (Genesis mode) or LSB of CRAM data (Game Gear mode) */
-static uint16 fifo[4];          /* FIFO ring-buffer */
-static int fifo_idx;            /* FIFO write index */
-static int fifo_byte_access;    /* FIFO byte access flag */
-static int *fifo_timing;        /* FIFO slots timing table */
-static int hblank_start_cycle;  /* HBLANK flag set cycle */
-static int hblank_end_cycle;    /* HBLANK flag clear cycle */
+static THREAD_LOCAL uint8 border;            /* Border color index */
+static THREAD_LOCAL uint8 pending;           /* Pending write flag */
+static THREAD_LOCAL uint8 code;              /* Code register */
+static THREAD_LOCAL uint16 addr;             /* Address register */
+static THREAD_LOCAL uint16 addr_latch;       /* Latched A15, A14 of address */
+static THREAD_LOCAL uint16 sat_base_mask;    /* Base bits of SAT */
+static THREAD_LOCAL uint16 sat_addr_mask;    /* Index bits of SAT */
+static THREAD_LOCAL uint16 dma_src;          /* DMA source address */
+static THREAD_LOCAL int dmafill;             /* DMA Fill pending flag */
+static THREAD_LOCAL int cached_write;        /* 2nd part of 32-bit CTRL port write (Genesis mode) or LSB of CRAM data (Game Gear mode) */
+static THREAD_LOCAL uint16 fifo[4];          /* FIFO ring-buffer */
+static THREAD_LOCAL int fifo_idx;            /* FIFO write index */
+static THREAD_LOCAL int fifo_byte_access;    /* FIFO byte access flag */
+static THREAD_LOCAL int *fifo_timing;        /* FIFO slots timing table */
+static THREAD_LOCAL int hblank_start_cycle;  /* HBLANK flag set cycle */
+static THREAD_LOCAL int hblank_end_cycle;    /* HBLANK flag clear cycle */
+static THREAD_LOCAL uint8 vram_dirty[STATE_PAGES(0x10000)]; /* VRAM savestate pages modified since last delta */
+static THREAD_LOCAL uint8 cram_dirty[STATE_PAGES(0x80)];     /* CRAM savestate page modified since last delta */
+static THREAD_LOCAL uint8 vsram_dirty[STATE_PAGES(0x80)];    /* VSRAM savestate page modified since last delta */
 
  /* set Z80 or 68k interrupt lines */
-static void (*set_irq_line)(unsigned int level);
-static void (*set_irq_line_delay)(unsigned int level);
+static THREAD_LOCAL void (*set_irq_line)(unsigned int level);
+static THREAD_LOCAL void (*set_irq_line_delay)(unsigned int level);
 
 /* Vertical counter overflow values (see hvc.h) */
 static const uint16 vc_table[4][2] = 
@@ -263,6 +267,11 @@ void vdp_reset(void)
   memset ((char *) vsram, 0, sizeof (vsram));
   memset ((char *) reg, 0, sizeof (reg));
 
+  /* all savestate pages are modified */
+  memset (vram_dirty, 1, sizeof (vram_dirty));
+  memset (cram_dirty, 1, sizeof (cram_dirty));
+  memset (vsram_dirty, 1, sizeof (vsram_dirty));
+
   addr            = 0;
   addr_latch      = 0;
   code            = 0;
@@ -362,6 +371,7 @@ void vdp_reset(void)
     render_bg = render_bg_m0;
     render_obj = render_obj_tms;
     parse_satb = parse_satb_tms;
+    parse_obj = parse_obj_tms;
   }
   else
   {
@@ -369,6 +379,7 @@ void vdp_reset(void)
     render_bg = render_bg_m4;
     render_obj = render_obj_m4;
     parse_satb = parse_satb_m4;
+    parse_obj = parse_obj_m4;
   }
 
   /* default 68k bus interface (Mega Drive VDP only) */
@@ -435,6 +446,7 @@ void vdp_reset(void)
     render_bg = render_bg_m4;
     render_obj = render_obj_m4;
     parse_satb = parse_satb_m4;
+    parse_obj = parse_obj_m4;
   }
 
   /* Mega Drive specific */
@@ -459,10 +471,14 @@ int vdp_context_save(uint8 *state)
 {
   int bufferptr = 0;
 
+  /* Wait for pending lines to be rendered and latch their SOVR & SCOL flags (kept pending until status is read) */
+  render_sync();
+  status |= spr_status;
+
   save_param(sat, sizeof(sat));
-  save_param(vram, sizeof(vram));
-  save_param(cram, sizeof(cram));
-  save_param(vsram, sizeof(vsram));
+  save_tracked(vram, sizeof(vram), vram_dirty);
+  save_tracked(cram, sizeof(cram), cram_dirty);
+  save_tracked(vsram, sizeof(vsram), vsram_dirty);
   save_param(reg, sizeof(reg));
   save_param(&addr, sizeof(addr));
   save_param(&addr_latch, sizeof(addr_latch));
@@ -487,12 +503,20 @@ int vdp_context_load(uint8 *state)
   int i, bufferptr = 0;
   uint8 temp_reg[0x20];
 
+  /* Wait for pending lines to be rendered */
+  render_sync();
+
   load_param(sat, sizeof(sat));
   load_param(vram, sizeof(vram));
   load_param(cram, sizeof(cram));
   load_param(vsram, sizeof(vsram));
   load_param(temp_reg, sizeof(temp_reg));
 
+  /* all savestate pages are modified */
+  memset(vram_dirty, 1, sizeof(vram_dirty));
+  memset(cram_dirty, 1, sizeof(cram_dirty));
+  memset(vsram_dirty, 1, sizeof(vsram_dirty));
+
   /* restore VDP registers */
   if (system_hw < SYSTEM_MD)
   {
@@ -530,6 +554,7 @@ int vdp_context_load(uint8 *state)
   load_param(&code, sizeof(code));
   load_param(&pending, sizeof(pending));
   load_param(&status, sizeof(status));
+  spr_status = status & 0x20;
   load_param(&dmafill, sizeof(dmafill));
   load_param(&fifo_idx, sizeof(fifo_idx));
   load_param(&fifo, sizeof(fifo));
@@ -619,6 +644,9 @@ void vdp_dma_update(unsigned int cycles)
   */
   unsigned int rate = dma_timing[(status & 8) || !(reg[1] & 0x40)][reg[12] & 1];
 
+  /* Wait for pending lines to be rendered */
+  render_sync();
+
   /* Adjust for 68k bus DMA to VRAM (one word = 2 access) or DMA Copy (one read + one write = 2 access) */
   rate = rate >> (dma_type & 1);
   
@@ -736,6 +764,9 @@ void vdp_dma_update(unsigned int cycles)
 
 void vdp_68k_ctrl_w(unsigned int data)
 {
+  /* Wait for pending lines to be rendered */
+  render_sync();
+
   /* Check pending flag */
   if (pending == 0)
   {
@@ -878,6 +909,9 @@ void vdp_68k_ctrl_w(unsigned int data)
 /* Mega Drive VDP control port specific (MS compatibility mode) */
 void vdp_z80_ctrl_w(unsigned int data)
 {
+  /* Wait for pending lines to be rendered */
+  render_sync();
+
   switch (pending)
   {
     case 0:
@@ -1095,6 +1129,7 @@ void vdp_sms_ctrl_w(unsigned int data)
           {
             /* Mode 4 sprites */
             parse_satb = parse_satb_m4;
+            parse_obj = parse_obj_m4;
             render_obj = render_obj_m4;
 
             /* force BG cache update*/
@@ -1104,6 +1139,7 @@ void vdp_sms_ctrl_w(unsigned int data)
           {
             /* TMS-mode sprites */
             parse_satb = parse_satb_tms;
+            parse_obj = parse_obj_tms;
             render_obj = render_obj_tms;
 
             /* BG cache is not used */
@@ -1193,6 +1229,11 @@ unsigned int vdp_68k_ctrl_r(unsigned int cycles)
   /* Cycle-accurate VDP status read (adjust CPU time with current instruction execution time) */
   cycles += m68k_cycles();
 
+  /* Wait for pending lines to be rendered and latch their SOVR & SCOL flags */
+  render_sync();
+  status |= spr_status;
+  spr_status = 0;
+
   /* Check if DMA Busy flag is set */
   if (status & 2)
   {
@@ -1253,6 +1294,46 @@ unsigned int vdp_68k_ctrl_r(unsigned int cycles)
     temp |= 0x04;
   }
 
+#ifdef USE_IDLE_LOOP_SKIP
+  /* Until VDP is accessed again, same status is returned up to next HBLANK or VINT flag change, FIFO read-out or DMA end */
+  {
+    unsigned int limit = MCYCLES_PER_LINE;
+
+    if (cycles < hblank_start_cycle)
+    {
+      limit = hblank_start_cycle;
+    }
+    else if (cycles < hblank_end_cycle)
+    {
+      limit = hblank_end_cycle;
+    }
+
+    if ((v_counter == bitmap.viewport.h) && (cycles < vint_cycle) && (vint_cycle < limit))
+    {
+      limit = vint_cycle;
+    }
+
+    limit += mcycles_vdp;
+    cycles += mcycles_vdp;
+
+    if ((cycles < fifo_cycles[fifo_idx]) && (fifo_cycles[fifo_idx] < limit))
+    {
+      limit = fifo_cycles[fifo_idx];
+    }
+    else if ((cycles < fifo_cycles[(fifo_idx + 3) & 3]) && (fifo_cycles[(fifo_idx + 3) & 3] < limit))
+    {
+      limit = fifo_cycles[(fifo_idx + 3) & 3];
+    }
+
+    if ((status & 2) && !dma_length && (cycles < dma_endCycles) && (dma_endCycles < limit))
+    {
+      limit = dma_endCycles;
+    }
+
+    m68k_idle_limit(limit);
+  }
+#endif
+
 #ifdef LOGVDP
   error("[%d(%d)][%d(%d)] VDP 68k status read -> 0x%x (0x%x) (%x)\n", v_counter, (v_counter + cycles/MCYCLES_PER_LINE)%lines_per_frame, cycles + mcycles_vdp, cycles%MCYCLES_PER_LINE, temp, status, m68k_get_reg(M68K_REG_PC));
 #endif
@@ -1263,6 +1344,9 @@ unsigned int vdp_z80_ctrl_r(unsigned int cycles)
 {
   unsigned int temp;
 
+  /* Wait for pending lines to be rendered */
+  render_sync();
+
   /* Check if DMA busy flag is set (Mega Drive VDP specific) */
   if (status & 2)
   {
@@ -1303,6 +1387,10 @@ unsigned int vdp_z80_ctrl_r(unsigned int cycles)
     }
   }
 
+  /* Latch SOVR & SCOL flags from rendered lines */
+  status |= spr_status;
+  spr_status = 0;
+
   /* Return VDP status */
   temp = status;
 
@@ -1342,6 +1430,7 @@ unsigned int vdp_z80_ctrl_r(unsigned int cycles)
       if ((cycles % MCYCLES_PER_LINE) < 105)
       {
         status |= 0x20;
+        spr_status |= 0x20;
         temp &= ~0x20;
       }
     }
@@ -1352,6 +1441,7 @@ unsigned int vdp_z80_ctrl_r(unsigned int cycles)
       if ((hc < (spr_col & 0xff)) || (hc > 0xf3))
       {
         status |= 0x20;
+        spr_status |= 0x20;
         temp &= ~0x20;
       }
     }
@@ -1607,6 +1697,7 @@ static void vdp_reg_w(unsigned int r, unsigned int d, unsigned int cycles)
           
           /* make temporary copy of 16KB VRAM */
           memcpy(vram + 0x4000, vram, 0x4000);
+          memset(vram_dirty, 1, sizeof(vram_dirty));
 
           /* re-arrange 16KB VRAM address decoding */
           if (d & 0x80)
@@ -1732,6 +1823,7 @@ static void vdp_reg_w(unsigned int r, unsigned int d, unsigned int cycles)
           {
             /* Mode 5 rendering */
             parse_satb = parse_satb_m5;
+            parse_obj = parse_obj_m5;
             update_bg_pattern_cache = update_bg_pattern_cache_m5;
             if (im2_flag)
             {
@@ -1774,6 +1866,7 @@ static void vdp_reg_w(unsigned int r, unsigned int d, unsigned int cycles)
           {
             /* Mode 4 rendering */
             parse_satb = parse_satb_m4;
+            parse_obj = parse_obj_m4;
             update_bg_pattern_cache = update_bg_pattern_cache_m4;
             render_bg = render_bg_m4;
             render_obj = render_obj_m4;
@@ -2188,6 +2281,7 @@ static void vdp_bus_w(unsigned int data)
 
         /* Write CRAM data */
         *p = data;
+        MARK_STATE_DIRTY(cram_dirty, addr & 0x7E);
 
         /* Color entry 0 of each palette is never displayed (transparent pixel) */
         if (index & 0x0F)
@@ -2224,6 +2318,7 @@ static void vdp_bus_w(unsigned int data)
     case 0x05:  /* VSRAM */
     {
       *(uint16 *)&vsram[addr & 0x7E] = data;
+      MARK_STATE_DIRTY(vsram_dirty, addr & 0x7E);
 
       /* 2-cell Vscroll mode */
       if (reg[11] & 0x04)
@@ -2267,6 +2362,9 @@ static void vdp_bus_w(unsigned int data)
 
 static void vdp_68k_data_w_m4(unsigned int data)
 {
+  /* Wait for pending lines to be rendered */
+  render_sync();
+
   /* Clear pending flag */
   pending = 0;
 
@@ -2317,6 +2415,7 @@ static void vdp_68k_data_w_m4(unsigned int data)
     {
       /* Write CRAM data */
       *p = data;
+      MARK_STATE_DIRTY(cram_dirty, index << 1);
 
       /* Update color palette */
       color_update_m4(index, data);
@@ -2361,6 +2460,9 @@ static void vdp_68k_data_w_m4(unsigned int data)
 
 static void vdp_68k_data_w_m5(unsigned int data)
 {
+  /* Wait for pending lines to be rendered */
+  render_sync();
+
   /* Clear pending flag */
   pending = 0;
 
@@ -2552,6 +2654,9 @@ static unsigned int vdp_68k_data_r_m5(void)
 
 static void vdp_z80_data_w_m4(unsigned int data)
 {
+  /* Wait for pending lines to be rendered */
+  render_sync();
+
   /* Clear pending flag */
   pending = 0;
 
@@ -2569,6 +2674,7 @@ static void vdp_z80_data_w_m4(unsigned int data)
     {
       /* Write CRAM data */
       *p = data;
+      MARK_STATE_DIRTY(cram_dirty, index << 1);
 
       /* Update color palette */
       color_update_m4(index, data);
@@ -2604,6 +2710,9 @@ static void vdp_z80_data_w_m4(unsigned int data)
 
 static void vdp_z80_data_w_m5(unsigned int data)
 {
+  /* Wait for pending lines to be rendered */
+  render_sync();
+
   /* Clear pending flag */
   pending = 0;
 
@@ -2665,6 +2774,7 @@ static void vdp_z80_data_w_m5(unsigned int data)
 
         /* Write CRAM data */
         *p = data;
+        MARK_STATE_DIRTY(cram_dirty, addr & 0x7E);
 
         /* Color entry 0 of each palette is never displayed (transparent pixel) */
         if (index & 0x0F)
@@ -2686,6 +2796,7 @@ static void vdp_z80_data_w_m5(unsigned int data)
     {
       /* Write low byte to even address & high byte to odd address */
       WRITE_BYTE(vsram, (addr & 0x7F) ^ 1, data);
+      MARK_STATE_DIRTY(vsram_dirty, addr & 0x7F);
       break;
     }
   }
@@ -2840,6 +2951,7 @@ static void vdp_z80_data_w_ms(unsigned int data)
     {
       /* Write CRAM data */
       *p = data;
+      MARK_STATE_DIRTY(cram_dirty, index << 1);
 
       /* Update color palette */
       color_update_m4(index, data);
@@ -2920,6 +3032,7 @@ static void vdp_z80_data_w_gg(unsigned int data)
         
         /* Write CRAM data */
         *p = data;
+        MARK_STATE_DIRTY(cram_dirty, addr & 0x3E);
 
         /* Update color palette */
         color_update_m4(index, data);
@@ -2958,6 +3071,7 @@ static void vdp_z80_data_w_sg(unsigned int data)
 
   /* VRAM write */
   vram[index] = data;
+  MARK_STATE_DIRTY(vram_dirty, index);
 
   /* Update address register */
   addr++;
@@ -3181,6 +3295,7 @@ static void vdp_dma_fill(unsigned int length)
 
           /* Write CRAM data */
           *p = data;
+          MARK_STATE_DIRTY(cram_dirty, addr & 0x7E);
 
           /* Color entry 0 of each palette is never displayed (transparent pixel) */
           if (index & 0x0F)
@@ -3212,6 +3327,7 @@ static void vdp_dma_fill(unsigned int length)
       {
         /* Write VSRAM data */
         *(uint16 *)&vsram[addr & 0x7E] = data;
+        MARK_STATE_DIRTY(vsram_dirty, addr & 0x7E);
           
         /* Increment VSRAM address */
         addr += reg[15];
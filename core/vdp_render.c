@@ -43,6 +43,19 @@
 #include "shared.h"
 #include "md_ntsc.h"
 #include "sms_ntsc.h"
+#include "simd.h"
+
+#ifdef HAVE_SIMD_AVX2
+#include <immintrin.h>
+#endif
+
+#ifdef USE_THREADED_RENDERER
+#include <pthread.h>
+#include <unistd.h>
+static void render_thread_start(void);
+#endif
+
+static void update_bg_pattern_m5(unsigned int name);
 
 #ifndef HAVE_NO_SPRITE_LIMIT
 #define MAX_SPRITES_PER_LINE 20
@@ -67,6 +80,12 @@ extern sms_ntsc_t *sms_ntsc;
 #endif
 
 
+#if defined(HAVE_SIMD_AVX2) && !defined(USE_8BPP_RENDERING)
+/* AVX2 pixel conversion (set on initialization, shared by all threads) */
+static int remap_avx2;
+#endif
+
+
 /* Pixel priority look-up tables information */
 #define LUT_MAX     (6)
 #define LUT_SIZE    (0x10000)
@@ -118,6 +137,25 @@ INLINE void WRITE_LONG(void *address, uint32 data)
 #endif  /* ALIGN_LONG */
 
 
+/* Pattern cache statistics are only counted on demand (hot path, shared with render thread) */
+#ifdef USE_PATTERN_STATS
+#define PATTERN_STATS(counter) pattern_stats.counter++
+#else
+#define PATTERN_STATS(counter)
+#endif
+
+/* Decode modified pattern before one of its lines is drawn (Mode 5) */
+/* Pattern cache address: VHN NNNNNNNN NNYYYxxx (see below) */
+#define UPDATE_PATTERN_M5(SRC) \
+{ \
+  uint32 cache_name = (((uint8 *)(SRC) - bg_pattern_cache) >> 6) & 0x7FF; \
+  PATTERN_STATS(drawn); \
+  if (UNLIKELY(bg_name_dirty[cache_name])) \
+  { \
+    update_bg_pattern_m5(cache_name); \
+  } \
+}
+
 /* Draw 2-cell column (8-pixels high) */
 /*
    Pattern cache base address: VHN NNNNNNNN NNYYYxxx
@@ -130,10 +168,12 @@ INLINE void WRITE_LONG(void *address, uint32 data)
 */
 #define GET_LSB_TILE(ATTR, LINE) \
   atex = atex_table[(ATTR >> 13) & 7]; \
-  src = (uint32 *)&bg_pattern_cache[(ATTR & 0x00001FFF) << 6 | (LINE)];
+  src = (uint32 *)&bg_pattern_cache[(ATTR & 0x00001FFF) << 6 | (LINE)]; \
+  UPDATE_PATTERN_M5(src)
 #define GET_MSB_TILE(ATTR, LINE) \
   atex = atex_table[(ATTR >> 29) & 7]; \
-  src = (uint32 *)&bg_pattern_cache[(ATTR & 0x1FFF0000) >> 10 | (LINE)];
+  src = (uint32 *)&bg_pattern_cache[(ATTR & 0x1FFF0000) >> 10 | (LINE)]; \
+  UPDATE_PATTERN_M5(src)
 
 /* Draw 2-cell column (16 pixels high) */
 /*
@@ -147,10 +187,12 @@ INLINE void WRITE_LONG(void *address, uint32 data)
 */
 #define GET_LSB_TILE_IM2(ATTR, LINE) \
   atex = atex_table[(ATTR >> 13) & 7]; \
-  src = (uint32 *)&bg_pattern_cache[((ATTR & 0x000003FF) << 7 | (ATTR & 0x00001800) << 6 | (LINE)) ^ ((ATTR & 0x00001000) >> 6)];
+  src = (uint32 *)&bg_pattern_cache[((ATTR & 0x000003FF) << 7 | (ATTR & 0x00001800) << 6 | (LINE)) ^ ((ATTR & 0x00001000) >> 6)]; \
+  UPDATE_PATTERN_M5(src)
 #define GET_MSB_TILE_IM2(ATTR, LINE) \
   atex = atex_table[(ATTR >> 29) & 7]; \
-  src = (uint32 *)&bg_pattern_cache[((ATTR & 0x03FF0000) >> 9 | (ATTR & 0x18000000) >> 10 | (LINE)) ^ ((ATTR & 0x10000000) >> 22)];
+  src = (uint32 *)&bg_pattern_cache[((ATTR & 0x03FF0000) >> 9 | (ATTR & 0x18000000) >> 10 | (LINE)) ^ ((ATTR & 0x10000000) >> 22)]; \
+  UPDATE_PATTERN_M5(src)
 
 /*
    One column = 2 tiles
@@ -426,7 +468,7 @@ INLINE void WRITE_LONG(void *address, uint32 data)
     { \
       temp |= (lb[i] << 8); \
       lb[i] = TABLE[temp | ATTR]; \
-      status |= ((temp & 0x8000) >> 10); \
+      spr_status |= ((temp & 0x8000) >> 10); \
     } \
   }
 
@@ -438,10 +480,10 @@ INLINE void WRITE_LONG(void *address, uint32 data)
     { \
       temp |= (lb[i] << 8); \
       lb[i] = TABLE[temp | ATTR]; \
-      if ((temp & 0x8000) && !(status & 0x20)) \
+      if ((temp & 0x8000) && !(spr_status & 0x20)) \
       { \
         spr_col = (v_counter << 8) | ((xpos + i + 13) >> 1); \
-        status |= 0x20; \
+        spr_status |= 0x20; \
       } \
     } \
   }
@@ -454,18 +496,18 @@ INLINE void WRITE_LONG(void *address, uint32 data)
     { \
       temp |= (lb[i] << 8); \
       lb[i] = TABLE[temp | ATTR]; \
-      if ((temp & 0x8000) && !(status & 0x20)) \
+      if ((temp & 0x8000) && !(spr_status & 0x20)) \
       { \
         spr_col = (v_counter << 8) | ((xpos + i + 13) >> 1); \
-        status |= 0x20; \
+        spr_status |= 0x20; \
       } \
       temp &= 0x00FF; \
       temp |= (lb[i+1] << 8); \
       lb[i+1] = TABLE[temp | ATTR]; \
-      if ((temp & 0x8000) && !(status & 0x20)) \
+      if ((temp & 0x8000) && !(spr_status & 0x20)) \
       { \
         spr_col = (v_counter << 8) | ((xpos + i + 1 + 13) >> 1); \
-        status |= 0x20; \
+        spr_status |= 0x20; \
       } \
     } \
   }
@@ -494,7 +536,7 @@ INLINE void WRITE_LONG(void *address, uint32 data)
 #endif
 
 /* Window & Plane A clipping */
-static struct clip_t
+static THREAD_LOCAL struct clip_t
 {
   uint8 left;
   uint8 right;
@@ -562,7 +604,12 @@ static const uint32 tms_palette[16] =
 #endif
 
 /* Cached and flipped patterns */
-static uint8 ALIGNED_(4) bg_pattern_cache[0x80000];
+static THREAD_LOCAL uint8 ALIGNED_(4) bg_pattern_cache[0x80000];
+
+#ifdef USE_PATTERN_STATS
+/* Pattern cache statistics (Mode 5) */
+THREAD_LOCAL t_pattern_stats pattern_stats;
+#endif
 
 /* Sprite pattern name offset look-up table (Mode 5) */
 static uint8 name_lut[0x400];
@@ -570,19 +617,25 @@ static uint8 name_lut[0x400];
 /* Bitplane to packed pixel look-up table (Mode 4) */
 static uint32 bp_lut[0x10000];
 
+/* Non-zero pixel data nibbles to pixel opacity mask look-up table (Mode 5, render-less mode) */
+static uint8 opaque_lut[2][0x100];
+
+/* Pixel opacity mask to sprite pixel markers look-up table (render-less mode) */
+static uint32 marker_lut[0x10];
+
 /* Layer priority pixel look-up tables */
 static uint8 lut[LUT_MAX][LUT_SIZE];
 
 /* Output pixel data look-up tables*/
-static PIXEL_OUT_T pixel[0x100];
+static THREAD_LOCAL PIXEL_OUT_T pixel[0x100 + 1];  /* extra entry for 32-bit reads of last color */
 static PIXEL_OUT_T pixel_lut[3][0x200];
 static PIXEL_OUT_T pixel_lut_m4[0x40];
 
 /* Background & Sprite line buffers */
-static uint8 linebuf[2][0x200];
+static THREAD_LOCAL uint8 linebuf[2][0x200];
 
 /* Sprite limit flag */
-static uint8 spr_ovr;
+static THREAD_LOCAL uint8 spr_ovr;
 
 /* Sprite parsing lists */
 typedef struct
@@ -593,19 +646,23 @@ typedef struct
   uint16 size;
 } object_info_t;
 
-static object_info_t obj_info[2][MAX_SPRITES_PER_LINE];
+static THREAD_LOCAL object_info_t obj_info[2][MAX_SPRITES_PER_LINE];
 
 /* Sprite Counter */
-static uint8 object_count[2];
+static THREAD_LOCAL uint8 object_count[2];
 
 /* Sprite Collision Info */
-uint16 spr_col;
+THREAD_LOCAL uint16 spr_col;
+
+/* SOVR & SCOL flags (latched into VDP status register when read, SCOL remains set while pending in VDP status so that only first collision position is recorded) */
+THREAD_LOCAL uint16 spr_status;
 
 /* Function pointers */
-void (*render_bg)(int line);
-void (*render_obj)(int line);
-void (*parse_satb)(int line);
-void (*update_bg_pattern_cache)(int index);
+THREAD_LOCAL void (*render_bg)(int line);
+THREAD_LOCAL void (*render_obj)(int line);
+THREAD_LOCAL void (*parse_satb)(int line);
+THREAD_LOCAL void (*parse_obj)(int line);
+THREAD_LOCAL void (*update_bg_pattern_cache)(int index);
 
 
 /*--------------------------------------------------------------------------*/
@@ -647,6 +704,45 @@ static void make_name_lut(void)
 }
 
 
+/*--------------------------------------------------------------------------*/
+/* Sprite pixel opacity look-up tables function (render-less mode)          */
+/*--------------------------------------------------------------------------*/
+
+static void make_parse_lut(void)
+{
+  int i, x;
+  uint8 markers[4];
+
+  for (i = 0; i < 0x100; i++)
+  {
+    opaque_lut[0][i] = opaque_lut[1][i] = 0;
+
+    for (x = 0; x < 8; x++)
+    {
+#ifdef LSB_FIRST
+      /* Byteplane data = (msb) p4p5 p6p7 p0p1 p2p3 (lsb) */
+      if (i & (1 << (x ^ 3))) opaque_lut[0][i] |= (1 << x);
+      if (i & (1 << (x ^ 4))) opaque_lut[1][i] |= (1 << x);
+#else
+      /* Byteplane data = (msb) p0p1 p2p3 p4p5 p6p7 (lsb) */
+      if (i & (1 << (x ^ 7))) opaque_lut[0][i] |= (1 << x);
+      if (i & (1 << x)) opaque_lut[1][i] |= (1 << x);
+#endif
+    }
+  }
+
+  for (i = 0; i < 0x10; i++)
+  {
+    for (x = 0; x < 4; x++)
+    {
+      markers[x] = (i & (1 << x)) ? 0x80 : 0x00;
+    }
+
+    memcpy(&marker_lut[i], markers, 4);
+  }
+}
+
+
 /*--------------------------------------------------------------------------*/
 /* Bitplane to packed pixel look-up table function (Mode 4)                 */
 /*--------------------------------------------------------------------------*/
@@ -3554,7 +3650,7 @@ void render_obj_tms(int line)
   width <<= (reg[1] & 0x01);
 
   /* Latch SOVR flag from previous line to VDP status */
-  status |= spr_ovr;
+  spr_status |= spr_ovr;
 
   /* Clear SOVR flag for current line */
   spr_ovr = 0;
@@ -3622,11 +3718,11 @@ void render_obj_tms(int line)
         temp = temp * color;
         temp |= (lb[x] << 8);
         lb[x] = lut[5][temp];
-        status |= ((temp & 0x8000) >> 10);
+        spr_status |= ((temp & 0x8000) >> 10);
         temp &= 0x00FF;
         temp |= (lb[x+1] << 8);
         lb[x+1] = lut[5][temp];
-        status |= ((temp & 0x8000) >> 10);
+        spr_status |= ((temp & 0x8000) >> 10);
       }
     }
     else
@@ -3639,7 +3735,7 @@ void render_obj_tms(int line)
         temp = temp * color;
         temp |= (lb[x] << 8);
         lb[x] = lut[5][temp];
-        status |= ((temp & 0x8000) >> 10);
+        spr_status |= ((temp & 0x8000) >> 10);
       }
     }
 
@@ -3695,7 +3791,7 @@ void render_obj_m4(int line)
   }
 
   /* Latch SOVR flag from previous line to VDP status */
-  status |= spr_ovr;
+  spr_status |= spr_ovr;
 
   /* Clear SOVR flag for current line */
   spr_ovr = 0;
@@ -3869,6 +3965,7 @@ void render_obj_m5(int line)
       {
         temp = attr | ((name + s[column]) & 0x07FF);
         src = &bg_pattern_cache[(temp << 6) | (v_line)];
+        UPDATE_PATTERN_M5(src)
         DRAW_SPRITE_TILE(8,atex,lut[1])
       }
     }
@@ -3981,6 +4078,7 @@ void render_obj_m5_ste(int line)
       {
         temp = attr | ((name + s[column]) & 0x07FF);
         src = &bg_pattern_cache[(temp << 6) | (v_line)];
+        UPDATE_PATTERN_M5(src)
         DRAW_SPRITE_TILE(8,atex,lut[3])
       }
     }
@@ -4097,6 +4195,7 @@ void render_obj_m5_im2(int line)
       {
         temp = attr | (((name + s[column]) & 0x3ff) << 1);
         src = &bg_pattern_cache[((temp << 6) | (v_line)) ^ ((attr & 0x1000) >> 6)];
+        UPDATE_PATTERN_M5(src)
         DRAW_SPRITE_TILE(8,atex,lut[1])
       }
     }
@@ -4210,6 +4309,7 @@ void render_obj_m5_im2_ste(int line)
       {
         temp = attr | (((name + s[column]) & 0x3ff) << 1);
         src = &bg_pattern_cache[((temp << 6) | (v_line)) ^ ((attr & 0x1000) >> 6)];
+        UPDATE_PATTERN_M5(src)
         DRAW_SPRITE_TILE(8,atex,lut[3])
       }
     }
@@ -4478,7 +4578,7 @@ void parse_satb_m5(int line)
         /* Sprite overflow */
         if (count == max)
         {
-          status |= 0x40;
+          spr_status |= 0x40;
           break;
         }
 
@@ -4510,209 +4610,672 @@ void parse_satb_m5(int line)
 
 
 /*--------------------------------------------------------------------------*/
-/* Pattern cache update function                                            */
+/* Sprites status update functions (no rendering)                           */
 /*--------------------------------------------------------------------------*/
 
-void update_bg_pattern_cache_m4(int index)
+/* Sprites are processed exactly like render_obj_xxx() functions do, except that  */
+/* only the opaque sprite pixel marker (d7) is updated in the line buffer, so that */
+/* sprite collision, overflow & masking state remain identical without patterns    */
+/* being decoded or any pixel being rendered.                                      */
+
+#define PARSE_SPRITE_PIXEL_ACCURATE(X) \
+{ \
+  if ((lb[X] & 0x80) && !(spr_status & 0x20)) \
+  { \
+    spr_col = (v_counter << 8) | ((xpos + (X) + 13) >> 1); \
+    spr_status |= 0x20; \
+  } \
+  lb[X] |= 0x80; \
+}
+
+/* Mode 5 pattern line opacity (bit x set if pixel x is not transparent, horizontal flip applied) */
+INLINE unsigned int pattern_mask_m5(uint32 bp, uint32 hflip)
 {
-  int i;
-  uint8 x, y, c;
-  uint8 *dst;
-  uint16 name, bp01, bp23;
-  uint32 bp;
+  /* bit 4n set if pixel data nibble n is not zero */
+  bp |= (bp >> 1);
+  bp |= (bp >> 2);
+  bp &= 0x11111111;
 
-  for(i = 0; i < index; i++)
-  {
-    /* Get modified pattern name index */
-    name = bg_name_list[i];
+  /* pack to bit n */
+  bp = (bp | (bp >> 3)) & 0x03030303;
+  bp = (bp | (bp >> 6)) & 0x000F000F;
+  bp = (bp | (bp >> 12)) & 0xFF;
 
-    /* Pattern cache base address */
-    dst = &bg_pattern_cache[name << 6];
+  return opaque_lut[hflip ? 1 : 0][bp];
+}
 
-    /* Check modified lines */
-    for(y = 0; y < 8; y++)
-    {
-      if(bg_name_dirty[name] & (1 << y))
-      {
-        /* Byteplane data */
-        bp01 = *(uint16 *)&vram[(name << 5) | (y << 2) | (0)];
-        bp23 = *(uint16 *)&vram[(name << 5) | (y << 2) | (2)];
+void parse_obj_tms(int line)
+{
+  int x, start, end;
+  uint8 *lb, *sg;
+  uint8 color, pattern[2];
+  uint16 temp;
 
-        /* Convert to pixel line data (4 bytes = 8 pixels)*/
-        /* (msb) p7p6 p5p4 p3p2 p1p0 (lsb) */
-        bp = (bp_lut[bp01] >> 2) | (bp_lut[bp23]);
+  /* Sprite list for current line */
+  object_info_t *object_info = obj_info[line & 1];
+  int count = object_count[line & 1];
 
-        /* Update cached line (8 pixels = 8 bytes) */
-        for(x = 0; x < 8; x++)
-        {
-          /* Extract pixel data */
-          c = bp & 0x0F;
+  /* Default sprite width (8 pixels) */
+  int width = 8;
 
-          /* Pattern cache data (one pattern = 8 bytes) */
-          /* byte0 <-> p0 p1 p2 p3 p4 p5 p6 p7 <-> byte7 (hflip = 0) */
-          /* byte0 <-> p7 p6 p5 p4 p3 p2 p1 p0 <-> byte7 (hflip = 1) */
-          dst[0x00000 | (y << 3) | (x)] = (c);            /* vflip=0 & hflip=0 */
-          dst[0x08000 | (y << 3) | (x ^ 7)] = (c);        /* vflip=0 & hflip=1 */
-          dst[0x10000 | ((y ^ 7) << 3) | (x)] = (c);      /* vflip=1 & hflip=0 */
-          dst[0x18000 | ((y ^ 7) << 3) | (x ^ 7)] = (c);  /* vflip=1 & hflip=1 */
+  /* Adjust width for 16x16 sprites */
+  width <<= ((reg[1] & 0x02) >> 1);
 
-          /* Next pixel */
-          bp = bp >> 4;
-        }
-      }
-    }
+  /* Adjust width for zoomed sprites */
+  width <<= (reg[1] & 0x01);
 
-    /* Clear modified pattern flag */
-    bg_name_dirty[name] = 0;
-  }
-}
+  /* Sprite pixel markers are cleared by background layer */
+  memset(&linebuf[0][0x20], 0, 256);
 
-void update_bg_pattern_cache_m5(int index)
-{
-  int i;
-  uint8 x, y, c;
-  uint8 *dst;
-  uint16 name;
-  uint32 bp;
+  /* Latch SOVR flag from previous line to VDP status */
+  spr_status |= spr_ovr;
 
-  for(i = 0; i < index; i++)
+  /* Clear SOVR flag for current line */
+  spr_ovr = 0;
+
+  /* Process sprites in front-to-back order */
+  while (count--)
   {
-    /* Get modified pattern name index */
-    name = bg_name_list[i];
+    /* Sprite X position */
+    start = object_info->xpos;
 
-    /* Pattern cache base address */
-    dst = &bg_pattern_cache[name << 6];
+    /* Sprite Color + Early Clock bit */
+    color = object_info->size;
 
-    /* Check modified lines */
-    for(y = 0; y < 8; y ++)
-    {
-      if(bg_name_dirty[name] & (1 << y))
-      {
-        /* Byteplane data (one pattern = 4 bytes) */
-        /* LIT_ENDIAN: byte0 (lsb) p2p3 p0p1 p6p7 p4p5 (msb) byte3 */
-        /* BIG_ENDIAN: byte0 (msb) p0p1 p2p3 p4p5 p6p7 (lsb) byte3 */
-        bp = *(uint32 *)&vram[(name << 5) | (y << 2)];
+    /* X position shift (32 pixels) */
+    start -= ((color & 0x80) >> 2);
 
-        /* Update cached line (8 pixels = 8 bytes) */
-        for(x = 0; x < 8; x ++)
-        {
-          /* Extract pixel data */
-          c = bp & 0x0F;
+    /* Pointer to line buffer */
+    lb = &linebuf[0][0x20 + start];
 
-          /* Pattern cache data (one pattern = 8 bytes) */
-          /* byte0 <-> p0 p1 p2 p3 p4 p5 p6 p7 <-> byte7 (hflip = 0) */
-          /* byte0 <-> p7 p6 p5 p4 p3 p2 p1 p0 <-> byte7 (hflip = 1) */
-#ifdef LSB_FIRST
-          /* Byteplane data = (msb) p4p5 p6p7 p0p1 p2p3 (lsb) */
-          dst[0x00000 | (y << 3) | (x ^ 3)] = (c);        /* vflip=0, hflip=0 */
-          dst[0x20000 | (y << 3) | (x ^ 4)] = (c);        /* vflip=0, hflip=1 */
-          dst[0x40000 | ((y ^ 7) << 3) | (x ^ 3)] = (c);  /* vflip=1, hflip=0 */
-          dst[0x60000 | ((y ^ 7) << 3) | (x ^ 4)] = (c);  /* vflip=1, hflip=1 */
-#else
-          /* Byteplane data = (msb) p0p1 p2p3 p4p5 p6p7 (lsb) */
-          dst[0x00000 | (y << 3) | (x ^ 7)] = (c);        /* vflip=0, hflip=0 */
-          dst[0x20000 | (y << 3) | (x)] = (c);            /* vflip=0, hflip=1 */
-          dst[0x40000 | ((y ^ 7) << 3) | (x ^ 7)] = (c);  /* vflip=1, hflip=0 */
-          dst[0x60000 | ((y ^ 7) << 3) | (x)] = (c);      /* vflip=1, hflip=1 */
-#endif
-          /* Next pixel */
-          bp = bp >> 4;
-        }
-      }
+    if ((start + width) > 256)
+    {
+      /* Clip sprites on right edge */
+      end = 256 - start;
+      start = 0;
     }
+    else
+    {
+      end = width;
 
-    /* Clear modified pattern flag */
-    bg_name_dirty[name] = 0;
-  }
-}
+      if (start < 0)
+      {
+        /* Clip sprites on left edge */
+        start = 0 - start;
+      }
+      else
+      {
+        start = 0;
+      }
+    }
 
+    /* Sprite Color (0-15) */
+    color &= 0x0F;
 
-/*--------------------------------------------------------------------------*/
-/* Window & Plane A clipping update function (Mode 5)                       */
-/*--------------------------------------------------------------------------*/
+    /* Sprite Pattern Name */
+    temp = object_info->attr;
 
-void window_clip(unsigned int data, unsigned int sw)
-{
-  /* Window size and invert flags */
-  int hp = (data & 0x1f);
-  int hf = (data >> 7) & 1;
+    /* Mask two LSB for 16x16 sprites */
+    temp &= ~((reg[1] & 0x02) >> 0);
+    temp &= ~((reg[1] & 0x02) >> 1);
 
-  /* Perform horizontal clipping; the results are applied in reverse
-     if the horizontal inversion flag is set
-   */
-  int a = hf;
-  int w = hf ^ 1;
+    /* Pointer to sprite generator table */
+    sg = (uint8 *)&vram[((reg[6] << 11) & 0x3800) | (temp << 3) | object_info->ypos];
 
-  /* Display width (16 or 20 columns) */
-  sw = 16 + (sw << 2);
+    /* Sprite Pattern data (2 x 8 pixels), transparent with color 0 */
+    pattern[0] = color ? sg[0x00] : 0;
+    pattern[1] = color ? sg[0x10] : 0;
 
-  if(hp)
-  {
-    if(hp > sw)
+    if (reg[1] & 0x01)
     {
-      /* Plane W takes up entire line */
-      clip[w].left = 0;
-      clip[w].right = sw;
-      clip[w].enable = 1;
-      clip[a].enable = 0;
+      /* Zoomed sprites are processed at half speed */
+      for (x=start; x<end; x+=2)
+      {
+        temp = ((pattern[(x >> 4) & 1] >> (7 - ((x >> 1) & 7))) & 0x01) << 7;
+        spr_status |= ((lb[x] & 0x80) >> 2);
+        lb[x] |= temp;
+        spr_status |= ((lb[x+1] & 0x80) >> 2);
+        lb[x+1] |= temp;
+      }
     }
     else
     {
-      /* Plane W takes left side, Plane A takes right side */
-      clip[w].left = 0;
-      clip[a].right = sw;
-      clip[a].left = clip[w].right = hp;
-      clip[0].enable = clip[1].enable = 1;
+      /* Normal sprites */
+      for (x=start; x<end; x++)
+      {
+        temp = ((pattern[(x >> 3) & 1] >> (7 - (x & 7))) & 0x01) << 7;
+        spr_status |= ((lb[x] & 0x80) >> 2);
+        lb[x] |= temp;
+      }
     }
-  }
-  else
-  {
-    /* Plane A takes up entire line */
-    clip[a].left = 0;
-    clip[a].right = sw;
-    clip[a].enable = 1;
-    clip[w].enable = 0;
+
+    /* Next sprite entry */
+    object_info++;
   }
 }
 
+void parse_obj_m4(int line)
+{
+  int i, xpos, end, offset;
+  uint8 *lb, *bp;
+  uint16 temp;
+  uint32 mask;
 
-/*--------------------------------------------------------------------------*/
-/* Init, reset routines                                                     */
-/*--------------------------------------------------------------------------*/
+  /* Sprite list for current line */
+  object_info_t *object_info = obj_info[line & 1];
+  int count = object_count[line & 1];
 
-void render_init(void)
-{
-  int bx, ax;
+  /* Default sprite width */
+  int width = 8;
 
-  /* Initialize layers priority pixel look-up tables */
-  uint16 index;
-  for (bx = 0; bx < 0x100; bx++)
-  {
-    for (ax = 0; ax < 0x100; ax++)
-    {
-      index = (bx << 8) | (ax);
+  /* Sprite Generator address mask (LSB is masked for 8x16 sprites) */
+  uint16 sg_mask = (~0x1C0 ^ (reg[6] << 6)) & (~((reg[1] & 0x02) >> 1));
 
-      lut[0][index] = make_lut_bg(bx, ax);
-      lut[1][index] = make_lut_bgobj(bx, ax);
-      lut[2][index] = make_lut_bg_ste(bx, ax);
-      lut[3][index] = make_lut_obj(bx, ax);
-      lut[4][index] = make_lut_bgobj_ste(bx, ax);
-      lut[5][index] = make_lut_bgobj_m4(bx,ax);
-    }
+  /* Zoomed sprites (not working on Genesis VDP) */
+  if (system_hw < SYSTEM_MD)
+  {
+    width <<= (reg[1] & 0x01);
   }
 
-  /* Initialize pixel color look-up tables */
+  /* Unused bits used as a mask on 315-5124 VDP only */
+  if (system_hw > SYSTEM_SMS)
+  {
+    sg_mask |= 0xC0;
+  }
+
+  /* Sprite pixel markers are cleared by background layer */
+  memset(&linebuf[0][0x20], 0, 256);
+
+  /* Latch SOVR flag from previous line to VDP status */
+  spr_status |= spr_ovr;
+
+  /* Clear SOVR flag for current line */
+  spr_ovr = 0;
+
+  /* Process sprites in front-to-back order */
+  while (count--)
+  {
+    /* Sprite pattern index */
+    temp = (object_info->attr | 0x100) & sg_mask;
+
+    /* Pointer to pattern line bitplanes (next line is also read when sprite is clipped on left edge) */
+    bp = &vram[(temp << 5) | (object_info->ypos << 2)];
+
+    /* Pattern lines opacity (bit x set if pixel x is not transparent) */
+    mask = bp[0] | bp[1] | bp[2] | bp[3];
+    mask = (mask << 8) | bp[4] | bp[5] | bp[6] | bp[7];
+
+    /* Sprite X position */
+    xpos = object_info->xpos;
+
+    /* X position shift */
+    xpos -= (reg[0] & 0x08);
+
+    if (xpos < 0)
+    {
+      /* Clip sprites on left edge */
+      offset = -xpos;
+      end = xpos + width;
+      xpos = 0;
+    }
+    else if ((xpos + width) > 256)
+    {
+      /* Clip sprites on right edge */
+      offset = 0;
+      end = 256 - xpos;
+    }
+    else
+    {
+      /* Sprite maximal width */
+      offset = 0;
+      end = width;
+    }
+
+    /* Pointer to line buffer */
+    lb = &linebuf[0][0x20 + xpos];
+
+    if (width > 8)
+    {
+      /* Zoomed sprites are processed at half speed */
+      for (i=0; i<end; i+=2, offset++)
+      {
+        if ((mask << offset) & 0x8000)
+        {
+          PARSE_SPRITE_PIXEL_ACCURATE(i)
+          PARSE_SPRITE_PIXEL_ACCURATE(i+1)
+        }
+      }
+
+      /* 315-5124 VDP specific */
+      if (system_hw < SYSTEM_SMS2)
+      {
+        /* only 4 first sprites can be zoomed */
+        if (count == (object_count[line & 1] - 4))
+        {
+          /* Set default width for remaining sprites */
+          width = 8;
+        }
+      }
+    }
+    else
+    {
+      for (i=0; i<end; i++, offset++)
+      {
+        if ((mask << offset) & 0x8000)
+        {
+          PARSE_SPRITE_PIXEL_ACCURATE(i)
+        }
+      }
+    }
+
+    /* Next sprite entry */
+    object_info++;
+  }
+}
+
+void parse_obj_m5(int line)
+{
+  int column;
+  int xpos, width;
+  int pixelcount = 0;
+  int masked = 0;
+  int max_pixels = MODE5_MAX_SPRITE_PIXELS;
+
+  uint8 *s, *lb, *buf;
+  uint32 temp, v_line, mask;
+  uint32 attr, name, addr;
+
+  /* Sprite list for current line */
+  object_info_t *object_info = obj_info[line & 1];
+  int count = object_count[line & 1];
+
+  if (reg[12] & 0x08)
+  {
+    /* Shadow & Highlight mode: sprites are drawn into cleared sprite line buffer */
+    buf = linebuf[1];
+    memset(&buf[0], 0, bitmap.viewport.w + 0x40);
+  }
+  else
+  {
+    /* Sprite pixel markers are cleared where Plane B is drawn (see render_bg_m5) */
+    uint32 xscroll = *(uint32 *)&vram[hscb + ((line & hscroll_mask) << 2)];
+#ifdef LSB_FIRST
+    uint32 shift = (xscroll >> 16) & 0x0F;
+#else
+    uint32 shift = (xscroll & 0x0F);
+#endif
+
+    buf = linebuf[0];
+
+    if (shift)
+    {
+      memset(&buf[0x10 + shift], 0, bitmap.viewport.w + 0x10);
+    }
+    else
+    {
+      memset(&buf[0x20], 0, bitmap.viewport.w);
+    }
+
+#ifdef ALT_RENDERER
+    /* Plane A is first drawn into the same line buffer */
+    if (((reg[18] >> 7) & 1) != (line >= ((reg[18] & 0x1F) << 3)))
+    {
+#ifdef LSB_FIRST
+      shift = (xscroll & 0x0F);
+#else
+      shift = (xscroll >> 16) & 0x0F;
+#endif
+      if (clip[0].enable && shift)
+      {
+        memset(&buf[0x10 + (clip[0].left << 4) + shift], 0, ((clip[0].right - clip[0].left) << 4) + 0x10);
+      }
+    }
+#endif
+  }
+
+  /* Process sprites in front-to-back order */
+  while (count--)
+  {
+    /* Sprite X position */
+    xpos = object_info->xpos;
+
+    /* Sprite masking  */
+    if (xpos)
+    {
+      /* Requires at least one sprite with xpos > 0 */
+      spr_ovr = 1;
+    }
+    else if (spr_ovr)
+    {
+      /* Remaining sprites are not drawn */
+      masked = 1;
+    }
+
+    /* Display area offset */
+    xpos = xpos - 0x80;
+
+    /* Sprite size */
+    temp = object_info->size;
+
+    /* Sprite width */
+    width = 8 + ((temp & 0x0C) << 1);
+
+    /* Update pixel count (off-screen sprites are included) */
+    pixelcount += width;
+
+    /* Is sprite across visible area ? */
+    if (((xpos + width) > 0) && (xpos < bitmap.viewport.w) && !masked)
+    {
+      /* Sprite attributes */
+      attr = object_info->attr;
+
+      /* Sprite vertical offset */
+      v_line = object_info->ypos;
+
+      /* Pointer into pattern name offset look-up table */
+      s = &name_lut[((attr >> 3) & 0x300) | (temp << 4) | ((v_line & 0x18) >> 1)];
+
+      /* Pointer into line buffer */
+      lb = &buf[0x20 + xpos];
+
+      /* Max. number of sprite pixels rendered per line */
+      if (pixelcount > max_pixels)
+      {
+        /* Adjust number of pixels to draw */
+        width -= (pixelcount - max_pixels);
+      }
+
+      /* Number of tiles to draw */
+      width = width >> 3;
+
+      if (im2_flag)
+      {
+        /* Pattern name base (16 lines patterns) */
+        name = attr & 0x03FF;
+
+        /* Pattern line index */
+        v_line = (((v_line & 7) << 1) | odd_frame) ^ ((attr & 0x1000) ? 0x0F : 0x00);
+      }
+      else
+      {
+        /* Pattern name base (8 lines patterns) */
+        name = attr & 0x07FF;
+
+        /* Pattern line index */
+        v_line = (v_line & 7) ^ ((attr & 0x1000) ? 0x07 : 0x00);
+      }
+
+      /* Process sprite patterns */
+      for (column = 0; column < width; column++, lb+=8)
+      {
+        if (im2_flag)
+        {
+          addr = (((name + s[column]) & 0x03FF) << 6) | (v_line << 2);
+        }
+        else
+        {
+          addr = (((name + s[column]) & 0x07FF) << 5) | (v_line << 2);
+        }
+
+        mask = pattern_mask_m5(*(uint32 *)&vram[addr], attr & 0x800);
+
+        if (mask)
+        {
+          /* update 4 pixels at once */
+          uint32 p[2], m[2];
+          m[0] = marker_lut[mask & 0x0F];
+          m[1] = marker_lut[mask >> 4];
+          memcpy(p, lb, 8);
+          if ((p[0] & m[0]) | (p[1] & m[1]))
+          {
+            spr_status |= 0x20;
+          }
+          p[0] |= m[0];
+          p[1] |= m[1];
+          memcpy(lb, p, 8);
+        }
+      }
+    }
+
+    /* Sprite limit */
+    if (pixelcount >= max_pixels)
+    {
+      /* Sprite masking is effective on next line if max pixel width is reached */
+      spr_ovr = (pixelcount >= bitmap.viewport.w);
+
+      /* Stop sprite processing */
+      return;
+    }
+
+    /* Next sprite entry */
+    object_info++;
+  }
+
+  /* Clear sprite masking for next line  */
+  spr_ovr = 0;
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* Pattern cache update function                                            */
+/*--------------------------------------------------------------------------*/
+
+void update_bg_pattern_cache_m4(int index)
+{
+  int i;
+  uint8 x, y, c;
+  uint8 *dst;
+  uint16 name, bp01, bp23;
+  uint32 bp;
+
+  for(i = 0; i < index; i++)
+  {
+    /* Get modified pattern name index */
+    name = bg_name_list[i];
+
+    /* Pattern cache base address */
+    dst = &bg_pattern_cache[name << 6];
+
+    /* Check modified lines */
+    for(y = 0; y < 8; y++)
+    {
+      if(bg_name_dirty[name] & (1 << y))
+      {
+        /* Byteplane data */
+        bp01 = *(uint16 *)&vram[(name << 5) | (y << 2) | (0)];
+        bp23 = *(uint16 *)&vram[(name << 5) | (y << 2) | (2)];
+
+        /* Convert to pixel line data (4 bytes = 8 pixels)*/
+        /* (msb) p7p6 p5p4 p3p2 p1p0 (lsb) */
+        bp = (bp_lut[bp01] >> 2) | (bp_lut[bp23]);
+
+        /* Update cached line (8 pixels = 8 bytes) */
+        for(x = 0; x < 8; x++)
+        {
+          /* Extract pixel data */
+          c = bp & 0x0F;
+
+          /* Pattern cache data (one pattern = 8 bytes) */
+          /* byte0 <-> p0 p1 p2 p3 p4 p5 p6 p7 <-> byte7 (hflip = 0) */
+          /* byte0 <-> p7 p6 p5 p4 p3 p2 p1 p0 <-> byte7 (hflip = 1) */
+          dst[0x00000 | (y << 3) | (x)] = (c);            /* vflip=0 & hflip=0 */
+          dst[0x08000 | (y << 3) | (x ^ 7)] = (c);        /* vflip=0 & hflip=1 */
+          dst[0x10000 | ((y ^ 7) << 3) | (x)] = (c);      /* vflip=1 & hflip=0 */
+          dst[0x18000 | ((y ^ 7) << 3) | (x ^ 7)] = (c);  /* vflip=1 & hflip=1 */
+
+          /* Next pixel */
+          bp = bp >> 4;
+        }
+      }
+    }
+
+    /* Clear modified pattern flag */
+    bg_name_dirty[name] = 0;
+  }
+}
+
+void update_bg_pattern_cache_m5(int index)
+{
+  /* Modified patterns are only decoded when drawn (see update_bg_pattern_m5), */
+  /* patterns modified but not displayed (e.g. VRAM streaming) being skipped */
+}
+
+static void update_bg_pattern_m5(unsigned int name)
+{
+  uint8 x, y, c;
+  uint8 *dst;
+  uint32 bp;
+
+  /* Pattern cache base address */
+  dst = &bg_pattern_cache[name << 6];
+
+  /* Check modified lines */
+  for(y = 0; y < 8; y ++)
+  {
+    if(bg_name_dirty[name] & (1 << y))
+    {
+      /* Byteplane data (one pattern = 4 bytes) */
+      /* LIT_ENDIAN: byte0 (lsb) p2p3 p0p1 p6p7 p4p5 (msb) byte3 */
+      /* BIG_ENDIAN: byte0 (msb) p0p1 p2p3 p4p5 p6p7 (lsb) byte3 */
+      bp = *(uint32 *)&vram[(name << 5) | (y << 2)];
+
+      /* Update cached line (8 pixels = 8 bytes) */
+      for(x = 0; x < 8; x ++)
+      {
+        /* Extract pixel data */
+        c = bp & 0x0F;
+
+        /* Pattern cache data (one pattern = 8 bytes) */
+        /* byte0 <-> p0 p1 p2 p3 p4 p5 p6 p7 <-> byte7 (hflip = 0) */
+        /* byte0 <-> p7 p6 p5 p4 p3 p2 p1 p0 <-> byte7 (hflip = 1) */
+#ifdef LSB_FIRST
+        /* Byteplane data = (msb) p4p5 p6p7 p0p1 p2p3 (lsb) */
+        dst[0x00000 | (y << 3) | (x ^ 3)] = (c);        /* vflip=0, hflip=0 */
+        dst[0x20000 | (y << 3) | (x ^ 4)] = (c);        /* vflip=0, hflip=1 */
+        dst[0x40000 | ((y ^ 7) << 3) | (x ^ 3)] = (c);  /* vflip=1, hflip=0 */
+        dst[0x60000 | ((y ^ 7) << 3) | (x ^ 4)] = (c);  /* vflip=1, hflip=1 */
+#else
+        /* Byteplane data = (msb) p0p1 p2p3 p4p5 p6p7 (lsb) */
+        dst[0x00000 | (y << 3) | (x ^ 7)] = (c);        /* vflip=0, hflip=0 */
+        dst[0x20000 | (y << 3) | (x)] = (c);            /* vflip=0, hflip=1 */
+        dst[0x40000 | ((y ^ 7) << 3) | (x ^ 7)] = (c);  /* vflip=1, hflip=0 */
+        dst[0x60000 | ((y ^ 7) << 3) | (x)] = (c);      /* vflip=1, hflip=1 */
+#endif
+        /* Next pixel */
+        bp = bp >> 4;
+      }
+
+      PATTERN_STATS(decoded);
+    }
+  }
+
+  /* Clear modified pattern flag */
+  bg_name_dirty[name] = 0;
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* Window & Plane A clipping update function (Mode 5)                       */
+/*--------------------------------------------------------------------------*/
+
+void window_clip(unsigned int data, unsigned int sw)
+{
+  /* Window size and invert flags */
+  int hp = (data & 0x1f);
+  int hf = (data >> 7) & 1;
+
+  /* Perform horizontal clipping; the results are applied in reverse
+     if the horizontal inversion flag is set
+   */
+  int a = hf;
+  int w = hf ^ 1;
+
+  /* Display width (16 or 20 columns) */
+  sw = 16 + (sw << 2);
+
+  if(hp)
+  {
+    if(hp > sw)
+    {
+      /* Plane W takes up entire line */
+      clip[w].left = 0;
+      clip[w].right = sw;
+      clip[w].enable = 1;
+      clip[a].enable = 0;
+    }
+    else
+    {
+      /* Plane W takes left side, Plane A takes right side */
+      clip[w].left = 0;
+      clip[a].right = sw;
+      clip[a].left = clip[w].right = hp;
+      clip[0].enable = clip[1].enable = 1;
+    }
+  }
+  else
+  {
+    /* Plane A takes up entire line */
+    clip[a].left = 0;
+    clip[a].right = sw;
+    clip[a].enable = 1;
+    clip[w].enable = 0;
+  }
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* Init, reset routines                                                     */
+/*--------------------------------------------------------------------------*/
+
+void render_init(void)
+{
+  int bx, ax;
+
+  /* Initialize layers priority pixel look-up tables */
+  uint16 index;
+  for (bx = 0; bx < 0x100; bx++)
+  {
+    for (ax = 0; ax < 0x100; ax++)
+    {
+      index = (bx << 8) | (ax);
+
+      lut[0][index] = make_lut_bg(bx, ax);
+      lut[1][index] = make_lut_bgobj(bx, ax);
+      lut[2][index] = make_lut_bg_ste(bx, ax);
+      lut[3][index] = make_lut_obj(bx, ax);
+      lut[4][index] = make_lut_bgobj_ste(bx, ax);
+      lut[5][index] = make_lut_bgobj_m4(bx,ax);
+    }
+  }
+
+  /* Initialize pixel color look-up tables */
   palette_init();
 
   /* Make sprite pattern name index look-up table (Mode 5) */
   make_name_lut();
 
+  /* Initialize render-less mode look-up tables */
+  make_parse_lut();
+
   /* Make bitplane to pixel look-up table (Mode 4) */
   make_bp_lut();
+
+#if defined(HAVE_SIMD_AVX2) && !defined(USE_8BPP_RENDERING)
+  /* Use AVX2 pixel conversion if supported by CPU */
+  remap_avx2 = SIMD_AVX2_SUPPORTED();
+#endif
+
+#ifdef USE_THREADED_RENDERER
+  /* Start line rendering thread */
+  render_thread_start();
+#endif
 }
 
 void render_reset(void)
 {
+  /* Wait for pending lines */
+  render_sync();
+
   /* Clear display bitmap */
   memset(bitmap.data, 0, bitmap.pitch * bitmap.height);
 
@@ -4724,9 +5287,21 @@ void render_reset(void)
 
   /* Clear pattern cache */
   memset ((char *) bg_pattern_cache, 0, sizeof (bg_pattern_cache));
+#ifdef USE_PATTERN_STATS
+  memset(&pattern_stats, 0, sizeof(pattern_stats));
+#endif
 
   /* Reset Sprite infos */
-  spr_ovr = spr_col = object_count[0] = object_count[1] = 0;
+  spr_ovr = spr_col = spr_status = object_count[0] = object_count[1] = 0;
+}
+
+void render_restore(void)
+{
+  /* Wait for pending lines */
+  render_sync();
+
+  /* display bitmap & pattern cache are kept, tiles being all invalidated when VDP state is restored */
+  spr_ovr = spr_col = spr_status = object_count[0] = object_count[1] = 0;
 }
 
 
@@ -4780,7 +5355,7 @@ void render_line(int line)
     if (system_hw < SYSTEM_MD)
     {
       /* Update SOVR flag */
-      status |= spr_ovr;
+      spr_status |= spr_ovr;
       spr_ovr = 0;
 
       /* Sprites are still parsed when display is disabled */
@@ -4795,12 +5370,171 @@ void render_line(int line)
   remap_line(line);
 }
 
+void parse_line(int line)
+{
+  /* Check display status */
+  if (reg[1] & 0x40)
+  {
+    /* Update sprite layer status */
+    parse_obj(line);
+
+    /* Left-most column blanking */
+    if (reg[0] & 0x20)
+    {
+      if (system_hw >= SYSTEM_MARKIII)
+      {
+        memset(&linebuf[0][0x20], 0x40, 8);
+      }
+    }
+
+    /* Parse sprites for next line */
+    if (line < (bitmap.viewport.h - 1))
+    {
+      parse_satb(line);
+    }
+
+    /* Horizontal borders */
+    if (bitmap.viewport.x > 0)
+    {
+      memset(&linebuf[0][0x20 - bitmap.viewport.x], 0x40, bitmap.viewport.x);
+      memset(&linebuf[0][0x20 + bitmap.viewport.w], 0x40, bitmap.viewport.x);
+    }
+  }
+  else
+  {
+    /* Master System & Game Gear VDP specific */
+    if (system_hw < SYSTEM_MD)
+    {
+      /* Update SOVR flag */
+      spr_status |= spr_ovr;
+      spr_ovr = 0;
+
+      /* Sprites are still parsed when display is disabled */
+      parse_satb(line);
+    }
+
+    /* Blanked line */
+    memset(&linebuf[0][0x20 - bitmap.viewport.x], 0x40, bitmap.viewport.w + 2*bitmap.viewport.x);
+  }
+}
+
 void blank_line(int line, int offset, int width)
 {
   memset(&linebuf[0][0x20 + offset], 0x40, width);
   remap_line(line);
 }
 
+#if defined(HAVE_SIMD_AVX2) && !defined(USE_8BPP_RENDERING)
+
+/* Converts pixels 16 at a time using AVX2 gather, returns the number of converted pixels */
+SIMD_AVX2_TARGET static int remap_pixels_avx2(uint8 *src, PIXEL_OUT_T *dst, int width)
+{
+  int count = width & ~15;
+  int x;
+
+  for (x = 0; x < count; x += 16)
+  {
+    __m128i in = _mm_loadu_si128((__m128i const *)&src[x]);
+    __m256i lo = _mm256_cvtepu8_epi32(in);
+    __m256i hi = _mm256_cvtepu8_epi32(_mm_srli_si128(in, 8));
+#ifdef USE_32BPP_RENDERING
+    _mm256_storeu_si256((__m256i *)&dst[x], _mm256_i32gather_epi32((int const *)pixel, lo, 4));
+    _mm256_storeu_si256((__m256i *)&dst[x + 8], _mm256_i32gather_epi32((int const *)pixel, hi, 4));
+#else
+    /* 16-bit pixels are read as 32-bit words then truncated */
+    __m256i mask = _mm256_set1_epi32(0xffff);
+    lo = _mm256_and_si256(_mm256_i32gather_epi32((int const *)pixel, lo, 2), mask);
+    hi = _mm256_and_si256(_mm256_i32gather_epi32((int const *)pixel, hi, 2), mask);
+    _mm256_storeu_si256((__m256i *)&dst[x], _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xd8));
+#endif
+  }
+
+  return count;
+}
+
+#endif
+
+#if defined(HAVE_SIMD) && !defined(USE_8BPP_RENDERING)
+
+/* Converts pixels 8 at a time (looked-up colors are stored as one vector), returns the number of converted pixels */
+static int remap_pixels(uint8 *src, PIXEL_OUT_T *dst, int width)
+{
+  int count = width & ~7;
+  int x;
+
+  for (x = 0; x < count; x += 8)
+  {
+#ifdef USE_32BPP_RENDERING
+    SIMD_STORE(&dst[x], SIMD_SET32X4(pixel[src[x]], pixel[src[x + 1]], pixel[src[x + 2]], pixel[src[x + 3]]));
+    SIMD_STORE(&dst[x + 4], SIMD_SET32X4(pixel[src[x + 4]], pixel[src[x + 5]], pixel[src[x + 6]], pixel[src[x + 7]]));
+#else
+    SIMD_STORE(&dst[x], SIMD_SET16X8(pixel[src[x]], pixel[src[x + 1]], pixel[src[x + 2]], pixel[src[x + 3]],
+                                     pixel[src[x + 4]], pixel[src[x + 5]], pixel[src[x + 6]], pixel[src[x + 7]]));
+#endif
+  }
+
+  return count;
+}
+
+/* Pixel line buffer for LCD ghosting */
+static THREAD_LOCAL PIXEL_OUT_T lcd_line[0x200];
+
+/* Blends one color channel with previous frame pixel, only when previous pixel was brighter */
+#define LCD_BLEND(c_new, c_old, rate) SIMD_ADD16(c_new, SIMD_SRL16(SIMD_MUL16(SIMD_SUBS16(c_old, c_new), rate), 8))
+
+/* Converts pixels with LCD ghosting effect 8 (or 4) at a time, returns the number of converted pixels */
+static int remap_pixels_lcd(uint8 *src, PIXEL_OUT_T *dst, int width, int rate)
+{
+  simd_t r = SIMD_SET16(rate);
+  int count = remap_pixels(src, lcd_line, width);
+  int x;
+
+#if defined(USE_32BPP_RENDERING)
+  {
+    simd_t mask = SIMD_SET32(0x00ff00ff);
+    for (x = 0; x < count; x += 4)
+    {
+      simd_t p_new = SIMD_LOAD(&lcd_line[x]);
+      simd_t p_old = SIMD_LOAD(&dst[x]);
+      simd_t rb = LCD_BLEND(SIMD_AND(p_new, mask), SIMD_AND(p_old, mask), r);
+      simd_t ag = LCD_BLEND(SIMD_AND(SIMD_SRL16(p_new, 8), mask), SIMD_AND(SIMD_SRL16(p_old, 8), mask), r);
+      SIMD_STORE(&dst[x], SIMD_OR(rb, SIMD_SLL16(ag, 8)));
+    }
+  }
+#elif defined(USE_15BPP_RENDERING)
+  {
+    simd_t mask = SIMD_SET16(0x1f);
+    for (x = 0; x < count; x += 8)
+    {
+      simd_t p_new = SIMD_LOAD(&lcd_line[x]);
+      simd_t p_old = SIMD_LOAD(&dst[x]);
+      simd_t c0 = LCD_BLEND(SIMD_AND(SIMD_SRL16(p_new, 10), mask), SIMD_AND(SIMD_SRL16(p_old, 10), mask), r);
+      simd_t c1 = LCD_BLEND(SIMD_AND(SIMD_SRL16(p_new, 5), mask), SIMD_AND(SIMD_SRL16(p_old, 5), mask), r);
+      simd_t c2 = LCD_BLEND(SIMD_AND(p_new, mask), SIMD_AND(p_old, mask), r);
+      SIMD_STORE(&dst[x], SIMD_OR(SIMD_OR(SIMD_SET16(0x8000), SIMD_SLL16(c0, 10)), SIMD_OR(SIMD_SLL16(c1, 5), c2)));
+    }
+  }
+#else
+  {
+    simd_t mask5 = SIMD_SET16(0x1f);
+    simd_t mask6 = SIMD_SET16(0x3f);
+    for (x = 0; x < count; x += 8)
+    {
+      simd_t p_new = SIMD_LOAD(&lcd_line[x]);
+      simd_t p_old = SIMD_LOAD(&dst[x]);
+      simd_t c0 = LCD_BLEND(SIMD_SRL16(p_new, 11), SIMD_SRL16(p_old, 11), r);
+      simd_t c1 = LCD_BLEND(SIMD_AND(SIMD_SRL16(p_new, 5), mask6), SIMD_AND(SIMD_SRL16(p_old, 5), mask6), r);
+      simd_t c2 = LCD_BLEND(SIMD_AND(p_new, mask5), SIMD_AND(p_old, mask5), r);
+      SIMD_STORE(&dst[x], SIMD_OR(SIMD_SLL16(c0, 11), SIMD_OR(SIMD_SLL16(c1, 5), c2)));
+    }
+  }
+#endif
+
+  return count;
+}
+
+#endif
+
 void remap_line(int line)
 {
   /* Line width */
@@ -4844,20 +5578,276 @@ void remap_line(int line)
     PIXEL_OUT_T *dst = ((PIXEL_OUT_T *)&bitmap.data[(line * bitmap.pitch)]);
     if (config.lcd)
     {
-      do
+#if defined(HAVE_SIMD) && !defined(USE_8BPP_RENDERING)
+      int count = remap_pixels_lcd(src, dst, width, config.lcd);
+      src += count;
+      dst += count;
+      width -= count;
+#endif
+      while (width--)
       {
         RENDER_PIXEL_LCD(src,dst,pixel,config.lcd);
       }
-      while (--width);
     }
     else
     {
-      do
+#if defined(HAVE_SIMD_AVX2) && !defined(USE_8BPP_RENDERING)
+      if (remap_avx2)
+      {
+        int count = remap_pixels_avx2(src, dst, width);
+        src += count;
+        dst += count;
+        width -= count;
+      }
+#endif
+#if defined(HAVE_SIMD) && !defined(USE_8BPP_RENDERING)
+      {
+        int count = remap_pixels(src, dst, width);
+        src += count;
+        dst += count;
+        width -= count;
+      }
+#endif
+      while (width--)
       {
         *dst++ = pixel[*src++];
       }
-      while (--width);
     }
  #endif
   }
 }
+
+
+/*--------------------------------------------------------------------------*/
+/* Asynchronous line rendering                                              */
+/*--------------------------------------------------------------------------*/
+
+#ifdef USE_THREADED_RENDERER
+
+/* Lines are queued in order by the emulation thread and rasterized by a worker thread  */
+/* while CPUs keep on running. VDP state used by the renderer is never copied: instead, */
+/* the emulation thread waits for queued lines to be completed (render_sync) before any */
+/* access modifying VRAM, CRAM, VSRAM or VDP registers and before SOVR/SCOL flags are read. */
+/* The queue has a single producer and a single consumer: entries are handed over by    */
+/* batches through head & tail indexes and waiting threads spin before sleeping.        */
+
+#define RENDER_QUEUE_SIZE 512
+
+/* queued entries handed over to worker thread at once */
+#define RENDER_BATCH 8
+
+/* spin iterations before sleeping */
+#define RENDER_SPINS 2048
+
+#define RENDER_CMD_LINE  0
+#define RENDER_CMD_BLANK 1
+#define RENDER_CMD_SATB  2
+#define RENDER_CMD_PARSE 3
+
+typedef struct
+{
+  int16 type;
+  int16 line;
+  int16 offset;
+  int16 width;
+} render_cmd_t;
+
+static render_cmd_t render_queue[RENDER_QUEUE_SIZE];
+static unsigned int render_count; /* next queued entry (emulation thread) */
+static unsigned int render_head;  /* next entry handed over to worker thread */
+static unsigned int render_tail;  /* next rendered entry (worker thread) */
+static unsigned int render_quit;  /* worker thread exit requested */
+static int render_sleeping[2];    /* emulation / worker thread is sleeping */
+static int render_running;
+
+static pthread_t render_thread;
+static pthread_mutex_t render_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t render_wake = PTHREAD_COND_INITIALIZER;
+
+static void render_cmd_exec(render_cmd_t *cmd)
+{
+  switch (cmd->type)
+  {
+    case RENDER_CMD_LINE:
+      render_line(cmd->line);
+      break;
+
+    case RENDER_CMD_BLANK:
+      blank_line(cmd->line, cmd->offset, cmd->width);
+      break;
+
+    case RENDER_CMD_SATB:
+      parse_satb(cmd->line);
+      break;
+
+    default:
+      parse_line(cmd->line);
+      break;
+  }
+}
+
+/* worker thread has entries to render or has to exit */
+static int render_pending(void)
+{
+  return (__atomic_load_n(&render_head, __ATOMIC_ACQUIRE) != render_tail) || __atomic_load_n(&render_quit, __ATOMIC_ACQUIRE);
+}
+
+/* all queued entries have been rendered */
+static int render_done(void)
+{
+  return __atomic_load_n(&render_tail, __ATOMIC_ACQUIRE) == render_count;
+}
+
+/* queue has a free entry */
+static int render_free(void)
+{
+  return (render_count - __atomic_load_n(&render_tail, __ATOMIC_ACQUIRE)) < RENDER_QUEUE_SIZE;
+}
+
+/* wait for condition set by the other thread (0 = emulation thread, 1 = worker thread) */
+static void render_wait_for(int (*ready)(void), int thread)
+{
+  int spins = 0;
+
+  while (!ready())
+  {
+    if (spins++ < RENDER_SPINS)
+    {
+#if defined(__i386__) || defined(__x86_64__)
+      __builtin_ia32_pause();
+#endif
+      continue;
+    }
+
+    pthread_mutex_lock(&render_mutex);
+    __atomic_store_n(&render_sleeping[thread], 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    while (!ready())
+    {
+      pthread_cond_wait(&render_wake, &render_mutex);
+    }
+    __atomic_store_n(&render_sleeping[thread], 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&render_mutex);
+  }
+}
+
+/* set index or flag read by the other thread, wake it up if it is sleeping */
+static void render_signal(unsigned int *index, unsigned int value, int thread)
+{
+  __atomic_store_n(index, value, __ATOMIC_RELEASE);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+  if (__atomic_load_n(&render_sleeping[thread], __ATOMIC_RELAXED))
+  {
+    pthread_mutex_lock(&render_mutex);
+    pthread_cond_broadcast(&render_wake);
+    pthread_mutex_unlock(&render_mutex);
+  }
+}
+
+static void *render_thread_main(void *arg)
+{
+  while (1)
+  {
+    /* wait for next queued entries */
+    render_wait_for(render_pending, 1);
+
+    /* exit once all queued entries have been rendered */
+    if (__atomic_load_n(&render_head, __ATOMIC_ACQUIRE) == render_tail)
+    {
+      break;
+    }
+
+    render_cmd_exec(&render_queue[render_tail % RENDER_QUEUE_SIZE]);
+    render_signal(&render_tail, render_tail + 1, 0);
+  }
+
+  return NULL;
+}
+
+static void render_queue_push(int type, int line, int offset, int width)
+{
+  render_cmd_t *cmd;
+
+  /* render synchronously if worker thread is not running */
+  if (!render_running)
+  {
+    render_cmd_t temp;
+    temp.type = type;
+    temp.line = line;
+    temp.offset = offset;
+    temp.width = width;
+    render_cmd_exec(&temp);
+    return;
+  }
+
+  /* wait for a free entry */
+  render_wait_for(render_free, 0);
+
+  cmd = &render_queue[render_count % RENDER_QUEUE_SIZE];
+  cmd->type = type;
+  cmd->line = line;
+  cmd->offset = offset;
+  cmd->width = width;
+  render_count++;
+
+  /* hand queued entries over to worker thread */
+  if ((render_count - render_head) >= RENDER_BATCH)
+  {
+    render_signal(&render_head, render_count, 1);
+  }
+}
+
+void render_sync(void)
+{
+  if (render_count != render_head)
+  {
+    render_signal(&render_head, render_count, 1);
+  }
+
+  render_wait_for(render_done, 0);
+}
+
+void render_line_async(int line)
+{
+  render_queue_push(RENDER_CMD_LINE, line, 0, 0);
+}
+
+void blank_line_async(int line, int offset, int width)
+{
+  render_queue_push(RENDER_CMD_BLANK, line, offset, width);
+}
+
+void parse_satb_async(int line)
+{
+  render_queue_push(RENDER_CMD_SATB, line, 0, 0);
+}
+
+void parse_line_async(int line)
+{
+  render_queue_push(RENDER_CMD_PARSE, line, 0, 0);
+}
+
+static void render_thread_start(void)
+{
+  /* worker thread is only used on multi-core hosts, lines are rendered synchronously otherwise */
+  if (!render_running && (sysconf(_SC_NPROCESSORS_ONLN) > 1))
+  {
+    render_count = render_head = render_tail = render_quit = 0;
+    render_running = !pthread_create(&render_thread, NULL, render_thread_main, NULL);
+  }
+}
+
+void render_shutdown(void)
+{
+  if (render_running)
+  {
+    /* worker thread exits once all queued entries have been rendered */
+    render_sync();
+    render_signal(&render_quit, 1, 1);
+    pthread_join(render_thread, NULL);
+    render_running = 0;
+  }
+}
+
+#endif /* USE_THREADED_RENDERER */
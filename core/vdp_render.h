@@ -100,12 +100,15 @@
 }
 
 /* Global variables */
-extern uint16 spr_col;
+extern THREAD_LOCAL uint16 spr_col;
+extern THREAD_LOCAL uint16 spr_status;
 
 /* Function prototypes */
 extern void render_init(void);
 extern void render_reset(void);
+extern void render_restore(void);
 extern void render_line(int line);
+extern void parse_line(int line);
 extern void blank_line(int line, int offset, int width);
 extern void remap_line(int line);
 extern void window_clip(unsigned int data, unsigned int sw);
@@ -131,15 +134,50 @@ extern void render_obj_m5_im2_ste(int line);
 extern void parse_satb_tms(int line);
 extern void parse_satb_m4(int line);
 extern void parse_satb_m5(int line);
+extern void parse_obj_tms(int line);
+extern void parse_obj_m4(int line);
+extern void parse_obj_m5(int line);
 extern void update_bg_pattern_cache_m4(int index);
 extern void update_bg_pattern_cache_m5(int index);
 extern void color_update_m4(int index, unsigned int data);
 extern void color_update_m5(int index, unsigned int data);
 
+/* Asynchronous line rendering (Mega Drive & Mega CD frames) */
+#ifdef USE_THREADED_RENDERER
+#ifdef USE_THREAD_LOCAL_CONTEXT
+#error "USE_THREADED_RENDERER cannot be combined with USE_THREAD_LOCAL_CONTEXT"
+#endif
+extern void render_shutdown(void);
+extern void render_sync(void);
+extern void render_line_async(int line);
+extern void blank_line_async(int line, int offset, int width);
+extern void parse_satb_async(int line);
+extern void parse_line_async(int line);
+#else
+#define render_shutdown()
+#define render_sync()
+#define render_line_async(line) render_line(line)
+#define blank_line_async(line, offset, width) blank_line(line, offset, width)
+#define parse_satb_async(line) parse_satb(line)
+#define parse_line_async(line) parse_line(line)
+#endif
+
+#ifdef USE_PATTERN_STATS
+/* Pattern cache statistics (Mode 5 pattern lines drawn & decoded since last reset) */
+typedef struct
+{
+  uint32 drawn;
+  uint32 decoded;
+} t_pattern_stats;
+
+extern THREAD_LOCAL t_pattern_stats pattern_stats;
+#endif
+
 /* Function pointers */
-extern void (*render_bg)(int line);
-extern void (*render_obj)(int line);
-extern void (*parse_satb)(int line);
-extern void (*update_bg_pattern_cache)(int index);
+extern THREAD_LOCAL void (*render_bg)(int line);
+extern THREAD_LOCAL void (*render_obj)(int line);
+extern THREAD_LOCAL void (*parse_satb)(int line);
+extern THREAD_LOCAL void (*parse_obj)(int line);
+extern THREAD_LOCAL void (*update_bg_pattern_cache)(int index);
 
 #endif /* _RENDER_H_ */
@@ -204,23 +204,41 @@
 
 #ifdef Z80_OVERCLOCK_SHIFT
 #define USE_CYCLES(A) Z80.cycles += ((A) * z80_cycle_ratio) >> Z80_OVERCLOCK_SHIFT
-UINT32 z80_cycle_ratio;
+THREAD_LOCAL UINT32 z80_cycle_ratio;
 #else
 #define USE_CYCLES(A) Z80.cycles += (A)
 #endif
 
-Z80_Regs Z80;
-UINT8 z80_last_fetch;
+THREAD_LOCAL Z80_Regs Z80;
+THREAD_LOCAL UINT8 z80_last_fetch;
 
-unsigned char *z80_readmap[64];
-unsigned char *z80_writemap[64];
+THREAD_LOCAL unsigned char *z80_readmap[64];
+THREAD_LOCAL unsigned char *z80_writemap[64];
 
-void (*z80_writemem)(unsigned int address, unsigned char data);
-unsigned char (*z80_readmem)(unsigned int address);
-void (*z80_writeport)(unsigned int port, unsigned char data);
-unsigned char (*z80_readport)(unsigned int port);
+THREAD_LOCAL void (*z80_writemem)(unsigned int address, unsigned char data);
+THREAD_LOCAL unsigned char (*z80_readmem)(unsigned int address);
+THREAD_LOCAL void (*z80_writeport)(unsigned int port, unsigned char data);
+THREAD_LOCAL unsigned char (*z80_readport)(unsigned int port);
 
-static UINT32 EA;
+#ifdef USE_IDLE_LOOP_SKIP
+/* maximal size of skipped idle loops */
+#define Z80_LOOP_SIZE 16
+
+/* idle loop skipping */
+typedef struct
+{
+  Z80_Regs regs;  /* registers at loop start */
+  UINT32 saved;   /* registers saved at loop start */
+  UINT32 count;   /* access count at loop start */
+  UINT32 access;  /* memory & I/O access count */
+  UINT32 prev;    /* previous instruction address */
+} z80_loop_t;
+
+static THREAD_LOCAL z80_loop_t z80_loop;
+THREAD_LOCAL UINT32 z80_loop_skipped;
+#endif
+
+static THREAD_LOCAL UINT32 EA;
 
 static UINT8 SZ[256];       /* zero and sign flags */
 static UINT8 SZ_BIT[256];   /* zero, sign and parity/overflow (=zero) flags for BIT opcode */
@@ -475,7 +493,7 @@ PROTOTYPES(Z80ed,ed)
 PROTOTYPES(Z80fd,fd)
 PROTOTYPES(Z80xycb,xycb)
 
-#ifndef BIG_SWITCH
+#if !defined(BIG_SWITCH) || defined(USE_Z80_DECODE_CACHE)
 FUNCTABLE(Z80op,op);
 #endif
 FUNCTABLE(Z80cb,cb);
@@ -617,22 +635,43 @@ INLINE void BURNODD(int cycles, int opcodes, int cyclesum)
 /***************************************************************
  * Input a byte from given I/O port
  ***************************************************************/
+#ifdef USE_IDLE_LOOP_SKIP
+#define IN(port) (z80_loop.access++, z80_readport(port))
+#else
 #define IN(port) z80_readport(port)
+#endif
 
 /***************************************************************
  * Output a byte to given I/O port
  ***************************************************************/
+#ifdef USE_IDLE_LOOP_SKIP
+#define OUT(port,value) (z80_loop.access++, z80_writeport(port,value))
+#else
 #define OUT(port,value) z80_writeport(port,value)
+#endif
 
 /***************************************************************
  * Read a byte from given memory location
  ***************************************************************/
+#ifdef USE_IDLE_LOOP_SKIP
+INLINE UINT8 RM(UINT32 addr)
+{
+  /* reading memory mapped for both reads & writes (RAM) has no side effect */
+  if (z80_readmap[(addr >> 10) & 0x3f] != z80_writemap[(addr >> 10) & 0x3f]) z80_loop.access++;
+  return z80_readmem(addr);
+}
+#else
 #define RM(addr) z80_readmem(addr)
+#endif
 
 /***************************************************************
  * Write a byte to given memory location
  ***************************************************************/
+#ifdef USE_IDLE_LOOP_SKIP
+#define WM(addr,value) (z80_loop.access++, z80_writemem(addr,value))
+#else
 #define WM(addr,value) z80_writemem(addr,value)
+#endif
 
 /***************************************************************
  * Read a word from given memory location
@@ -3394,6 +3433,9 @@ void z80_init(const void *config, int (*irqcallback)(int))
   cc[Z80_TABLE_xy] = cc_xy;
   cc[Z80_TABLE_xycb] = cc_xycb;
   cc[Z80_TABLE_ex] = cc_ex;
+
+  /* no cacheable area by default */
+  z80_decode_cache_init(NULL, 0);
 }
 
 /****************************************************************************
@@ -3414,11 +3456,194 @@ void z80_reset(void)
   WZ=PCD;
 }
 
+#ifdef USE_Z80_DECODE_CACHE
+/****************************************************************************
+ * Decode cache: opcode handler & execution time of instructions fetched
+ * from ROM pages, directly mapped by ROM offset so that remapped pages
+ * never need to be invalidated. RAM pages are never cached.
+ ****************************************************************************/
+#define Z80_DECODE_COUNT 0x10000
+
+typedef struct
+{
+  void (*handler)(void);  /* opcode handler, with CB/DD/ED/FD prefix resolved */
+  UINT32 offset;          /* ROM offset of decoded instruction */
+  UINT16 cycles;          /* opcode execution time */
+  UINT8 length;           /* opcode length, including prefix */
+  UINT8 fetch;            /* last fetched opcode */
+} z80_decoded_op;
+
+static THREAD_LOCAL z80_decoded_op z80_decode_cache[Z80_DECODE_COUNT];
+static THREAD_LOCAL unsigned char *z80_decode_rom;
+static THREAD_LOCAL unsigned int z80_decode_rom_size;
+static THREAD_LOCAL int z80_decode_disabled;
+
+void z80_decode_cache_init(unsigned char *base, unsigned int size)
+{
+  /* cacheable ROM area */
+  z80_decode_rom = base;
+  z80_decode_rom_size = size;
+  z80_decode_cache_flush();
+}
+
+void z80_decode_cache_flush(void)
+{
+  int i;
+  for (i=0; i<Z80_DECODE_COUNT; i++)
+  {
+    z80_decode_cache[i].offset = 0xffffffff;
+  }
+}
+
+void z80_decode_cache_invalidate(unsigned char *ptr)
+{
+  /* instructions (up to 4 bytes) including modified ROM byte */
+  if ((ptr >= z80_decode_rom) && (ptr < (z80_decode_rom + z80_decode_rom_size)))
+  {
+    UINT32 offset = ptr - z80_decode_rom;
+    int i;
+    for (i=0; i<4; i++)
+    {
+      z80_decode_cache[(offset - i) & (Z80_DECODE_COUNT - 1)].offset = 0xffffffff;
+    }
+  }
+}
+
+void z80_decode_cache_enable(int enable)
+{
+  /* no instruction is decoded while disabled */
+  z80_decode_disabled = !enable;
+  z80_decode_cache_flush();
+}
+
+/* Decode instruction at current PC, returns zero if it can not be cached */
+static int z80_decode(z80_decoded_op *op, UINT8 *ptr, UINT32 offset)
+{
+  UINT8 opcode = ptr[0];
+
+  if (z80_decode_disabled)
+  {
+    return 0;
+  }
+
+  /* previously decoded instruction is replaced */
+  op->offset = 0xffffffff;
+
+  switch (opcode)
+  {
+    case 0xcb:
+    case 0xdd:
+    case 0xed:
+    case 0xfd:
+    {
+      /* prefix and opcode must be fetched from the same page */
+      if ((PC & 0x3ff) == 0x3ff)
+      {
+        return 0;
+      }
+
+      op->fetch = ptr[1];
+      op->length = 2;
+
+      if (opcode == 0xcb)
+      {
+        op->handler = Z80cb[op->fetch];
+        op->cycles = cc[Z80_TABLE_cb][op->fetch];
+      }
+      else if (opcode == 0xed)
+      {
+        op->handler = Z80ed[op->fetch];
+        op->cycles = cc[Z80_TABLE_ed][op->fetch];
+      }
+      else
+      {
+        /* DD CB / FD CB opcodes and chained prefixes are not cached */
+        switch (op->fetch)
+        {
+          case 0xcb:
+          case 0xdd:
+          case 0xed:
+          case 0xfd:
+            return 0;
+        }
+
+        op->handler = (opcode == 0xdd) ? Z80dd[op->fetch] : Z80fd[op->fetch];
+        op->cycles = cc[Z80_TABLE_xy][op->fetch];
+      }
+      break;
+    }
+
+    default:
+    {
+      op->fetch = opcode;
+      op->length = 1;
+      op->handler = Z80op[opcode];
+      op->cycles = cc[Z80_TABLE_op][opcode];
+      break;
+    }
+  }
+
+  op->offset = offset;
+  return 1;
+}
+#endif
+
+#ifdef USE_IDLE_LOOP_SKIP
+/****************************************************************************
+ * Called at loop start, when a short backward jump has been taken
+ ****************************************************************************/
+static void z80_idle_loop(UINT32 cycles)
+{
+  Z80_Regs *regs = &z80_loop.regs;
+
+  /* last iteration did not write memory or access I/O */
+  if ((z80_loop.count != z80_loop.access) || (regs->pc.d != PCD))
+  {
+    /* registers are only saved once an iteration without memory write or I/O access has been executed */
+    regs->pc.d = PCD;
+    z80_loop.saved = 0;
+    z80_loop.count = z80_loop.access;
+    return;
+  }
+
+  /* last iteration also did not modify registers & flags */
+  if (z80_loop.saved && (regs->sp.d == SPD) &&
+      (regs->af.d == AFD) && (regs->bc.d == BCD) && (regs->de.d == DED) && (regs->hl.d == HLD) &&
+      (regs->ix.d == IXD) && (regs->iy.d == IYD) && (regs->wz.d == Z80.wz.d) &&
+      (regs->af2.d == Z80.af2.d) && (regs->bc2.d == Z80.bc2.d) && (regs->de2.d == Z80.de2.d) && (regs->hl2.d == Z80.hl2.d) &&
+      (regs->iff1 == IFF1) && (regs->iff2 == IFF2) && (regs->halt == HALT) && (regs->im == IM) && (regs->i == I))
+  {
+    /* next iterations are identical: skip them as long as whole iteration ends before given cycle count */
+    UINT32 period = Z80.cycles - regs->cycles;
+    UINT32 count = (cycles - Z80.cycles - 1) / period;
+    Z80.cycles += count * period;
+    R += count * (UINT8)(R - regs->r);
+    z80_loop_skipped += count * period;
+
+    /* start new iteration */
+    regs->cycles = Z80.cycles;
+    regs->r = R;
+  }
+  else
+  {
+    /* start new iteration with saved registers */
+    z80_loop.regs = Z80;
+    z80_loop.saved = 1;
+  }
+}
+#endif
+
 /****************************************************************************
  * Run until given cycle count 
  ****************************************************************************/
 void z80_run(unsigned int cycles)
 {
+#ifdef USE_IDLE_LOOP_SKIP
+  /* idle loops are detected again in each execution frame */
+  z80_loop.regs.pc.d = z80_loop.prev = 0xffffffff;
+  z80_loop.saved = 0;
+#endif
+
   while( Z80.cycles < cycles )
   {
     /* check for IRQs before each instruction */
@@ -3428,8 +3653,39 @@ void z80_run(unsigned int cycles)
       if (Z80.cycles >= cycles) return;
     }
 
+#ifdef USE_IDLE_LOOP_SKIP
+    /* check for loop start when a short backward jump has been taken */
+    if ((PCD <= z80_loop.prev) && ((z80_loop.prev - PCD) < Z80_LOOP_SIZE))
+    {
+      z80_idle_loop(cycles);
+    }
+    z80_loop.prev = PCD;
+#endif
+
     Z80.after_ei = FALSE;
     R++;
+
+#ifdef USE_Z80_DECODE_CACHE
+    {
+      /* execute decoded instruction if fetched from ROM */
+      UINT8 *ptr = &z80_readmap[PC >> 10][PC & 0x3ff];
+      if ((ptr >= z80_decode_rom) && (ptr < (z80_decode_rom + z80_decode_rom_size)))
+      {
+        UINT32 offset = ptr - z80_decode_rom;
+        z80_decoded_op *op = &z80_decode_cache[offset & (Z80_DECODE_COUNT - 1)];
+        if ((op->offset == offset) || z80_decode(op, ptr, offset))
+        {
+          PC += op->length;
+          R += op->length - 1;
+          z80_last_fetch = op->fetch;
+          USE_CYCLES(op->cycles);
+          (*op->handler)();
+          continue;
+        }
+      }
+    }
+#endif
+
     EXEC_INLINE(op,ROP());
   }
 } 
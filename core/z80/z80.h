@@ -49,20 +49,20 @@ typedef struct
 }  Z80_Regs;
 
 
-extern Z80_Regs Z80;
-extern UINT8 z80_last_fetch;
+extern THREAD_LOCAL Z80_Regs Z80;
+extern THREAD_LOCAL UINT8 z80_last_fetch;
 
 #ifdef Z80_OVERCLOCK_SHIFT
-extern UINT32 z80_cycle_ratio;
+extern THREAD_LOCAL UINT32 z80_cycle_ratio;
 #endif
 
-extern unsigned char *z80_readmap[64];
-extern unsigned char *z80_writemap[64];
+extern THREAD_LOCAL unsigned char *z80_readmap[64];
+extern THREAD_LOCAL unsigned char *z80_writemap[64];
 
-extern void (*z80_writemem)(unsigned int address, unsigned char data);
-extern unsigned char (*z80_readmem)(unsigned int address);
-extern void (*z80_writeport)(unsigned int port, unsigned char data);
-extern unsigned char (*z80_readport)(unsigned int port);
+extern THREAD_LOCAL void (*z80_writemem)(unsigned int address, unsigned char data);
+extern THREAD_LOCAL unsigned char (*z80_readmem)(unsigned int address);
+extern THREAD_LOCAL void (*z80_writeport)(unsigned int port, unsigned char data);
+extern THREAD_LOCAL unsigned char (*z80_readport)(unsigned int port);
 
 extern void z80_init(const void *config, int (*irqcallback)(int));
 extern void z80_reset (void);
@@ -72,5 +72,23 @@ extern void z80_set_context (void *src);
 extern void z80_set_irq_line(unsigned int state);
 extern void z80_set_nmi_line(unsigned int state);
 
+/* Cache decoded instructions fetched from given ROM area, flush cache when ROM is modified */
+#ifdef USE_Z80_DECODE_CACHE
+extern void z80_decode_cache_init(unsigned char *base, unsigned int size);
+extern void z80_decode_cache_flush(void);
+extern void z80_decode_cache_invalidate(unsigned char *ptr);
+extern void z80_decode_cache_enable(int enable);
+#else
+#define z80_decode_cache_init(base,size)
+#define z80_decode_cache_flush()
+#define z80_decode_cache_invalidate(ptr)
+#define z80_decode_cache_enable(enable)
+#endif
+
+/* Skip identical iterations of idle loops (no memory write or I/O access, RAM reads only) */
+#ifdef USE_IDLE_LOOP_SKIP
+extern THREAD_LOCAL UINT32 z80_loop_skipped;
+#endif
+
 #endif
 
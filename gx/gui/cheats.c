@@ -504,6 +504,7 @@ static void apply_cheats(void)
           {
             /* patch data */
             *ptr = cheatlist[i].data;
+            z80_decode_cache_invalidate(ptr);
 
             /* save patched ROM address */
             cheatlist[i].prev = ptr;
@@ -547,6 +548,7 @@ static void clear_cheats(void)
           {
             /* restore original data */
             *cheatlist[i-1].prev = cheatlist[i-1].old;
+            z80_decode_cache_invalidate(cheatlist[i-1].prev);
 
             /* no more patched ROM address */
             cheatlist[i-1].prev = NULL;
@@ -1592,6 +1594,7 @@ void ROMCheatUpdate(void)
     {
       /* restore original data */
       *cheatlist[index].prev = cheatlist[index].old;
+      z80_decode_cache_invalidate(cheatlist[index].prev);
 
       /* no more patched ROM address */
       cheatlist[index].prev = NULL;
@@ -1605,6 +1608,7 @@ void ROMCheatUpdate(void)
     {
       /* patch data */
       *ptr = cheatlist[index].data;
+      z80_decode_cache_invalidate(ptr);
 
       /* save patched ROM address */
       cheatlist[index].prev = ptr;
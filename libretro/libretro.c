@@ -2391,6 +2391,7 @@ static void apply_cheats(void)
                {
                   /* patch data */
                   *ptr = cheatlist[i].data;
+                  z80_decode_cache_invalidate(ptr);
                   /* save patched ROM address */
                   cheatlist[i].prev = ptr;
                }
@@ -2433,6 +2434,7 @@ static void clear_cheats(void)
                {
                   /* restore original data */
                   *cheatlist[i-1].prev = cheatlist[i-1].old;
+                  z80_decode_cache_invalidate(cheatlist[i-1].prev);
                   /* no more patched ROM address */
                   cheatlist[i-1].prev = NULL;
                }
@@ -2515,6 +2517,7 @@ void ROMCheatUpdate(void)
     {
       /* restore original data */
       *cheatlist[index].prev = cheatlist[index].old;
+      z80_decode_cache_invalidate(cheatlist[index].prev);
 
       /* no more patched ROM address */
       cheatlist[index].prev = NULL;
@@ -2528,6 +2531,7 @@ void ROMCheatUpdate(void)
     {
       /* patch data */
       *ptr = cheatlist[index].data;
+      z80_decode_cache_invalidate(ptr);
 
       /* save patched ROM address */
       cheatlist[index].prev = ptr;
@@ -3605,8 +3609,15 @@ void retro_run(void)
    bool updated = false;
    int vwoffset = 0;
    int bmdoffset = 0;
+   int av_enable = 0;
    is_running = true;
 
+   /* sound emulation is disabled when frontend will never need audio output (secondary core used for run-ahead) */
+   if (environ_cb(RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE, &av_enable))
+   {
+      snd.enabled = (av_enable & 8) ? 0 : 1;
+   }
+
 #ifdef HAVE_OVERCLOCK
   /* update overclock delay */
   if (overclock_delay && --overclock_delay == 0)
@@ -49,6 +49,10 @@ void set_config_defaults(void)
   config.enhanced_vscroll = 0;
   config.enhanced_vscroll_limit = 8;
 
+  /* rewind options */
+  config.rewind      = 0;  /* history length in frames (0 = disabled, 10800 = 3 minutes at 60hz) */
+  config.rewind_size = 32; /* buffer size in MB */
+
   /* controllers options */
   input.system[0]       = SYSTEM_GAMEPAD;
   input.system[1]       = SYSTEM_GAMEPAD;
@@ -53,6 +53,8 @@ typedef struct
   uint8 render;
   uint8 enhanced_vscroll;
   uint8 enhanced_vscroll_limit;
+  uint16 rewind;
+  uint8 rewind_size;
   t_input_config input[MAX_INPUTS];
 } t_config;
 
@@ -0,0 +1,145 @@
+#include <stdint.h>
+
+#include "shared.h"
+#include "main.h"
+#include "cddbench.h"
+
+/* CD-DA samples read per emulated frame */
+#define CDDBENCH_SAMPLES 735
+
+static uint32 hash_data(uint32 hash, const uint8 *data, int length)
+{
+  int i;
+
+  for (i = 0; i < length; i++)
+  {
+    hash = (hash * 31) + data[i];
+  }
+
+  return hash;
+}
+
+static uint32 hash_audio(uint32 hash)
+{
+  int i, count;
+  short buffer[CDDBENCH_SAMPLES * 2 * 2];
+
+  count = blip_read_samples(snd.blips[2], buffer, blip_samples_avail(snd.blips[2]));
+  for (i = 0; i < count * 2; i++)
+  {
+    hash = (hash * 31) + buffer[i];
+  }
+
+  return hash;
+}
+
+int cddbench_run(char *filename)
+{
+  int i, lba, result;
+  int sectors = 0;
+  int samples = 0;
+  uint32 hash = 0;
+  uint8 subheader[4];
+  uint8 state[64];
+  char header[0x210];
+  double start, elapsed[2];
+
+#ifdef USE_DYNAMIC_ALLOC
+  ext = calloc(1, sizeof(external_t));
+  if (!ext)
+  {
+    fprintf(stderr, "Error allocating CD hardware.\n");
+    return 1;
+  }
+#endif
+
+  /* CD-DA output is not resampled */
+  snd.blips[2] = blip_new(CDDBENCH_SAMPLES * 2);
+  if (!snd.blips[2])
+  {
+    fprintf(stderr, "Error allocating audio buffer.\n");
+    return 1;
+  }
+  cdd_init(44100);
+  config.cdda_volume = 100;
+
+  if (cdd_load(filename, header) <= 0)
+  {
+    fprintf(stderr, "Error loading CD image `%s'.\n", filename);
+    blip_delete(snd.blips[2]);
+    return 1;
+  }
+
+  cdd_reset();
+
+  /* CD-ROM data track: all sectors read sequentially (Mode 2 sectors with sub-header) */
+  start = headless_time();
+  if (cdd.toc.tracks[0].type)
+  {
+    for (lba = cdd.toc.tracks[0].start; lba < cdd.toc.tracks[0].end; lba++)
+    {
+      cdd.lba = lba;
+      cdd_read_data(cdc.ram, (cdd.toc.tracks[0].type == 1) ? NULL : subheader);
+      hash = hash_data(hash, cdc.ram, (cdd.toc.tracks[0].type == 1) ? 2048 : 2328);
+      sectors++;
+    }
+  }
+  elapsed[0] = headless_time() - start;
+
+  /* CD-DA tracks: played from start to end at full volume, with state saved & restored halfway */
+  start = headless_time();
+  scd.regs[0x36>>1].byte.h = 0x00;
+  for (i = 0; i < cdd.toc.last; i++)
+  {
+    if (!cdd.toc.tracks[i].type)
+    {
+      int length = (cdd.toc.tracks[i].end - cdd.toc.tracks[i].start) * 588;
+      int done = 0;
+
+      cdd_seek_audio(i, cdd.toc.tracks[i].start);
+      cdd.index = i;
+      cdd.lba = cdd.toc.tracks[i].start;
+
+      while (done < length)
+      {
+        if ((done < (length / 2)) && ((done + CDDBENCH_SAMPLES) >= (length / 2)))
+        {
+          cdd_context_save(state);
+          cdd_context_load(state, STATE_VERSION);
+        }
+
+        cdd_read_audio(CDDBENCH_SAMPLES);
+        hash = hash_audio(hash);
+        done += CDDBENCH_SAMPLES;
+      }
+
+      samples += done;
+    }
+  }
+  elapsed[1] = headless_time() - start;
+
+  printf("CD image: %d data sectors, %d audio samples\n", sectors, samples);
+  if (sectors)
+  {
+    printf("  data  : %8.2f ms, %7.2f MB/s\n", elapsed[0] * 1000.0, sectors * 2048.0 / elapsed[0] / 1000000.0);
+  }
+  if (samples)
+  {
+    printf("  audio : %8.2f ms, %7.2fx realtime\n", elapsed[1] * 1000.0, samples / 44100.0 / elapsed[1]);
+  }
+#ifdef USE_CDD_PREFETCH
+  printf("  read-ahead: %u blocks read ahead, %u hits, %u misses, %.3f ms stalled\n",
+         cdd_cache_stats.prefetched, cdd_cache_stats.hits, cdd_cache_stats.misses, cdd_cache_stats.stall * 1000.0);
+#endif
+  printf("  output checksum: %08x\n", hash);
+  result = (sectors + samples) ? 0 : 1;
+
+  cdd_cache_shutdown();
+  cdd_unload();
+  blip_delete(snd.blips[2]);
+#ifdef USE_DYNAMIC_ALLOC
+  free(ext);
+#endif
+
+  return result;
+}
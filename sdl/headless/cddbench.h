@@ -0,0 +1,8 @@
+#ifndef _CDDBENCH_H_
+#define _CDDBENCH_H_
+
+/* CD image read benchmark: reads all data track sectors then plays all audio tracks */
+/* like CD drive emulation does, then reports timing & output checksum.              */
+extern int cddbench_run(char *filename);
+
+#endif /* _CDDBENCH_H_ */
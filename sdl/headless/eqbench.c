@@ -0,0 +1,180 @@
+#include <stdint.h>
+#include <math.h>
+
+#include "shared.h"
+#include "main.h"
+#include "eq.h"
+#include "eqbench.h"
+
+/* number of times each path is run (best time is kept) */
+#define EQBENCH_LOOPS 5
+
+/* number of stereo samples per test signal (2 seconds at 48 kHz) */
+#define EQBENCH_SAMPLES 96000
+
+/* number of stereo samples per call (one frame at 48 kHz) */
+#define EQBENCH_FRAME 800
+
+/* maximal difference between fixed point & double precision output (LSB) */
+#define EQBENCH_MAX_ERROR 2
+
+static const struct
+{
+  const char *name;
+  int low_freq;
+  int high_freq;
+} setups[] =
+{
+  {"SDL", 200, 8000},
+  {"libretro/GX", 880, 5000}
+};
+
+static const int rates[] = {44100, 48000};
+
+/* low / mid / high gains (%) */
+static const int gains[][3] =
+{
+  {100, 100, 100},
+  {200, 100, 50},
+  {0, 50, 200}
+};
+
+static uint32 rand_state;
+
+static int eqbench_rand(int range)
+{
+  rand_state = rand_state * 1103515245 + 12345;
+  return ((rand_state >> 16) & 0x7fff) % range;
+}
+
+/* full scale white noise, square waves and sine sweep */
+static void init_signal(short *buffer, int rate)
+{
+  int i, period = 0, level = 32767;
+  double phase = 0.0;
+
+  rand_state = 1;
+
+  for (i = 0; i < EQBENCH_SAMPLES; i++)
+  {
+    switch ((i * 3) / EQBENCH_SAMPLES)
+    {
+      case 0:
+        buffer[i * 2] = eqbench_rand(0x10000) - 0x8000;
+        buffer[i * 2 + 1] = eqbench_rand(0x10000) - 0x8000;
+        break;
+
+      case 1:
+        if (--period <= 0)
+        {
+          period = eqbench_rand(rate / 50) + 2;
+          level = -level;
+        }
+        buffer[i * 2] = level;
+        buffer[i * 2 + 1] = -level;
+        break;
+
+      default:
+        phase += M_PI * ((double) (i % (EQBENCH_SAMPLES / 3)) / (double) (EQBENCH_SAMPLES / 3));
+        buffer[i * 2] = (short) (32767.0 * sin(phase));
+        buffer[i * 2 + 1] = (short) (16384.0 * sin(phase * 0.5));
+        break;
+    }
+  }
+}
+
+static double run_eq(EQSTATE *es, short *buffer)
+{
+  int i;
+  double start = headless_time();
+
+  for (i = 0; i < EQBENCH_SAMPLES; i += EQBENCH_FRAME)
+  {
+    do_3band(es, &buffer[i * 2], EQBENCH_FRAME, 0);
+  }
+
+  return headless_time() - start;
+}
+
+int eqbench_run(void)
+{
+  int i, j, k, loop, result = 0;
+  static short signal[EQBENCH_SAMPLES * 2];
+  static short output[2][EQBENCH_SAMPLES * 2];
+  EQSTATE es[2];
+
+  printf("3-band EQ: %d samples, fixed point vs double precision\n", EQBENCH_SAMPLES);
+
+  for (i = 0; i < sizeof(setups) / sizeof(setups[0]); i++)
+  {
+    for (j = 0; j < sizeof(rates) / sizeof(rates[0]); j++)
+    {
+      init_signal(signal, rates[j]);
+
+      for (k = 0; k < sizeof(gains) / sizeof(gains[0]); k++)
+      {
+        int n, diff, max_diff = 0;
+        double sum_diff = 0.0;
+        double elapsed[2] = {0.0, 0.0};
+
+        for (loop = 0; loop < EQBENCH_LOOPS; loop++)
+        {
+          for (n = 0; n < 2; n++)
+          {
+            double t;
+
+            init_3band_state(&es[n], setups[i].low_freq, setups[i].high_freq, rates[j]);
+            es[n].lg = (gains[k][0] << 16) / 100;
+            es[n].mg = (gains[k][1] << 16) / 100;
+            es[n].hg = (gains[k][2] << 16) / 100;
+
+            /* second state is forced to double precision */
+            if (n)
+            {
+              es[n].fixed = 0;
+            }
+            else if (!es[n].fixed)
+            {
+              printf("  %s %d/%d Hz at %d Hz: fixed point is not used\n", setups[i].name, setups[i].low_freq, setups[i].high_freq, rates[j]);
+              return 1;
+            }
+
+            memcpy(output[n], signal, sizeof(signal));
+            t = run_eq(&es[n], output[n]);
+            if (!loop || (t < elapsed[n]))
+            {
+              elapsed[n] = t;
+            }
+          }
+        }
+
+        for (n = 0; n < EQBENCH_SAMPLES * 2; n++)
+        {
+          diff = abs(output[0][n] - output[1][n]);
+          sum_diff += diff;
+          if (diff > max_diff)
+          {
+            max_diff = diff;
+          }
+        }
+
+        printf("  %-11s %3d/%4d Hz at %d Hz, gains %3d/%3d/%3d%%: fixed %6.2f ms, double %6.2f ms (%.2fx), error max %d mean %.3f LSB%s\n",
+               setups[i].name, setups[i].low_freq, setups[i].high_freq, rates[j], gains[k][0], gains[k][1], gains[k][2],
+               elapsed[0] * 1000.0, elapsed[1] * 1000.0, elapsed[1] / elapsed[0], max_diff, sum_diff / (EQBENCH_SAMPLES * 2),
+               (max_diff > EQBENCH_MAX_ERROR) ? " (too large)" : "");
+
+        if (max_diff > EQBENCH_MAX_ERROR)
+        {
+          result = 1;
+        }
+      }
+    }
+  }
+
+  if (!result)
+  {
+    printf("  fixed point output is within %d LSB of double precision output\n", EQBENCH_MAX_ERROR);
+  }
+
+  return result;
+}
@@ -0,0 +1,9 @@
+#ifndef _EQBENCH_H_
+#define _EQBENCH_H_
+
+/* 3-band EQ check: processes test signals with fixed point and double precision filters */
+/* for SDL (200/8000 Hz) and libretro/GX (880/5000 Hz) settings at 44.1 & 48 kHz, then     */
+/* compares output & timing.                                                              */
+extern int eqbench_run(void);
+
+#endif /* _EQBENCH_H_ */
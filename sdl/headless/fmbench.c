@@ -0,0 +1,668 @@
+#include <stdint.h>
+#include <zlib.h>
+
+#include "shared.h"
+#include "main.h"
+#include "fmbench.h"
+
+#define FMBENCH_LOOPS 5
+
+/* register log events: chip port write or number of samples to render */
+#define EVENT_WRITE 0x80000000
+
+static uint32 *events;
+static int event_count;
+static int event_max;
+static int sample_count;
+
+/* built-in log pseudo-random generator */
+static uint32 rand_state;
+
+static void log_event(uint32 event)
+{
+  if (event_count == event_max)
+  {
+    uint32 *temp = realloc(events, (event_max + 0x10000) * sizeof(uint32));
+    if (!temp)
+    {
+      fprintf(stderr, "Error allocating register log.\n");
+      exit(1);
+    }
+    events = temp;
+    event_max += 0x10000;
+  }
+
+  events[event_count++] = event;
+}
+
+static void log_write(int port, int reg, int value)
+{
+  log_event(EVENT_WRITE | ((port * 2) << 8) | (reg & 0xff));
+  log_event(EVENT_WRITE | ((port * 2 + 1) << 8) | (value & 0xff));
+}
+
+static void log_wait(int samples)
+{
+  if (samples > 0)
+  {
+    log_event(samples);
+    sample_count += samples;
+  }
+}
+
+static int fmbench_rand(int range)
+{
+  rand_state = rand_state * 1103515245 + 12345;
+  return ((rand_state >> 16) & 0x7fff) % range;
+}
+
+static void build_channel(int ch)
+{
+  int op;
+  int port = ch / 3;
+  int c = ch % 3;
+
+  /* feedback & algorithm, panning, AMS & PMS */
+  log_write(port, 0xb0 + c, fmbench_rand(0x40));
+  log_write(port, 0xb4 + c, ((fmbench_rand(3) + 1) << 6) | (fmbench_rand(0x40) & 0x37));
+
+  for (op = 0; op < 4; op++)
+  {
+    int r = (op * 4) + c;
+    log_write(port, 0x30 + r, fmbench_rand(0x80));
+    log_write(port, 0x40 + r, fmbench_rand(0x40));
+    log_write(port, 0x50 + r, fmbench_rand(0x100) | 0x10);
+    log_write(port, 0x60 + r, fmbench_rand(0x100));
+    log_write(port, 0x70 + r, fmbench_rand(0x20));
+    log_write(port, 0x80 + r, fmbench_rand(0x100));
+    log_write(port, 0x90 + r, fmbench_rand(4) ? 0x00 : (0x08 | fmbench_rand(8)));
+  }
+
+  /* frequency (and channel 3 operators frequencies) */
+  log_write(port, 0xa4 + c, fmbench_rand(0x40));
+  log_write(port, 0xa0 + c, fmbench_rand(0x100));
+  if (ch == 2)
+  {
+    for (op = 0; op < 3; op++)
+    {
+      log_write(0, 0xac + op, fmbench_rand(0x40));
+      log_write(0, 0xa8 + op, fmbench_rand(0x100));
+    }
+  }
+}
+
+static void build_log(void)
+{
+  int segment, step, ch;
+
+  rand_state = 0x1234;
+
+  for (segment = 0; segment < 96; segment++)
+  {
+    /* LFO */
+    log_write(0, 0x22, fmbench_rand(0x10));
+
+    /* channel 3 mode (normal, special or CSM) with timer A running */
+    log_write(0, 0x24, fmbench_rand(0x100));
+    log_write(0, 0x25, fmbench_rand(4));
+    log_write(0, 0x27, (fmbench_rand(3) << 6) | 0x15);
+
+    /* DAC */
+    log_write(0, 0x2b, fmbench_rand(4) ? 0x00 : 0x80);
+
+    for (ch = 0; ch < 6; ch++)
+    {
+      build_channel(ch);
+
+      /* key on */
+      log_write(0, 0x28, 0xf0 | ((ch / 3) << 2) | (ch % 3));
+    }
+
+    for (step = 0; step < 64; step++)
+    {
+      log_wait(fmbench_rand(200) + 1);
+
+      ch = fmbench_rand(6);
+      switch (fmbench_rand(8))
+      {
+        case 0:  /* key off */
+          log_write(0, 0x28, ((ch / 3) << 2) | (ch % 3));
+          break;
+
+        case 1:  /* key on (random operators) */
+          log_write(0, 0x28, (fmbench_rand(0x10) << 4) | ((ch / 3) << 2) | (ch % 3));
+          break;
+
+        case 2:  /* frequency change */
+          log_write(ch / 3, 0xa4 + (ch % 3), fmbench_rand(0x40));
+          log_write(ch / 3, 0xa0 + (ch % 3), fmbench_rand(0x100));
+          break;
+
+        case 3:  /* total level change */
+          log_write(ch / 3, 0x40 + (fmbench_rand(4) * 4) + (ch % 3), fmbench_rand(0x80));
+          break;
+
+        default:  /* DAC output */
+          log_write(0, 0x2a, fmbench_rand(0x100));
+          break;
+      }
+    }
+
+    /* key off all channels */
+    for (ch = 0; ch < 6; ch++)
+    {
+      log_write(0, 0x28, ((ch / 3) << 2) | (ch % 3));
+    }
+
+    log_wait(fmbench_rand(1000) + 1);
+  }
+}
+
+static uint32 read_le32(const uint8 *p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32)p[3] << 24);
+}
+
+static int load_vgm(const char *log_name)
+{
+  uint8 *data = NULL;
+  uint8 *pcm = NULL;
+  int size = 0;
+  int pcm_size = 0;
+  int pcm_pos = 0;
+  int pos, len;
+  uint32 clock, version;
+  uint64_t vgm_samples = 0;
+  uint64_t ym_samples = 0;
+  gzFile f;
+
+  /* uncompressed (.vgm) or compressed (.vgz) files */
+  f = gzopen(log_name, "rb");
+  if (!f)
+  {
+    fprintf(stderr, "Error opening file `%s'.\n", log_name);
+    return 0;
+  }
+
+  do
+  {
+    uint8 *temp = realloc(data, size + 0x100000);
+    if (!temp)
+    {
+      gzclose(f);
+      free(data);
+      fprintf(stderr, "Error allocating register log.\n");
+      return 0;
+    }
+    data = temp;
+    len = gzread(f, data + size, 0x100000);
+    if (len > 0)
+    {
+      size += len;
+    }
+  }
+  while (len == 0x100000);
+
+  gzclose(f);
+
+  if ((size < 0x40) || memcmp(data, "Vgm ", 4))
+  {
+    free(data);
+    fprintf(stderr, "Invalid VGM file `%s'.\n", log_name);
+    return 0;
+  }
+
+  version = read_le32(data + 0x08);
+  clock = read_le32(data + 0x2c) & 0x3fffffff;
+  if ((version < 0x110) || !clock)
+  {
+    free(data);
+    fprintf(stderr, "No YM2612 data in VGM file `%s'.\n", log_name);
+    return 0;
+  }
+
+  pos = ((version >= 0x150) && read_le32(data + 0x34)) ? (0x34 + read_le32(data + 0x34)) : 0x40;
+
+  while (pos < size)
+  {
+    int wait = 0;
+    uint8 cmd = data[pos];
+
+    if ((cmd == 0x52) || (cmd == 0x53))
+    {
+      if (pos + 3 > size) break;
+      log_write(cmd & 1, data[pos + 1], data[pos + 2]);
+      pos += 3;
+    }
+    else if (cmd == 0x61)
+    {
+      if (pos + 3 > size) break;
+      wait = data[pos + 1] | (data[pos + 2] << 8);
+      pos += 3;
+    }
+    else if (cmd == 0x62)
+    {
+      wait = 735;
+      pos++;
+    }
+    else if (cmd == 0x63)
+    {
+      wait = 882;
+      pos++;
+    }
+    else if (cmd == 0x66)
+    {
+      break;
+    }
+    else if (cmd == 0x67)
+    {
+      /* data block */
+      if (pos + 7 > size) break;
+      len = read_le32(data + pos + 3) & 0x7fffffff;
+      if (pos + 7 + len > size) break;
+      if (data[pos + 2] == 0x00)
+      {
+        /* YM2612 PCM data */
+        uint8 *temp = realloc(pcm, pcm_size + len);
+        if (temp)
+        {
+          pcm = temp;
+          memcpy(pcm + pcm_size, data + pos + 7, len);
+          pcm_size += len;
+        }
+      }
+      pos += 7 + len;
+    }
+    else if ((cmd & 0xf0) == 0x70)
+    {
+      wait = (cmd & 0x0f) + 1;
+      pos++;
+    }
+    else if ((cmd & 0xf0) == 0x80)
+    {
+      /* YM2612 DAC write from PCM data bank */
+      log_write(0, 0x2a, (pcm_pos < pcm_size) ? pcm[pcm_pos] : 0x80);
+      pcm_pos++;
+      wait = cmd & 0x0f;
+      pos++;
+    }
+    else if (cmd == 0xe0)
+    {
+      if (pos + 5 > size) break;
+      pcm_pos = read_le32(data + pos + 1);
+      pos += 5;
+    }
+    else if ((cmd == 0x4f) || (cmd == 0x50) || ((cmd >= 0x30) && (cmd <= 0x3f)) || (cmd == 0x94))
+    {
+      /* other chips (one byte) */
+      pos += 2;
+    }
+    else if (((cmd >= 0x40) && (cmd <= 0x5f)) || ((cmd >= 0xa0) && (cmd <= 0xbf)))
+    {
+      /* other chips (two bytes) */
+      pos += 3;
+    }
+    else if ((cmd >= 0xc0) && (cmd <= 0xdf))
+    {
+      /* other chips (three bytes) */
+      pos += 4;
+    }
+    else if ((cmd >= 0xe1) || (cmd == 0x90) || (cmd == 0x91) || (cmd == 0x95))
+    {
+      /* other chips or DAC stream control (four bytes) */
+      pos += 5;
+    }
+    else if (cmd == 0x92)
+    {
+      pos += 6;
+    }
+    else if (cmd == 0x93)
+    {
+      pos += 11;
+    }
+    else
+    {
+      fprintf(stderr, "Unsupported VGM command %02X at offset %X.\n", cmd, pos);
+      break;
+    }
+
+    if (wait)
+    {
+      /* convert 44.1 kHz VGM samples to YM2612 samples (clock / 144) */
+      uint64_t target;
+      vgm_samples += wait;
+      target = (vgm_samples * clock) / (144 * 44100);
+      log_wait(target - ym_samples);
+      ym_samples = target;
+    }
+  }
+
+  free(pcm);
+  free(data);
+  return 1;
+}
+
+static double render_ym2612(int *buffer, int simd)
+{
+  int i;
+  double start;
+
+  YM2612Init();
+  YM2612Config(YM2612_DISCRETE);
+  YM2612ConfigSIMD(simd);
+  YM2612ResetChip();
+
+  start = headless_time();
+
+  for (i = 0; i < event_count; i++)
+  {
+    uint32 event = events[i];
+    if (event & EVENT_WRITE)
+    {
+      YM2612Write((event >> 8) & 3, event & 0xff);
+    }
+    else
+    {
+      YM2612Update(buffer, event);
+      buffer += event * 2;
+    }
+  }
+
+  return headless_time() - start;
+}
+
+static int bench_ym2612(const char *log_name)
+{
+  int i, loop;
+  int *output[2];
+  double elapsed[2] = {0.0, 0.0};
+  int simd = 0;
+
+  output[0] = malloc((sample_count + 1) * 2 * sizeof(int));
+  output[1] = malloc((sample_count + 1) * 2 * sizeof(int));
+  if (!output[0] || !output[1])
+  {
+    fprintf(stderr, "Error allocating output buffer.\n");
+    free(output[0]);
+    free(output[1]);
+    return 1;
+  }
+
+  for (loop = 0; loop < FMBENCH_LOOPS; loop++)
+  {
+    for (i = 0; i < 2; i++)
+    {
+      double t;
+
+      /* SIMD code path is only rendered if supported */
+      if (i && !YM2612ConfigSIMD(1))
+      {
+        break;
+      }
+
+      simd = i;
+      t = render_ym2612(output[i], i);
+      if (!loop || (t < elapsed[i]))
+      {
+        elapsed[i] = t;
+      }
+    }
+  }
+
+  printf("YM2612: %s, %d writes, %d samples\n", log_name, event_count / 2, sample_count);
+  printf("  C    : %8.2f ms, %7.2f Msamples/s\n", elapsed[0] * 1000.0, sample_count / elapsed[0] / 1000000.0);
+
+  if (simd)
+  {
+    printf("  SIMD : %8.2f ms, %7.2f Msamples/s (%.2fx)\n", elapsed[1] * 1000.0, sample_count / elapsed[1] / 1000000.0, elapsed[0] / elapsed[1]);
+
+    for (i = 0; i < sample_count * 2; i++)
+    {
+      if (output[0][i] != output[1][i])
+      {
+        printf("  output differs from sample %d\n", i / 2);
+        break;
+      }
+    }
+
+    if (i == sample_count * 2)
+    {
+      printf("  output is identical\n");
+    }
+  }
+  else
+  {
+    printf("  SIMD : not supported\n");
+  }
+
+  free(output[0]);
+  free(output[1]);
+
+  return (simd && (i < sample_count * 2)) ? 1 : 0;
+}
+
+#ifdef HAVE_YM3438_CORE
+
+/* chip cycles rendered after each register write (write busy time) */
+#define YM3438_WRITE_CYCLES 32
+
+/* chip cycles rendered per update call */
+#define YM3438_BLOCK_CYCLES 4096
+
+static ym3438_t ym3438;
+static short ym3438_accm[24][2];
+static int ym3438_sample[2];
+static int ym3438_cycles;
+
+/* one chip clock per call (previous YM3438_Update implementation) */
+static void ym3438_update_clock(int *buffer, int length)
+{
+  int i, j;
+  for (i = 0; i < length; i++)
+  {
+    OPN2_Clock(&ym3438, ym3438_accm[ym3438_cycles]);
+    ym3438_cycles = (ym3438_cycles + 1) % 24;
+    if (ym3438_cycles == 0)
+    {
+      ym3438_sample[0] = 0;
+      ym3438_sample[1] = 0;
+      for (j = 0; j < 24; j++)
+      {
+        ym3438_sample[0] += ym3438_accm[j][0];
+        ym3438_sample[1] += ym3438_accm[j][1];
+      }
+    }
+    *buffer++ = ym3438_sample[0] * 11;
+    *buffer++ = ym3438_sample[1] * 11;
+  }
+}
+
+/* chip clocked up to one sample (24 cycles) per call (same as YM3438_Update) */
+static void ym3438_update_batch(int *buffer, int length)
+{
+  int i, j;
+  while (length > 0)
+  {
+    int count = 24 - ym3438_cycles;
+    if (count > length)
+    {
+      count = length;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+      OPN2_Clock(&ym3438, ym3438_accm[ym3438_cycles++]);
+    }
+    length -= count;
+
+    for (i = 1; i < count; i++)
+    {
+      *buffer++ = ym3438_sample[0] * 11;
+      *buffer++ = ym3438_sample[1] * 11;
+    }
+
+    if (ym3438_cycles == 24)
+    {
+      ym3438_cycles = 0;
+      ym3438_sample[0] = 0;
+      ym3438_sample[1] = 0;
+      for (j = 0; j < 24; j++)
+      {
+        ym3438_sample[0] += ym3438_accm[j][0];
+        ym3438_sample[1] += ym3438_accm[j][1];
+      }
+    }
+
+    *buffer++ = ym3438_sample[0] * 11;
+    *buffer++ = ym3438_sample[1] * 11;
+  }
+}
+
+static double ym3438_render(void (*update)(int *buffer, int length), int *buffer, int length, uint32 *hash)
+{
+  int i;
+  double elapsed = 0.0;
+
+  while (length > 0)
+  {
+    int count = (length < YM3438_BLOCK_CYCLES) ? length : YM3438_BLOCK_CYCLES;
+    double start = headless_time();
+    update(buffer, count);
+    elapsed += headless_time() - start;
+
+    /* output checksum */
+    for (i = 0; i < count * 2; i++)
+    {
+      *hash = (*hash * 31) + buffer[i];
+    }
+
+    length -= count;
+  }
+
+  return elapsed;
+}
+
+static double render_ym3438(int batch, uint32 *hash, int *cycles)
+{
+  void (*update)(int *buffer, int length) = batch ? ym3438_update_batch : ym3438_update_clock;
+  int *buffer = malloc(YM3438_BLOCK_CYCLES * 2 * sizeof(int));
+  double elapsed = 0.0;
+  int owed = 0;
+  int i;
+
+  if (!buffer)
+  {
+    fprintf(stderr, "Error allocating output buffer.\n");
+    exit(1);
+  }
+
+  OPN2_SetChipType(ym3438_mode_ym2612);
+  OPN2_Reset(&ym3438);
+  memset(ym3438_accm, 0, sizeof(ym3438_accm));
+  memset(ym3438_sample, 0, sizeof(ym3438_sample));
+  ym3438_cycles = 0;
+
+  *hash = 0;
+  *cycles = 0;
+
+  for (i = 0; i < event_count; i++)
+  {
+    uint32 event = events[i];
+    if (event & EVENT_WRITE)
+    {
+      double start = headless_time();
+      OPN2_Write(&ym3438, (event >> 8) & 3, event & 0xff);
+      elapsed += headless_time() - start;
+
+      /* register writes take time, deducted from next wait */
+      elapsed += ym3438_render(update, buffer, YM3438_WRITE_CYCLES, hash);
+      *cycles += YM3438_WRITE_CYCLES;
+      owed += YM3438_WRITE_CYCLES;
+    }
+    else
+    {
+      int count = (event * 24) - owed;
+      if (count > 0)
+      {
+        elapsed += ym3438_render(update, buffer, count, hash);
+        *cycles += count;
+        owed = 0;
+      }
+      else
+      {
+        owed = -count;
+      }
+    }
+  }
+
+  free(buffer);
+  return elapsed;
+}
+
+static int bench_ym3438(const char *log_name)
+{
+  int i, loop;
+  int cycles = 0;
+  uint32 hash[2] = {0, 0};
+  ym3438_t state;
+  double elapsed[2] = {0.0, 0.0};
+
+  for (loop = 0; loop < FMBENCH_LOOPS; loop++)
+  {
+    for (i = 0; i < 2; i++)
+    {
+      double t = render_ym3438(i, &hash[i], &cycles);
+      if (!loop || (t < elapsed[i]))
+      {
+        elapsed[i] = t;
+      }
+
+      /* final chip state */
+      if (!i)
+      {
+        state = ym3438;
+      }
+    }
+  }
+
+  printf("YM3438: %s, %d writes, %d cycles\n", log_name, event_count / 2, cycles);
+  printf("  clock: %8.2f ms, %7.2f Mcycles/s\n", elapsed[0] * 1000.0, cycles / elapsed[0] / 1000000.0);
+  printf("  batch: %8.2f ms, %7.2f Mcycles/s (%.2fx)\n", elapsed[1] * 1000.0, cycles / elapsed[1] / 1000000.0, elapsed[0] / elapsed[1]);
+
+  if ((hash[0] == hash[1]) && !memcmp(&state, &ym3438, sizeof(state)))
+  {
+    printf("  output and chip state are identical\n");
+    return 0;
+  }
+
+  printf("  %s differs\n", (hash[0] != hash[1]) ? "output" : "chip state");
+  return 1;
+}
+
+#endif
+
+int fmbench_run(const char *log_name)
+{
+  int result;
+
+  if (!strcmp(log_name, "-"))
+  {
+    build_log();
+    log_name = "built-in log";
+  }
+  else if (!load_vgm(log_name))
+  {
+    free(events);
+    return 1;
+  }
+
+  result = bench_ym2612(log_name);
+
+#ifdef HAVE_YM3438_CORE
+  result |= bench_ym3438(log_name);
+#endif
+
+  free(events);
+
+  return result;
+}
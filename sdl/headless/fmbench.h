@@ -0,0 +1,8 @@
+#ifndef _FMBENCH_H_
+#define _FMBENCH_H_
+
+/* FM sound chip benchmark: renders a register log (VGM file or built-in log) with */
+/* each available code path, then compares output and timing.                     */
+extern int fmbench_run(const char *log_name);
+
+#endif /* _FMBENCH_H_ */
@@ -0,0 +1,261 @@
+#include <stdint.h>
+
+#include "shared.h"
+#include "main.h"
+#include "gfxbench.h"
+
+/* number of times each renderer is run (best time is kept) */
+#define GFXBENCH_LOOPS 5
+
+/* number of graphics operations */
+#define GFXBENCH_OPERATIONS 2000
+
+static uint32 rand_state;
+
+static int gfxbench_rand(int range)
+{
+  rand_state = rand_state * 1103515245 + 12345;
+  return ((rand_state >> 16) & 0x7fff) % range;
+}
+
+/* one dot per loop (previous gfx_render implementation) */
+static void gfx_render_dot(uint32 bufferIndex, uint32 width)
+{
+  uint8 pixel_in, pixel_out;
+  uint16 stamp_data;
+  uint32 stamp_index;
+  uint32 stamp_mask = (scd.regs[0x58>>1].byte.l & 0x02) ? 0x7fc : 0x7ff;
+  uint32 xpos = *gfx.tracePtr++ << 8;
+  uint32 ypos = *gfx.tracePtr++ << 8;
+  uint32 xoffset = (int16) *gfx.tracePtr++;
+  uint32 yoffset = (int16) *gfx.tracePtr++;
+
+  while (width--)
+  {
+    if (scd.regs[0x58>>1].byte.l & 0x01)
+    {
+      xpos &= gfx.dotMask;
+      ypos &= gfx.dotMask;
+    }
+    else
+    {
+      xpos &= 0xffffff;
+      ypos &= 0xffffff;
+    }
+
+    if ((xpos | ypos) & ~gfx.dotMask)
+    {
+      pixel_out = 0x00;
+    }
+    else
+    {
+      stamp_data = gfx.mapPtr[(xpos >> gfx.stampShift) | ((ypos >> gfx.stampShift) << gfx.mapShift)];
+      stamp_index = (stamp_data & stamp_mask) << 8;
+
+      if (stamp_index)
+      {
+        stamp_data = (stamp_data >> 13) & 7;
+        stamp_index |= gfx.lut_cell[stamp_data | ((scd.regs[0x58>>1].byte.l & 0x02) << 2 ) | ((ypos >> 8) & 0xc0) | ((xpos >> 10) & 0x30)] << 6;
+        stamp_index |= gfx.lut_pixel[stamp_data | ((xpos >> 8) & 0x38) | ((ypos >> 5) & 0x1c0)];
+        pixel_out = READ_BYTE(scd.word_ram_2M, stamp_index >> 1);
+
+        if (stamp_index & 1)
+        {
+           pixel_out &= 0x0f;
+        }
+        else
+        {
+           pixel_out >>= 4;
+        }
+      }
+      else
+      {
+        pixel_out = 0x00;
+      }
+    }
+
+    pixel_in = READ_BYTE(scd.word_ram_2M, bufferIndex >> 1);
+
+    if (bufferIndex & 1)
+    {
+      pixel_out |= (pixel_in & 0xf0);
+    }
+    else
+    {
+      pixel_out = (pixel_out << 4) | (pixel_in & 0x0f);
+    }
+
+    pixel_out = gfx.lut_prio[(scd.regs[0x02>>1].w >> 3) & 0x03][pixel_in][pixel_out];
+    WRITE_BYTE(scd.word_ram_2M, bufferIndex >> 1, pixel_out);
+
+    if ((bufferIndex & 7) != 7)
+    {
+      bufferIndex++;
+    }
+    else
+    {
+      bufferIndex += gfx.bufferOffset;
+    }
+
+    xpos += xoffset;
+    ypos += yoffset;
+  }
+}
+
+static void init_chip(void)
+{
+  int i;
+
+  rand_state = 1;
+
+  /* Word-RAM: random stamp maps, stamps & trace vectors (with some null pixels & stamps) */
+  for (i = 0; i < sizeof(scd.word_ram_2M); i++)
+  {
+    scd.word_ram_2M[i] = gfxbench_rand(4) ? gfxbench_rand(0x100) : 0x00;
+  }
+
+  /* Word-RAM assigned to SUB-CPU in 2M mode, level 1 interrupt disabled */
+  scd.regs[0x02>>1].w = 0;
+  scd.regs[0x32>>1].w = 0;
+  s68k.stopped = 0;
+}
+
+static void start_operation(void)
+{
+  int i;
+
+  /* stamp map repeat, stamp & stamp map size */
+  scd.regs[0x58>>1].byte.l = gfxbench_rand(8);
+
+  /* stamp map base address */
+  scd.regs[0x5a>>1].w = gfxbench_rand(0x10000) & 0xffe0;
+
+  /* image buffer V cell size, start address & pixel offset (within Word-RAM) */
+  scd.regs[0x5c>>1].byte.l = gfxbench_rand(0x10);
+  scd.regs[0x5e>>1].w = gfxbench_rand(0x4000);
+  scd.regs[0x60>>1].byte.l = gfxbench_rand(0x40);
+
+  /* image buffer H & V dot size */
+  scd.regs[0x62>>1].w = gfxbench_rand(256) + 1;
+  scd.regs[0x64>>1].byte.l = gfxbench_rand(64) + 1;
+
+  /* priority mode */
+  scd.regs[0x02>>1].byte.l = gfxbench_rand(4) << 3;
+
+  /* trace vector base address */
+  gfx_start(gfxbench_rand(0x10000), 0);
+
+  /* trace vectors: rotated & scaled lines starting inside stamp map (some outside) */
+  for (i = 0; i < scd.regs[0x64>>1].byte.l; i++)
+  {
+    int xoffset = gfxbench_rand(0x1000) - 0x800;
+    int yoffset = gfxbench_rand(0x1000) - 0x800;
+    gfx.tracePtr[i * 4 + 0] = gfxbench_rand(gfxbench_rand(16) ? (gfx.dotMask >> 8) : 0x10000);
+    gfx.tracePtr[i * 4 + 1] = gfxbench_rand(gfxbench_rand(16) ? (gfx.dotMask >> 8) : 0x10000);
+    gfx.tracePtr[i * 4 + 2] = xoffset;
+    gfx.tracePtr[i * 4 + 3] = yoffset;
+  }
+}
+
+static void run_dot(void)
+{
+  int lines = scd.regs[0x64>>1].byte.l;
+
+  scd.regs[0x64>>1].byte.l = 0;
+  scd.regs[0x58>>1].byte.h = 0;
+
+  while (lines--)
+  {
+    gfx_render_dot(gfx.bufferStart, scd.regs[0x62>>1].w);
+    gfx.bufferStart += 8;
+  }
+}
+
+static void run_line(void)
+{
+  /* process all lines */
+  gfx_update(gfx.cyclesPerLine * scd.regs[0x64>>1].byte.l);
+}
+
+static double render_gfx(void (*run)(void), uint32 *hash, int *dots)
+{
+  int i;
+  double start, elapsed = 0.0;
+
+  init_chip();
+  *hash = 0;
+  *dots = 0;
+
+  for (i = 0; i < GFXBENCH_OPERATIONS; i++)
+  {
+    start_operation();
+    *dots += scd.regs[0x62>>1].w * scd.regs[0x64>>1].byte.l;
+
+    start = headless_time();
+    run();
+    elapsed += headless_time() - start;
+  }
+
+  /* Word-RAM checksum */
+  for (i = 0; i < sizeof(scd.word_ram_2M); i++)
+  {
+    *hash = (*hash * 31) + scd.word_ram_2M[i];
+  }
+
+  return elapsed;
+}
+
+int gfxbench_run(void)
+{
+  int i, loop, result, dots = 0;
+  uint32 hash[2] = {0, 0};
+  double elapsed[2] = {0.0, 0.0};
+  uint16 regs[2][0x100 / 2];
+
+#ifdef USE_DYNAMIC_ALLOC
+  ext = calloc(1, sizeof(external_t));
+  if (!ext)
+  {
+    fprintf(stderr, "Error allocating graphics chip.\n");
+    return 1;
+  }
+#endif
+
+  gfx_init();
+
+  for (loop = 0; loop < GFXBENCH_LOOPS; loop++)
+  {
+    for (i = 0; i < 2; i++)
+    {
+      double t = render_gfx(i ? run_line : run_dot, &hash[i], &dots);
+      if (!loop || (t < elapsed[i]))
+      {
+        elapsed[i] = t;
+      }
+
+      /* final registers state */
+      memcpy(regs[i], scd.regs, sizeof(regs[i]));
+    }
+  }
+
+  printf("GFX: %d graphics operations, %d dots\n", GFXBENCH_OPERATIONS, dots);
+  printf("  dot   : %8.2f ms, %7.2f Mdots/s\n", elapsed[0] * 1000.0, dots / elapsed[0] / 1000000.0);
+  printf("  group : %8.2f ms, %7.2f Mdots/s (%.2fx)\n", elapsed[1] * 1000.0, dots / elapsed[1] / 1000000.0, elapsed[0] / elapsed[1]);
+
+  if ((hash[0] == hash[1]) && !memcmp(regs[0], regs[1], sizeof(regs[0])))
+  {
+    printf("  Word-RAM and registers are identical\n");
+    result = 0;
+  }
+  else
+  {
+    printf("  %s differs\n", (hash[0] != hash[1]) ? "Word-RAM" : "registers");
+    result = 1;
+  }
+
+#ifdef USE_DYNAMIC_ALLOC
+  free(ext);
+#endif
+
+  return result;
+}
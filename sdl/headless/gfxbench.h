@@ -0,0 +1,9 @@
+#ifndef _GFXBENCH_H_
+#define _GFXBENCH_H_
+
+/* Mega CD graphics chip benchmark: renders random rotation / scaling operations with */
+/* previous (dot by dot) and current (4 dots per Word-RAM access) renderers, then     */
+/* compares Word-RAM output & timing.                                                 */
+extern int gfxbench_run(void);
+
+#endif /* _GFXBENCH_H_ */
@@ -0,0 +1,853 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <time.h>
+
+#include "shared.h"
+#include "sms_ntsc.h"
+#include "md_ntsc.h"
+#include "fmbench.h"
+#include "pcmbench.h"
+#include "gfxbench.h"
+#include "cddbench.h"
+#include "eqbench.h"
+
+#ifdef USE_THREAD_LOCAL_CONTEXT
+#include <pthread.h>
+#endif
+
+#define SOUND_FREQUENCY 48000
+#define SOUND_SAMPLES_SIZE  2048
+
+#define DEFAULT_FRAMES 3600
+#define MAX_INSTANCES 256
+
+/* cached CPU instructions and SUB-CPU thread can be verified against interpreter */
+#if defined(USE_Z80_DECODE_CACHE) || defined(USE_SSP_DECODE_CACHE) || defined(USE_THREADED_SCD)
+#define VERIFY_CPU_CACHE
+#endif
+
+#define MAX_RUNAHEAD 8
+
+int log_error   = 0;
+int debug_on    = 0;
+
+/* video */
+md_ntsc_t *md_ntsc;
+sms_ntsc_t *sms_ntsc;
+
+#if defined(USE_8BPP_RENDERING)
+#define BYTES_PER_PIXEL 1
+#elif defined(USE_15BPP_RENDERING)
+#define BYTES_PER_PIXEL 2
+#elif defined(USE_16BPP_RENDERING)
+#define BYTES_PER_PIXEL 2
+#elif defined(USE_32BPP_RENDERING)
+#define BYTES_PER_PIXEL 4
+#endif
+
+#define VIDEO_BUFFER_SIZE (720 * 576 * BYTES_PER_PIXEL)
+
+/* sound */
+
+static THREAD_LOCAL short soundframe[SOUND_SAMPLES_SIZE * 2];
+
+/* run-ahead and verified frames audio (discarded) */
+static THREAD_LOCAL short runahead_soundframe[SOUND_SAMPLES_SIZE * 2];
+
+static uint8 brm_format[0x40] =
+{
+  0x5f,0x5f,0x5f,0x5f,0x5f,0x5f,0x5f,0x5f,0x5f,0x5f,0x5f,0x00,0x00,0x00,0x00,0x40,
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x53,0x45,0x47,0x41,0x5f,0x43,0x44,0x5f,0x52,0x4f,0x4d,0x00,0x01,0x00,0x00,0x00,
+  0x52,0x41,0x4d,0x5f,0x43,0x41,0x52,0x54,0x52,0x49,0x44,0x47,0x45,0x5f,0x5f,0x5f
+};
+
+/* run parameters, shared by all instances */
+
+static char *rom_name;
+static int frame_count = DEFAULT_FRAMES;
+static int do_skip;
+static int no_sound;
+static int sample_rate = SOUND_FREQUENCY;
+static int rewind_length;
+static int runahead_length;
+#ifdef VERIFY_CPU_CACHE
+static int verify_blocks;
+#endif
+
+/* emulated machine, one per thread when several instances are run concurrently */
+
+typedef struct
+{
+  int frames;
+  int pal;
+  int error;
+  int rewind_frames;
+  int rewind_used;
+  double rewind_time;
+  double runahead_time[3];
+#ifdef USE_PATTERN_STATS
+  t_pattern_stats patterns;
+#endif
+  int verified;
+#ifdef USE_IDLE_LOOP_SKIP
+  int idle_frames;
+  uint32 frame_cycles;
+  uint32 idle_cycles[2];
+#endif
+} t_instance;
+
+#ifdef USE_THREAD_LOCAL_CONTEXT
+/* emulator initialization also (re)builds lookup tables shared by all instances */
+static pthread_mutex_t init_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* capture files (single instance only) */
+
+static FILE *video_file;
+static FILE *audio_file;
+static uint32 audio_bytes;
+
+static void write_le32(uint8 *p, uint32 v)
+{
+  p[0] = v & 0xff;
+  p[1] = (v >> 8) & 0xff;
+  p[2] = (v >> 16) & 0xff;
+  p[3] = (v >> 24) & 0xff;
+}
+
+static void wav_write_header(FILE *f, int rate, uint32 size)
+{
+  uint8 header[44];
+
+  memcpy(header, "RIFF", 4);
+  write_le32(header + 4, 36 + size);
+  memcpy(header + 8, "WAVEfmt ", 8);
+  write_le32(header + 16, 16);
+  header[20] = 1;   /* PCM */
+  header[21] = 0;
+  header[22] = 2;   /* stereo */
+  header[23] = 0;
+  write_le32(header + 24, rate);
+  write_le32(header + 28, rate * 4);
+  header[32] = 4;   /* block align */
+  header[33] = 0;
+  header[34] = 16;  /* bits per sample */
+  header[35] = 0;
+  memcpy(header + 36, "data", 4);
+  write_le32(header + 40, size);
+
+  fseek(f, 0, SEEK_SET);
+  fwrite(header, 44, 1, f);
+}
+
+static int headless_video_width(void)
+{
+  int width = bitmap.viewport.w + 2*bitmap.viewport.x;
+
+  /* NTSC filters output more pixels than rendered */
+  if (config.ntsc)
+  {
+    width = (reg[12] & 1) ? MD_NTSC_OUT_WIDTH(width) : SMS_NTSC_OUT_WIDTH(width);
+  }
+
+  return width;
+}
+
+static void headless_video_capture(void)
+{
+  int line;
+  int width  = headless_video_width();
+  int height = bitmap.viewport.h + 2*bitmap.viewport.y;
+  uint8 *src = bitmap.data;
+
+  /* raw frames at native bitmap depth, viewport size changes are reported on stdout */
+  for (line = 0; line < height; line++)
+  {
+    fwrite(src, width * BYTES_PER_PIXEL, 1, video_file);
+    src += bitmap.pitch;
+  }
+}
+
+static void headless_audio_capture(int size)
+{
+  int i;
+  uint8 out[SOUND_SAMPLES_SIZE * 4];
+
+  /* 16-bit little endian samples */
+  for (i = 0; i < size * 2; i++)
+  {
+    out[i*2]   = soundframe[i] & 0xff;
+    out[i*2+1] = (soundframe[i] >> 8) & 0xff;
+  }
+
+  fwrite(out, size * 4, 1, audio_file);
+  audio_bytes += size * 4;
+}
+
+#ifdef USE_IDLE_LOOP_SKIP
+/* emulated frames, including run-ahead & verified ones */
+static THREAD_LOCAL int idle_frames;
+#endif
+
+static void headless_frame(int do_skip)
+{
+#ifdef USE_IDLE_LOOP_SKIP
+  idle_frames++;
+#endif
+
+  if (system_hw == SYSTEM_MCD)
+  {
+    system_frame_scd(do_skip);
+  }
+  else if ((system_hw & SYSTEM_PBC) == SYSTEM_MD)
+  {
+    system_frame_gen(do_skip);
+  }
+  else
+  {
+    system_frame_sms(do_skip);
+  }
+}
+
+double headless_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+static void headless_format_brm(void)
+{
+  /* internal backup RAM is always formatted but never loaded or saved, so that runs are reproducible */
+  memset(scd.bram, 0x00, 0x200);
+  brm_format[0x10] = brm_format[0x12] = brm_format[0x14] = brm_format[0x16] = 0x00;
+  brm_format[0x11] = brm_format[0x13] = brm_format[0x15] = brm_format[0x17] = (sizeof(scd.bram) / 64) - 3;
+  memcpy(scd.bram + 0x2000 - 0x40, brm_format, 0x40);
+
+  /* cartridge backup RAM */
+  if (scd.cartridge.id)
+  {
+    memset(scd.cartridge.area, 0x00, scd.cartridge.mask + 1);
+    brm_format[0x10] = brm_format[0x12] = brm_format[0x14] = brm_format[0x16] = (((scd.cartridge.mask + 1) / 64) - 3) >> 8;
+    brm_format[0x11] = brm_format[0x13] = brm_format[0x15] = brm_format[0x17] = (((scd.cartridge.mask + 1) / 64) - 3) & 0xff;
+    memcpy(scd.cartridge.area + scd.cartridge.mask + 1 - sizeof(brm_format), brm_format, sizeof(brm_format));
+  }
+}
+
+static void usage(char *name)
+{
+  printf("Genesis Plus GX\\Headless\n");
+  printf("usage: %s [options] gamename\n", name);
+  printf("  -n <frames>  number of frames to emulate (default %d)\n", DEFAULT_FRAMES);
+  printf("  -s           skip video rendering\n");
+  printf("  -k           skip video rendering, sprite collision & overflow status being still updated\n");
+  printf("  -q           disable sound emulation (sound chips state is still updated, audio output is silent)\n");
+  printf("  -r <rate>    audio sample rate (8000-48000, default %d)\n", SOUND_FREQUENCY);
+  printf("  -v <file>    capture raw video frames to file\n");
+  printf("  -a <file>    capture audio to WAV file\n");
+  printf("  -f <filter>  NTSC filter (1 = composite, 2 = S-Video, 3 = RGB, 4 = monochrome)\n");
+  printf("  -l <rate>    LCD ghosting filter decay rate (1-255)\n");
+  printf("  -b <log>     benchmark FM sound chip with VGM register log (- for built-in log)\n");
+  printf("  -p           benchmark Mega CD PCM sound chip\n");
+  printf("  -g           benchmark Mega CD graphics chip\n");
+  printf("  -c <image>   benchmark CD image reads\n");
+  printf("  -u           check & benchmark fixed point 3-band EQ against double precision\n");
+  printf("  -w <frames>  record rewind snapshots of last <frames> frames, then rewind them\n");
+  printf("  -e <frames>  run ahead <frames> frames (1-%d), only last one being rendered\n", MAX_RUNAHEAD);
+#ifdef USE_THREAD_LOCAL_CONTEXT
+  printf("  -t <count>   run <count> independent instances concurrently (1-%d, default 1)\n", MAX_INSTANCES);
+#endif
+#ifdef VERIFY_CPU_CACHE
+  printf("  -x           verify each frame emulated with cached CPU instructions (or SUB-CPU thread) against interpreter\n");
+#endif
+}
+
+int sdl_input_update(void)
+{
+  /* no input device is polled, all controllers remain released */
+  return 1;
+}
+
+static void headless_runahead(t_instance *instance, uint8 *state)
+{
+  int i;
+  int enabled = snd.enabled;
+  double start = headless_time();
+  double saved;
+
+  /* last emulated frame is the actual one, next frames are emulated with current input
+     to get the displayed frame, then actual one is restored by headless_restore */
+  state_snapshot_save(state);
+  saved = headless_time();
+
+  /* audio output of speculative frames is discarded, only sound chips timers are emulated */
+  snd.enabled = 0;
+
+  for (i = 1; i <= runahead_length; i++)
+  {
+    headless_frame((i < runahead_length) ? (do_skip | SKIP_RENDER) : do_skip);
+    audio_update(runahead_soundframe);
+  }
+
+  snd.enabled = enabled;
+
+  instance->runahead_time[0] += saved - start;
+  instance->runahead_time[1] += headless_time() - saved;
+}
+
+static void headless_restore(t_instance *instance, uint8 *state)
+{
+  double start = headless_time();
+
+  state_snapshot_load(state);
+
+  /* viewport changes are reported from displayed frames */
+  bitmap.viewport.changed &= ~1;
+
+  instance->runahead_time[2] += headless_time() - start;
+}
+
+#ifdef VERIFY_CPU_CACHE
+static void headless_verify_save(uint8 *state)
+{
+  /* address error traps hold host stack context (set on each CPU run), which
+     depends on the thread executing each CPU */
+  memset(m68k.aerr_trap, 0, sizeof(m68k.aerr_trap));
+  memset(s68k.aerr_trap, 0, sizeof(s68k.aerr_trap));
+  state_snapshot_save(state);
+}
+
+static void headless_verify_begin(uint8 *state, int size)
+{
+  /* frame is first emulated with cached instructions (and SUB-CPU thread), then actual frame is
+     emulated again from the same state by the interpreter and compared in headless_verify_end */
+  state_snapshot_save(state);
+  z80_decode_cache_enable(1);
+  ssp1601_decode_cache_enable(1);
+  scd_thread_enable(1);
+  headless_frame(do_skip | (runahead_length ? SKIP_RENDER : 0));
+  audio_update(runahead_soundframe);
+  headless_verify_save(state + size);
+  state_snapshot_load(state);
+  z80_decode_cache_enable(0);
+  ssp1601_decode_cache_enable(0);
+  scd_thread_enable(0);
+}
+
+static int headless_verify_end(t_instance *instance, uint8 *state, int size)
+{
+  int i;
+
+  headless_verify_save(state);
+  for (i = 0; i < size; i++)
+  {
+    if (state[i] != state[size + i])
+    {
+      fprintf(stderr, "frame %d: cached instructions (or SUB-CPU thread) and interpreter states differ at offset 0x%x\n", instance->frames, i);
+      return 0;
+    }
+  }
+
+  instance->verified++;
+  return 1;
+}
+#endif
+
+static void *headless_instance(void *arg)
+{
+  int size;
+  t_instance *instance = (t_instance *)arg;
+  uint8 *video_buffer = malloc(VIDEO_BUFFER_SIZE);
+  uint8 *runahead_state = NULL;
+  uint8 *verify_state = NULL;
+#ifdef VERIFY_CPU_CACHE
+  int verify_size = 0;
+#endif
+
+  if (!video_buffer)
+  {
+    instance->error = 1;
+    return NULL;
+  }
+
+#ifdef USE_THREAD_LOCAL_CONTEXT
+  pthread_mutex_lock(&init_mutex);
+#endif
+
+  /* mark all BIOS as unloaded */
+  system_bios = 0;
+  memset(boot_rom, 0xFF, 0x800);
+
+  /* initialize Genesis virtual system */
+  memset(&bitmap, 0, sizeof(t_bitmap));
+  bitmap.width        = 720;
+  bitmap.height       = 576;
+  bitmap.pitch        = (bitmap.width * BYTES_PER_PIXEL);
+  bitmap.data         = video_buffer;
+  bitmap.viewport.changed = 3;
+
+  /* Load game file */
+  if (!load_rom(rom_name))
+  {
+    fprintf(stderr, "Error loading file `%s'.\n", rom_name);
+    instance->error = 1;
+  }
+  else
+  {
+    /* initialize system hardware */
+    audio_init(sample_rate, 0);
+    snd.enabled = !no_sound;
+    system_init();
+
+    /* Mega CD specific */
+    if (system_hw == SYSTEM_MCD)
+    {
+      headless_format_brm();
+    }
+
+    /* reset system hardware */
+    system_reset();
+
+    /* run-ahead snapshot */
+    if (runahead_length)
+    {
+      runahead_state = malloc(state_snapshot_size());
+      if (!runahead_state)
+      {
+        fprintf(stderr, "Error allocating run-ahead state.\n");
+        instance->error = 1;
+      }
+    }
+
+#ifdef VERIFY_CPU_CACHE
+    /* initial and cached frame snapshots */
+    if (verify_blocks)
+    {
+      verify_size = state_snapshot_size();
+      verify_state = malloc(verify_size * 2);
+      if (!verify_state)
+      {
+        fprintf(stderr, "Error allocating verification state.\n");
+        instance->error = 1;
+      }
+      else
+      {
+        /* unused bytes are compared too */
+        memset(verify_state, 0, verify_size * 2);
+      }
+    }
+#endif
+
+    /* rewind buffer */
+    if (rewind_length && (rewind_init(rewind_length, config.rewind_size << 20) < 0))
+    {
+      fprintf(stderr, "Error allocating rewind buffer.\n");
+      instance->error = 1;
+    }
+  }
+
+#ifdef USE_THREAD_LOCAL_CONTEXT
+  pthread_mutex_unlock(&init_mutex);
+#endif
+
+  if (instance->error)
+  {
+    free(video_buffer);
+    free(runahead_state);
+    free(verify_state);
+    return NULL;
+  }
+
+  /* emulation loop */
+  for (instance->frames = 0; instance->frames < frame_count; instance->frames++)
+  {
+#ifdef VERIFY_CPU_CACHE
+    if (verify_blocks)
+    {
+      headless_verify_begin(verify_state, verify_size);
+    }
+#endif
+
+    /* actual frame is not rendered when running ahead */
+    headless_frame(do_skip | (runahead_length ? SKIP_RENDER : 0));
+
+    /* sound chips must run every frame, even when audio is not captured */
+    size = audio_update(soundframe);
+
+#ifdef VERIFY_CPU_CACHE
+    if (verify_blocks && !headless_verify_end(instance, verify_state, verify_size))
+    {
+      instance->error = 1;
+      break;
+    }
+#endif
+
+    if (runahead_length)
+    {
+      headless_runahead(instance, runahead_state);
+    }
+
+    if (bitmap.viewport.changed & 1)
+    {
+      bitmap.viewport.changed &= ~1;
+      if (video_file)
+      {
+        printf("frame %d: %dx%d\n", instance->frames, headless_video_width(), bitmap.viewport.h + 2*bitmap.viewport.y);
+      }
+    }
+
+    if (video_file && !do_skip)
+    {
+      headless_video_capture();
+    }
+
+    if (audio_file)
+    {
+      headless_audio_capture(size);
+    }
+
+    if (runahead_length)
+    {
+      headless_restore(instance, runahead_state);
+    }
+
+    if (rewind_length)
+    {
+      rewind_save();
+    }
+  }
+
+  instance->pal = vdp_pal;
+
+#ifdef USE_PATTERN_STATS
+  /* wait for pending lines before pattern cache statistics are read */
+  render_sync();
+  instance->patterns = pattern_stats;
+#endif
+
+#ifdef USE_IDLE_LOOP_SKIP
+  /* master cycles skipped in main 68k & Z80 idle loops */
+  instance->idle_frames = idle_frames;
+  instance->frame_cycles = lines_per_frame * MCYCLES_PER_LINE;
+  instance->idle_cycles[0] = m68k_loop_skipped;
+  instance->idle_cycles[1] = z80_loop_skipped;
+#endif
+
+  /* rewind all recorded frames */
+  if (rewind_length)
+  {
+    double start = headless_time();
+    instance->rewind_frames = rewind_frames();
+    instance->rewind_used = rewind_used();
+    while (rewind_load());
+    instance->rewind_time = headless_time() - start;
+    rewind_shutdown();
+  }
+
+  audio_shutdown();
+  free(video_buffer);
+  free(runahead_state);
+  free(verify_state);
+
+  return NULL;
+}
+
+int main (int argc, char **argv)
+{
+  int i, frames;
+  int instance_count = 1;
+  char *video_name = NULL;
+  char *audio_name = NULL;
+  int ntsc_filter = 0;
+  int lcd_rate = 0;
+  double start, elapsed, fps;
+  static t_instance instances[MAX_INSTANCES];
+#ifdef USE_THREAD_LOCAL_CONTEXT
+  static pthread_t threads[MAX_INSTANCES];
+#endif
+
+  /* parse command line */
+  for (i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "-n") && (i + 1 < argc))
+    {
+      frame_count = atoi(argv[++i]);
+    }
+    else if (!strcmp(argv[i], "-s"))
+    {
+      do_skip = SKIP_RENDER;
+    }
+    else if (!strcmp(argv[i], "-k"))
+    {
+      do_skip = SKIP_RENDER_STATUS;
+    }
+    else if (!strcmp(argv[i], "-q"))
+    {
+      no_sound = 1;
+    }
+    else if (!strcmp(argv[i], "-r") && (i + 1 < argc))
+    {
+      sample_rate = atoi(argv[++i]);
+    }
+    else if (!strcmp(argv[i], "-v") && (i + 1 < argc))
+    {
+      video_name = argv[++i];
+    }
+    else if (!strcmp(argv[i], "-a") && (i + 1 < argc))
+    {
+      audio_name = argv[++i];
+    }
+    else if (!strcmp(argv[i], "-f") && (i + 1 < argc))
+    {
+      ntsc_filter = atoi(argv[++i]);
+    }
+    else if (!strcmp(argv[i], "-l") && (i + 1 < argc))
+    {
+      lcd_rate = atoi(argv[++i]);
+    }
+    else if (!strcmp(argv[i], "-w") && (i + 1 < argc))
+    {
+      rewind_length = atoi(argv[++i]);
+    }
+    else if (!strcmp(argv[i], "-e") && (i + 1 < argc))
+    {
+      runahead_length = atoi(argv[++i]);
+    }
+    else if (!strcmp(argv[i], "-b") && (i + 1 < argc))
+    {
+      return fmbench_run(argv[++i]);
+    }
+    else if (!strcmp(argv[i], "-p"))
+    {
+      return pcmbench_run();
+    }
+    else if (!strcmp(argv[i], "-g"))
+    {
+      return gfxbench_run();
+    }
+    else if (!strcmp(argv[i], "-c") && (i + 1 < argc))
+    {
+      return cddbench_run(argv[++i]);
+    }
+    else if (!strcmp(argv[i], "-u"))
+    {
+      return eqbench_run();
+    }
+#ifdef USE_THREAD_LOCAL_CONTEXT
+    else if (!strcmp(argv[i], "-t") && (i + 1 < argc))
+    {
+      instance_count = atoi(argv[++i]);
+    }
+#endif
+#ifdef VERIFY_CPU_CACHE
+    else if (!strcmp(argv[i], "-x"))
+    {
+      verify_blocks = 1;
+    }
+#endif
+    else if (argv[i][0] != '-')
+    {
+      rom_name = argv[i];
+    }
+    else
+    {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (!rom_name || (frame_count <= 0) || (sample_rate < 8000) || (sample_rate > 48000) || (ntsc_filter < 0) || (ntsc_filter > 4) || (lcd_rate < 0) || (lcd_rate > 255) || (rewind_length < 0) || (runahead_length < 0) || (runahead_length > MAX_RUNAHEAD))
+  {
+    usage(argv[0]);
+    return 1;
+  }
+
+  /* captured output is only available from a single instance */
+  if ((instance_count < 1) || (instance_count > MAX_INSTANCES) || ((instance_count > 1) && (video_name || audio_name)))
+  {
+    usage(argv[0]);
+    return 1;
+  }
+
+  /* set default config */
+  error_init();
+  set_config_defaults();
+
+  /* video filters */
+  config.lcd = lcd_rate;
+  config.ntsc = ntsc_filter ? 1 : 0;
+  if (config.ntsc)
+  {
+    sms_ntsc = (sms_ntsc_t *)malloc(sizeof(sms_ntsc_t));
+    md_ntsc = (md_ntsc_t *)malloc(sizeof(md_ntsc_t));
+    if (!sms_ntsc || !md_ntsc)
+    {
+      fprintf(stderr, "Error allocating NTSC filter.\n");
+      return 1;
+    }
+
+    switch (ntsc_filter)
+    {
+      case 1:
+        sms_ntsc_init(sms_ntsc, &sms_ntsc_composite);
+        md_ntsc_init(md_ntsc, &md_ntsc_composite);
+        break;
+      case 2:
+        sms_ntsc_init(sms_ntsc, &sms_ntsc_svideo);
+        md_ntsc_init(md_ntsc, &md_ntsc_svideo);
+        break;
+      case 3:
+        sms_ntsc_init(sms_ntsc, &sms_ntsc_rgb);
+        md_ntsc_init(md_ntsc, &md_ntsc_rgb);
+        break;
+      default:
+        sms_ntsc_init(sms_ntsc, &sms_ntsc_monochrome);
+        md_ntsc_init(md_ntsc, &md_ntsc_monochrome);
+        break;
+    }
+  }
+
+  /* open capture files */
+  if (video_name)
+  {
+    video_file = fopen(video_name, "wb");
+    if (!video_file)
+    {
+      fprintf(stderr, "Error opening file `%s'.\n", video_name);
+      return 1;
+    }
+  }
+
+  if (audio_name)
+  {
+    audio_file = fopen(audio_name, "wb");
+    if (!audio_file)
+    {
+      fprintf(stderr, "Error opening file `%s'.\n", audio_name);
+      return 1;
+    }
+
+    /* reserve WAV header, updated once capture is finished */
+    wav_write_header(audio_file, sample_rate, 0);
+    audio_bytes = 0;
+  }
+
+  start = headless_time();
+
+  if (instance_count == 1)
+  {
+    headless_instance(&instances[0]);
+  }
+#ifdef USE_THREAD_LOCAL_CONTEXT
+  else
+  {
+    /* each thread owns a complete emulated machine */
+    for (i = 0; i < instance_count; i++)
+    {
+      if (pthread_create(&threads[i], NULL, headless_instance, &instances[i]))
+      {
+        fprintf(stderr, "Error creating instance %d.\n", i);
+        instance_count = i;
+        break;
+      }
+    }
+
+    for (i = 0; i < instance_count; i++)
+    {
+      pthread_join(threads[i], NULL);
+    }
+  }
+#endif
+
+  elapsed = headless_time() - start;
+
+  /* stop line rendering, SUB-CPU and CD image read-ahead threads */
+  render_shutdown();
+  scd_thread_shutdown();
+  cdd_cache_shutdown();
+
+  /* report emulation speed, summed over all instances */
+  frames = 0;
+  for (i = 0; i < instance_count; i++)
+  {
+    if (instances[i].error)
+    {
+      return 1;
+    }
+    frames += instances[i].frames;
+  }
+
+  fps = (elapsed > 0.0) ? (frames / elapsed) : 0.0;
+  if (instance_count > 1)
+  {
+    printf("%s: %d instances, ", rom_name, instance_count);
+  }
+  else
+  {
+    printf("%s: ", rom_name);
+  }
+  printf("%d frames in %.3f s, %.2f fps (%.2fx realtime)\n", frames, elapsed, fps, fps / (instances[0].pal ? 50.0 : 60.0));
+
+  if (runahead_length)
+  {
+    double *t = instances[0].runahead_time;
+    printf("run-ahead: %.1f us per frame (save %.1f us, %d frames %.1f us, restore %.1f us)\n", (t[0] + t[1] + t[2]) * 1000000.0 / instances[0].frames,
+           t[0] * 1000000.0 / instances[0].frames, runahead_length, t[1] * 1000000.0 / instances[0].frames, t[2] * 1000000.0 / instances[0].frames);
+  }
+
+#ifdef USE_PATTERN_STATS
+  if (instances[0].patterns.drawn)
+  {
+    t_pattern_stats *p = &instances[0].patterns;
+    printf("patterns: %d lines drawn, %d lines decoded per frame (%.1f%%)\n", p->drawn / instances[0].frames, p->decoded / instances[0].frames, p->decoded * 100.0 / p->drawn);
+  }
+#endif
+
+#ifdef USE_IDLE_LOOP_SKIP
+  if (instances[0].idle_frames)
+  {
+    t_instance *p = &instances[0];
+    double frame_cycles = (double)p->frame_cycles * p->idle_frames;
+    printf("idle: %u 68k cycles (%.1f%%), %u Z80 cycles (%.1f%%) skipped per emulated frame\n",
+           p->idle_cycles[0] / p->idle_frames, p->idle_cycles[0] * 100.0 / frame_cycles,
+           p->idle_cycles[1] / p->idle_frames, p->idle_cycles[1] * 100.0 / frame_cycles);
+  }
+#endif
+
+#ifdef USE_CDD_PREFETCH
+  if (cdd_cache_stats.hits + cdd_cache_stats.misses)
+  {
+    t_cdd_cache_stats *c = &cdd_cache_stats;
+    printf("cd read-ahead: %u blocks read ahead, %u hits, %u misses (%.1f%% hit rate), %.3f ms stalled\n",
+           c->prefetched, c->hits, c->misses, c->hits * 100.0 / (c->hits + c->misses), c->stall * 1000.0);
+  }
+#endif
+
+  if (instances[0].verified)
+  {
+    printf("verify: %d frames identical with cached instructions (or SUB-CPU thread) and interpreter\n", instances[0].verified);
+  }
+
+  if (rewind_length && instances[0].rewind_frames)
+  {
+    printf("rewind: %d frames in %d KB (%d bytes per frame), rewound in %.3f s\n", instances[0].rewind_frames, instances[0].rewind_used / 1024, instances[0].rewind_used / instances[0].rewind_frames, instances[0].rewind_time);
+  }
+
+  if (video_file)
+  {
+    fclose(video_file);
+  }
+
+  if (audio_file)
+  {
+    wav_write_header(audio_file, sample_rate, audio_bytes);
+    fclose(audio_file);
+  }
+
+  free(sms_ntsc);
+  free(md_ntsc);
+  error_shutdown();
+
+  return 0;
+}
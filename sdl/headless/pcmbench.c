@@ -0,0 +1,264 @@
+#include <stdint.h>
+
+#include "shared.h"
+#include "main.h"
+#include "pcmbench.h"
+
+/* number of times each renderer is run (best time is kept) */
+#define PCMBENCH_LOOPS 5
+
+/* number of register updates */
+#define PCMBENCH_EVENTS 20000
+
+#define PCM_SCYCLES_RATIO (384 * 4)
+
+#define pcm scd.pcm_hw
+
+static uint32 rand_state;
+
+static int pcmbench_rand(int range)
+{
+  rand_state = rand_state * 1103515245 + 12345;
+  return ((rand_state >> 16) & 0x7fff) % range;
+}
+
+/* one sample of all channels per loop (previous pcm_run implementation) */
+static void pcm_run_sample(unsigned int length)
+{
+  int prev_l = pcm.out[0];
+  int prev_r = pcm.out[1];
+
+  if (pcm.enabled)
+  {
+    int i, j, l, r;
+
+    for (i=0; i<length; i++)
+    {
+      l = r = 0;
+
+      for (j=0; j<8; j++)
+      {
+        if (pcm.status & (1 << j))
+        {
+          short data = pcm.ram[(pcm.chan[j].addr >> 11) & 0xffff];
+
+          if (data == 0xff)
+          {
+            pcm.chan[j].addr = pcm.chan[j].ls.w << 11;
+            data = pcm.ram[pcm.chan[j].ls.w];
+          }
+          else
+          {
+            pcm.chan[j].addr += pcm.chan[j].fd.w;
+          }
+
+          if (data != 0xff)
+          {
+            if (data & 0x80)
+            {
+              data = data & 0x7f;
+            }
+            else
+            {
+              data = -(data & 0x7f);
+            }
+
+            l += ((data * pcm.chan[j].env * (pcm.chan[j].pan & 0x0F)) >> 5);
+            r += ((data * pcm.chan[j].env * (pcm.chan[j].pan >> 4)) >> 5);
+          }
+        }
+      }
+
+      if (l < -32768) l = -32768;
+      else if (l > 32767) l = 32767;
+      if (r < -32768) r = -32768;
+      else if (r > 32767) r = 32767;
+
+      l = (l * config.pcm_volume) / 100;
+      r = (r * config.pcm_volume) / 100;
+
+      blip_add_delta_fast(snd.blips[1], i, l-prev_l, r-prev_r);
+      prev_l = l;
+      prev_r = r;
+    }
+
+    pcm.out[0] = prev_l;
+    pcm.out[1] = prev_r;
+  }
+  else
+  {
+    if (prev_l | prev_r)
+    {
+      blip_add_delta_fast(snd.blips[1], 0, -prev_l, -prev_r);
+      pcm.out[0] = 0;
+      pcm.out[1] = 0;
+    }
+  }
+
+  blip_end_frame(snd.blips[1], length);
+  pcm.cycles += length * PCM_SCYCLES_RATIO;
+}
+
+static void init_chip(void)
+{
+  int i, addr;
+
+  pcm_reset();
+  rand_state = 1;
+
+  /* WAVE RAM: waveforms of random length ending with loop data */
+  for (addr = 0; addr < 0x10000; )
+  {
+    int len = pcmbench_rand(0x800) + 16;
+    for (i = 0; (i < len) && (addr < 0xffff); i++)
+    {
+      pcm.ram[addr++] = pcmbench_rand(0xff);
+    }
+    pcm.ram[addr++] = 0xff;
+  }
+
+  /* a few infinite loops */
+  for (i = 0; i < 4; i++)
+  {
+    addr = pcmbench_rand(0x10000);
+    pcm.ram[addr] = 0xff;
+    pcm.ram[(addr + 1) & 0xffff] = 0xff;
+  }
+
+  /* chip enabled */
+  pcm_write(0x07, 0x80, pcm.cycles);
+}
+
+static void write_event(void)
+{
+  int ch = pcmbench_rand(8);
+
+  /* select channel, keep chip enabled */
+  pcm_write(0x07, 0xc0 | ch, pcm.cycles);
+
+  switch (pcmbench_rand(8))
+  {
+    case 0:
+      pcm_write(0x08, pcmbench_rand(0x100), pcm.cycles);
+      break;
+    case 1:
+      pcm_write(0x06, pcmbench_rand(0x100), pcm.cycles);
+      break;
+    case 2:
+      pcm_write(0x04, pcmbench_rand(0x100), pcm.cycles);
+      pcm_write(0x05, pcmbench_rand(0x100), pcm.cycles);
+      break;
+    case 3:
+      pcm_write(0x01, pcmbench_rand(0x100), pcm.cycles);
+      break;
+    case 4:
+      pcm_write(0x00, pcmbench_rand(0x100), pcm.cycles);
+      break;
+    default:
+      pcm_write(0x02, pcmbench_rand(0x100), pcm.cycles);
+      pcm_write(0x03, pcmbench_rand(0x10), pcm.cycles);
+      break;
+  }
+}
+
+static double render_pcm(void (*run)(unsigned int length), uint32 *hash, int *samples)
+{
+  int i, j, count;
+  short buffer[2048 * 2];
+  double start, elapsed = 0.0;
+
+  init_chip();
+  *hash = 0;
+  *samples = 0;
+
+  for (i = 0; i < PCMBENCH_EVENTS; i++)
+  {
+    write_event();
+
+    /* run chip until next register update */
+    count = pcmbench_rand(1024) + 1;
+    start = headless_time();
+    run(count);
+    elapsed += headless_time() - start;
+    *samples += count;
+
+    /* output checksum */
+    count = blip_read_samples(snd.blips[1], buffer, blip_samples_avail(snd.blips[1]));
+    for (j = 0; j < count * 2; j++)
+    {
+      *hash = (*hash * 31) + buffer[j];
+    }
+  }
+
+  return elapsed;
+}
+
+int pcmbench_run(void)
+{
+  int i, loop, result, samples = 0;
+  uint32 hash[2] = {0, 0};
+  double elapsed[2] = {0.0, 0.0};
+  chan_t state[8];
+
+#ifdef USE_DYNAMIC_ALLOC
+  ext = calloc(1, sizeof(external_t));
+  if (!ext)
+  {
+    fprintf(stderr, "Error allocating PCM chip.\n");
+    return 1;
+  }
+#endif
+
+  /* output resampled at 48 kHz, with PCM volume attenuated */
+  snd.blips[1] = blip_new(48000 / 10);
+  if (!snd.blips[1])
+  {
+    fprintf(stderr, "Error allocating audio buffer.\n");
+    return 1;
+  }
+  pcm_init(SCD_CLOCK, 48000);
+  config.pcm_volume = 90;
+
+  for (loop = 0; loop < PCMBENCH_LOOPS; loop++)
+  {
+    for (i = 0; i < 2; i++)
+    {
+      double t;
+
+      blip_clear(snd.blips[1]);
+      t = render_pcm(i ? pcm_run : pcm_run_sample, &hash[i], &samples);
+      if (!loop || (t < elapsed[i]))
+      {
+        elapsed[i] = t;
+      }
+
+      /* final channels state */
+      if (!i)
+      {
+        memcpy(state, pcm.chan, sizeof(state));
+      }
+    }
+  }
+
+  printf("PCM: %d register updates, %d samples\n", PCMBENCH_EVENTS, samples);
+  printf("  sample: %8.2f ms, %7.2f Msamples/s\n", elapsed[0] * 1000.0, samples / elapsed[0] / 1000000.0);
+  printf("  block : %8.2f ms, %7.2f Msamples/s (%.2fx)\n", elapsed[1] * 1000.0, samples / elapsed[1] / 1000000.0, elapsed[0] / elapsed[1]);
+
+  if ((hash[0] == hash[1]) && !memcmp(state, pcm.chan, sizeof(state)))
+  {
+    printf("  output and chip state are identical\n");
+    result = 0;
+  }
+  else
+  {
+    printf("  %s differs\n", (hash[0] != hash[1]) ? "output" : "chip state");
+    result = 1;
+  }
+
+  blip_delete(snd.blips[1]);
+#ifdef USE_DYNAMIC_ALLOC
+  free(ext);
+#endif
+
+  return result;
+}
@@ -0,0 +1,8 @@
+#ifndef _PCMBENCH_H_
+#define _PCMBENCH_H_
+
+/* Mega CD PCM sound chip benchmark: renders random register updates with previous */
+/* (sample by sample) and current (block) renderers, then compares output & timing. */
+extern int pcmbench_run(void);
+
+#endif /* _PCMBENCH_H_ */
@@ -14,6 +14,7 @@
 #define SOUND_FREQUENCY 48000
 #define SOUND_SAMPLES_SIZE  2048
 
+
 #define VIDEO_WIDTH  320
 #define VIDEO_HEIGHT 240
 
@@ -695,6 +696,7 @@ int main (int argc, char **argv)
 {
   FILE *fp;
   int running = 1;
+  int rewinding;
 
   /* Print help if no game specified */
   if(argc < 2)
@@ -845,6 +847,9 @@ int main (int argc, char **argv)
   /* reset system hardware */
   system_reset();
 
+  /* rewind buffer (disabled by default or if allocation failed) */
+  rewind_init(config.rewind, config.rewind_size << 20);
+
   if(use_sound) SDL_PauseAudio(0);
 
   /* 3 frames = 50 ms (60hz) or 60 ms (50hz) */
@@ -881,9 +886,21 @@ int main (int argc, char **argv)
       }
     }
 
+    /* hold Backspace to rewind */
+    rewinding = SDL_GetKeyState(NULL)[SDLK_BACKSPACE];
+    if (rewinding)
+    {
+      rewind_load();
+    }
+
     sdl_video_update();
     sdl_sound_update(use_sound);
 
+    if (!rewinding)
+    {
+      rewind_save();
+    }
+
     if(!turbo_mode && sdl_sync.sem_sync && sdl_video.frames_rendered % 3 == 0)
     {
       SDL_SemWait(sdl_sync.sem_sync);
@@ -929,6 +946,7 @@ int main (int argc, char **argv)
     }
   }
 
+  rewind_shutdown();
   audio_shutdown();
   error_shutdown();
 
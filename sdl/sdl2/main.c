@@ -8,6 +8,21 @@
 #define SOUND_FREQUENCY 48000
 #define SOUND_SAMPLES_SIZE  2048
 
+/* audio device buffer size (stereo samples) */
+#define SOUND_DEVICE_SAMPLES 1024
+
+/* audio ring buffer size (stereo samples, power of two) and targeted fill level */
+#define SOUND_RING_SIZE     8192
+#define SOUND_RING_LATENCY  4096
+
+/* dynamic rate control: maximal output rate adjustment (0.5%) and fill level deviation at which it is reached */
+#define SOUND_RATE_DELTA 0.005
+#define SOUND_RATE_RANGE 2048
+
+/* emulation is paced by sync timer (3 frames every 50 ms or 60 ms) */
+#define SOUND_FRAME_RATE (vdp_pal ? 50.0 : 60.0)
+
+
 #define VIDEO_WIDTH  320
 #define VIDEO_HEIGHT 240
 
@@ -30,10 +45,12 @@ struct {
 
 /* sound */
 
+/* lock-free single-producer (emulation thread) / single-consumer (audio callback) ring buffer */
 struct {
-  char* current_pos;
-  char* buffer;
-  int current_emulated_samples;
+  short* buffer;
+  SDL_atomic_t read;  /* stereo samples read (only modified by audio callback) */
+  SDL_atomic_t write; /* stereo samples written (only modified by emulation thread) */
+  int playing;        /* audio device started (only modified by emulation thread) */
 } sdl_sound;
 
 
@@ -50,25 +67,34 @@ static short soundframe[SOUND_SAMPLES_SIZE];
 
 static void sdl_sound_callback(void *userdata, Uint8 *stream, int len)
 {
-  if(sdl_sound.current_emulated_samples < len) {
-    memset(stream, 0, len);
-  }
-  else {
-    memcpy(stream, sdl_sound.buffer, len);
-    /* loop to compensate desync */
-    do {
-      sdl_sound.current_emulated_samples -= len;
-    } while(sdl_sound.current_emulated_samples > 2 * len);
-    memcpy(sdl_sound.buffer,
-           sdl_sound.current_pos - sdl_sound.current_emulated_samples,
-           sdl_sound.current_emulated_samples);
-    sdl_sound.current_pos = sdl_sound.buffer + sdl_sound.current_emulated_samples;
+  short *out = (short *)stream;
+  unsigned int samples = len / (2 * sizeof(short));
+  unsigned int read = SDL_AtomicGet(&sdl_sound.read);
+  unsigned int avail = (unsigned int)SDL_AtomicGet(&sdl_sound.write) - read;
+  unsigned int count = (avail < samples) ? avail : samples;
+  unsigned int pos = read & (SOUND_RING_SIZE - 1);
+  unsigned int size = SOUND_RING_SIZE - pos;
+
+  /* samples written by emulation thread are visible once write index has been read */
+  SDL_MemoryBarrierAcquire();
+
+  /* copy available samples (ring buffer may wrap) */
+  if (size > count) size = count;
+  memcpy(out, &sdl_sound.buffer[pos * 2], size * 2 * sizeof(short));
+  memcpy(out + size * 2, sdl_sound.buffer, (count - size) * 2 * sizeof(short));
+
+  /* release read samples to emulation thread (once copied) */
+  SDL_MemoryBarrierRelease();
+  SDL_AtomicSet(&sdl_sound.read, read + count);
+
+  /* buffer underrun: output silence */
+  if (count < samples) {
+    memset(out + count * 2, 0, (samples - count) * 2 * sizeof(short));
   }
 }
 
 static int sdl_sound_init()
 {
-  int n;
   SDL_AudioSpec as_desired;
 
   if(SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
@@ -79,44 +105,71 @@ static int sdl_sound_init()
   as_desired.freq     = SOUND_FREQUENCY;
   as_desired.format   = AUDIO_S16SYS;
   as_desired.channels = 2;
-  as_desired.samples  = SOUND_SAMPLES_SIZE;
+  as_desired.samples  = SOUND_DEVICE_SAMPLES;
   as_desired.callback = sdl_sound_callback;
 
-  if(SDL_OpenAudio(&as_desired, NULL) < 0) {
-    SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", "SDL Audio open failed", sdl_video.window);
+  sdl_sound.buffer = (short*)calloc(SOUND_RING_SIZE * 2, sizeof(short));
+  if(!sdl_sound.buffer) {
+    SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", "Can't allocate audio buffer", sdl_video.window);
     return 0;
   }
+  SDL_AtomicSet(&sdl_sound.read, 0);
+  SDL_AtomicSet(&sdl_sound.write, 0);
 
-  sdl_sound.current_emulated_samples = 0;
-  n = SOUND_SAMPLES_SIZE * 2 * sizeof(short) * 20;
-  sdl_sound.buffer = (char*)malloc(n);
-  if(!sdl_sound.buffer) {
-    SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", "Can't allocate audio buffer", sdl_video.window);
+  if(SDL_OpenAudio(&as_desired, NULL) < 0) {
+    SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", "SDL Audio open failed", sdl_video.window);
     return 0;
   }
-  memset(sdl_sound.buffer, 0, n);
-  sdl_sound.current_pos = sdl_sound.buffer;
+
   return 1;
 }
 
 static void sdl_sound_update(int enabled)
 {
-  int size = audio_update(soundframe) * 2;
+  unsigned int size = audio_update(soundframe);
 
-  if (enabled)
+  if (enabled && sdl_sound.buffer)
   {
-    int i;
-    short *out;
+    int rate;
+    double adjust;
+    unsigned int write = SDL_AtomicGet(&sdl_sound.write);
+    unsigned int fill = write - (unsigned int)SDL_AtomicGet(&sdl_sound.read);
+    unsigned int pos = write & (SOUND_RING_SIZE - 1);
+    unsigned int count;
+
+    /* samples read by audio callback can be overwritten once read index has been read */
+    SDL_MemoryBarrierAcquire();
+
+    /* buffer overrun: newest samples are dropped, emulation never waits for audio device */
+    if (size > (SOUND_RING_SIZE - fill)) size = SOUND_RING_SIZE - fill;
+
+    /* copy samples (ring buffer may wrap) */
+    count = SOUND_RING_SIZE - pos;
+    if (count > size) count = size;
+    memcpy(&sdl_sound.buffer[pos * 2], soundframe, count * 2 * sizeof(short));
+    memcpy(sdl_sound.buffer, &soundframe[count * 2], (size - count) * 2 * sizeof(short));
+
+    /* release written samples to audio callback (once copied) */
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&sdl_sound.write, write + size);
+
+    /* dynamic rate control: output rate is slightly adjusted so that buffer fill level converges toward targeted latency */
+    fill += size;
+    adjust = ((double)SOUND_RING_LATENCY - (double)fill) / SOUND_RATE_RANGE;
+    if (adjust > 1.0) adjust = 1.0;
+    else if (adjust < -1.0) adjust = -1.0;
+    rate = (int)(SOUND_FREQUENCY * (1.0 + SOUND_RATE_DELTA * adjust));
+    if (rate != snd.sample_rate)
+    {
+      audio_set_rate(rate, snd.frame_rate);
+    }
 
-    SDL_LockAudio();
-    out = (short*)sdl_sound.current_pos;
-    for(i = 0; i < size; i++)
+    /* audio playback starts once targeted latency has been buffered (an empty buffer would underrun until rate control catches up) */
+    if (!sdl_sound.playing && (fill >= SOUND_RING_LATENCY))
     {
-      *out++ = soundframe[i];
+      SDL_PauseAudio(0);
+      sdl_sound.playing = 1;
     }
-    sdl_sound.current_pos = (char*)out;
-    sdl_sound.current_emulated_samples += size * sizeof(short);
-    SDL_UnlockAudio();
   }
 }
 
@@ -399,7 +452,7 @@ static int sdl_control_update(SDL_Keycode keystate)
         get_region(0);
 
         /* framerate has changed, reinitialize audio timings */
-        audio_init(snd.sample_rate, 0);
+        audio_init(SOUND_FREQUENCY, SOUND_FRAME_RATE);
 
         /* system with region BIOS should be reinitialized */
         if ((system_hw == SYSTEM_MCD) || ((system_hw & SYSTEM_SMS) && (config.bios & 1)))
@@ -704,6 +757,7 @@ int main (int argc, char **argv)
 {
   FILE *fp;
   int running = 1;
+  int rewinding;
 
   /* Print help if no game specified */
   if(argc < 2)
@@ -786,7 +840,7 @@ int main (int argc, char **argv)
   }
 
   /* initialize system hardware */
-  audio_init(SOUND_FREQUENCY, 0);
+  audio_init(SOUND_FREQUENCY, SOUND_FRAME_RATE);
   system_init();
 
   /* Mega CD specific */
@@ -854,7 +908,8 @@ int main (int argc, char **argv)
   /* reset system hardware */
   system_reset();
 
-  if(use_sound) SDL_PauseAudio(0);
+  /* rewind buffer (disabled by default or if allocation failed) */
+  rewind_init(config.rewind, config.rewind_size << 20);
 
   /* 3 frames = 50 ms (60hz) or 60 ms (50hz) */
   if(sdl_sync.sem_sync)
@@ -890,9 +945,21 @@ int main (int argc, char **argv)
       }
     }
 
+    /* hold Backspace to rewind */
+    rewinding = SDL_GetKeyboardState(NULL)[SDL_SCANCODE_BACKSPACE];
+    if (rewinding)
+    {
+      rewind_load();
+    }
+
     sdl_video_update();
     sdl_sound_update(use_sound);
 
+    if (!rewinding)
+    {
+      rewind_save();
+    }
+
     if(!turbo_mode && sdl_sync.sem_sync && sdl_video.frames_rendered % 3 == 0)
     {
       SDL_SemWait(sdl_sync.sem_sync);
@@ -938,6 +1005,7 @@ int main (int argc, char **argv)
     }
   }
 
+  rewind_shutdown();
   audio_shutdown();
   error_shutdown();
 